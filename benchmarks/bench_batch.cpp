@@ -0,0 +1,81 @@
+#include <error_utils_batch.hpp>
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace error_utils;
+
+// Compares validate_batch() with returning one Result per value, on a column of doubles
+// where one value in a thousand is NaN.
+
+namespace {
+    constexpr std::size_t column_size = 1 << 16;
+
+    std::vector<double> make_column() {
+        std::vector<double> column(column_size);
+        for (std::size_t i = 0; i < column.size(); ++i) {
+            column[i] = i % 1000 == 999 ? std::numeric_limits<double>::quiet_NaN() : static_cast<double>(i);
+        }
+        return column;
+    }
+
+    [[gnu::noinline]] Result<double> check_value(const double value) {
+        if (!std::isfinite(value) || value < 0.0 || value > 1e9) {
+            return make_error<double>(std::errc::result_out_of_range, "Bad value");
+        }
+        return value;
+    }
+} // namespace
+
+static void BM_Validate_PerValueResult(benchmark::State &state) {
+    const auto column = make_column();
+    for (auto _ : state) {
+        std::size_t failures = 0;
+        for (const double value : column) {
+            failures += !check_value(value);
+        }
+        benchmark::DoNotOptimize(failures);
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * column_size));
+}
+
+BENCHMARK(BM_Validate_PerValueResult);
+
+static void BM_Validate_Batch_Range(benchmark::State &state) {
+    const auto column = make_column();
+    for (auto _ : state) {
+        auto check = validate_batch(column, in_range(0.0, 1e9), std::errc::result_out_of_range, "Bad value");
+        benchmark::DoNotOptimize(check);
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * column_size));
+}
+
+BENCHMARK(BM_Validate_Batch_Range);
+
+static void BM_Validate_Batch_Finite(benchmark::State &state) {
+    const auto column = make_column();
+    for (auto _ : state) {
+        auto check = validate_batch(column, is_finite, std::errc::result_out_of_range, "Bad value");
+        benchmark::DoNotOptimize(check);
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * column_size));
+}
+
+BENCHMARK(BM_Validate_Batch_Finite);
+
+static void BM_Validate_Batch_NonNull(benchmark::State &state) {
+    std::vector<const int *> pointers(column_size);
+    const int value = 1;
+    for (std::size_t i = 0; i < pointers.size(); ++i) {
+        pointers[i] = i % 1000 == 999 ? nullptr : &value;
+    }
+    for (auto _ : state) {
+        auto check = validate_batch(pointers, is_non_null, std::errc::invalid_argument, "Null pointer");
+        benchmark::DoNotOptimize(check);
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * column_size));
+}
+
+BENCHMARK(BM_Validate_Batch_NonNull);
@@ -0,0 +1,71 @@
+#include <error_utils_coro.hpp>
+#include <benchmark/benchmark.h>
+
+using namespace error_utils;
+
+// Compares propagating errors through three calls with co_await against the
+// manual `if (!r) return std::unexpected(r.error());` style.
+
+namespace {
+    // An opaque step that the optimizer cannot see through.
+    [[gnu::noinline]] IntResult step(const int value) {
+        int input = value;
+        benchmark::DoNotOptimize(input);
+        if (input < 0) {
+            return make_error<int>(std::errc::invalid_argument, "Negative value");
+        }
+        return input + 1;
+    }
+
+    [[gnu::noinline]] IntResult manual(const int value) {
+        auto a = step(value);
+        if (!a) return std::unexpected(std::move(a).error());
+        auto b = step(*a);
+        if (!b) return std::unexpected(std::move(b).error());
+        auto c = step(*b);
+        if (!c) return std::unexpected(std::move(c).error());
+        return *c;
+    }
+
+    [[gnu::noinline]] IntResult coroutine(const int value) {
+        const int a = co_await step(value);
+        const int b = co_await step(a);
+        co_return co_await step(b);
+    }
+} // namespace
+
+static void BM_Propagate_Manual_Success(benchmark::State &state) {
+    for (auto _ : state) {
+        auto result = manual(1);
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+BENCHMARK(BM_Propagate_Manual_Success);
+
+static void BM_Propagate_Coroutine_Success(benchmark::State &state) {
+    for (auto _ : state) {
+        auto result = coroutine(1);
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+BENCHMARK(BM_Propagate_Coroutine_Success);
+
+static void BM_Propagate_Manual_Failure(benchmark::State &state) {
+    for (auto _ : state) {
+        auto result = manual(-1);
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+BENCHMARK(BM_Propagate_Manual_Failure);
+
+static void BM_Propagate_Coroutine_Failure(benchmark::State &state) {
+    for (auto _ : state) {
+        auto result = coroutine(-1);
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+BENCHMARK(BM_Propagate_Coroutine_Failure);
@@ -0,0 +1,43 @@
+#include <error_utils_diagnostics.hpp>
+#include <benchmark/benchmark.h>
+
+#include <format>
+#include <string>
+
+using namespace error_utils;
+
+// Compares an error storm through a RateLimitedLog, where repeats are only counted, with
+// formatting every error, and measures recording errors in a FlightRecorder.
+
+namespace {
+    const std::error_code connection_reset = std::make_error_code(std::errc::connection_reset);
+} // namespace
+
+static void BM_Storm_FormatEach(benchmark::State &state) {
+    std::string line;
+    for (auto _ : state) {
+        line.clear();
+        std::format_to(std::back_inserter(line), "{}\n", Error{detail::unobserved, connection_reset, "Peer"});
+        benchmark::DoNotOptimize(line.data());
+    }
+}
+
+BENCHMARK(BM_Storm_FormatEach);
+
+static void BM_Storm_RateLimitedLog(benchmark::State &state) {
+    RateLimitedLog log{[](const std::string_view line) { benchmark::DoNotOptimize(line.data()); }};
+    for (auto _ : state) {
+        log.log(connection_reset, "Peer");
+    }
+}
+
+BENCHMARK(BM_Storm_RateLimitedLog);
+
+static void BM_FlightRecorder_Record(benchmark::State &state) {
+    static FlightRecorder recorder;
+    for (auto _ : state) {
+        recorder.record(connection_reset, "Peer");
+    }
+}
+
+BENCHMARK(BM_FlightRecorder_Record)->ThreadRange(1, 4);
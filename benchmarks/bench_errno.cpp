@@ -0,0 +1,97 @@
+#include <error_utils.hpp>
+#include <benchmark/benchmark.h>
+
+using namespace error_utils;
+
+// Compares the errno handling modes of the errno-based wrappers on the success path,
+// where the wrapped call neither fails nor touches errno.
+
+namespace {
+    // An opaque call that the optimizer cannot see through.
+    int succeed() noexcept {
+        int value = 42;
+        benchmark::DoNotOptimize(value);
+        return value;
+    }
+
+    int fail() noexcept {
+        errno = EINVAL;
+        int value = -1;
+        benchmark::DoNotOptimize(value);
+        return value;
+    }
+} // namespace
+
+static void BM_WithErrno_Reset(benchmark::State &state) {
+    for (auto _ : state) {
+        auto result = with_errno([] { return succeed(); });
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+BENCHMARK(BM_WithErrno_Reset);
+
+static void BM_WithErrno_Preserve(benchmark::State &state) {
+    for (auto _ : state) {
+        auto result = with_errno<ErrnoMode::preserve>([] { return succeed(); });
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+BENCHMARK(BM_WithErrno_Preserve);
+
+static void BM_WithErrnoIf(benchmark::State &state) {
+    for (auto _ : state) {
+        auto result = with_errno_if([] { return succeed(); }, [](const int r) { return r == -1; });
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+BENCHMARK(BM_WithErrnoIf);
+
+static void BM_InvokeWithSyscallApi_Reset(benchmark::State &state) {
+    for (auto _ : state) {
+        auto result = invoke_with_syscall_api([] noexcept { return succeed(); });
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+BENCHMARK(BM_InvokeWithSyscallApi_Reset);
+
+static void BM_InvokeWithSyscallApi_Preserve(benchmark::State &state) {
+    for (auto _ : state) {
+        auto result = invoke_with_syscall_api<ErrnoMode::preserve>([] noexcept { return succeed(); });
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+BENCHMARK(BM_InvokeWithSyscallApi_Preserve);
+
+static void BM_InvokeWithSyscallApi_OnFailure(benchmark::State &state) {
+    for (auto _ : state) {
+        auto result = invoke_with_syscall_api<ErrnoMode::on_failure>([] noexcept { return succeed(); });
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+BENCHMARK(BM_InvokeWithSyscallApi_OnFailure);
+
+// The failure path is dominated by constructing the Error, whatever the mode.
+
+static void BM_InvokeWithSyscallApi_Reset_Failure(benchmark::State &state) {
+    for (auto _ : state) {
+        auto result = invoke_with_syscall_api([] noexcept { return fail(); }, "bench");
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+BENCHMARK(BM_InvokeWithSyscallApi_Reset_Failure);
+
+static void BM_InvokeWithSyscallApi_OnFailure_Failure(benchmark::State &state) {
+    for (auto _ : state) {
+        auto result = invoke_with_syscall_api<ErrnoMode::on_failure>([] noexcept { return fail(); }, "bench");
+        benchmark::DoNotOptimize(result);
+    }
+}
+
+BENCHMARK(BM_InvokeWithSyscallApi_OnFailure_Failure);
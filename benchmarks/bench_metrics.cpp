@@ -0,0 +1,65 @@
+#include <error_utils_metrics.hpp>
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+using namespace error_utils;
+
+// Compares counting errors in per-thread shards with one shared atomic counter per code.
+
+namespace {
+    ErrorCounters counters;
+    std::atomic<std::uint64_t> shared_count{};
+
+    const std::error_code io_error = std::make_error_code(std::errc::io_error);
+} // namespace
+
+static void BM_Count_SharedAtomic(benchmark::State &state) {
+    for (auto _ : state) {
+        shared_count.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+BENCHMARK(BM_Count_SharedAtomic)->ThreadRange(1, 8);
+
+static void BM_Count_ErrorCounters(benchmark::State &state) {
+    for (auto _ : state) {
+        counters.record(io_error);
+    }
+}
+
+BENCHMARK(BM_Count_ErrorCounters)->ThreadRange(1, 8);
+
+// Compares aggregating distinct errors in an ErrorTable with a mutex-guarded unordered_map.
+
+namespace {
+    ErrorTable table;
+    std::mutex map_mutex;
+    std::unordered_map<Error, std::uint64_t, ErrorContextHash, ErrorContextEqual> map;
+
+    const std::array<std::string_view, 4> contexts{"Peer A", "Peer B", "Peer C", "Peer D"};
+} // namespace
+
+static void BM_Aggregate_LockedMap(benchmark::State &state) {
+    std::size_t i = 0;
+    for (auto _ : state) {
+        const Error error{detail::unobserved, io_error, contexts[i++ % contexts.size()]};
+        std::scoped_lock lock{map_mutex};
+        ++map[error];
+    }
+}
+
+BENCHMARK(BM_Aggregate_LockedMap)->ThreadRange(1, 8);
+
+static void BM_Aggregate_ErrorTable(benchmark::State &state) {
+    std::size_t i = 0;
+    for (auto _ : state) {
+        table.record(io_error, contexts[i++ % contexts.size()]);
+    }
+}
+
+BENCHMARK(BM_Aggregate_ErrorTable)->ThreadRange(1, 8);
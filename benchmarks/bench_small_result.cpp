@@ -0,0 +1,55 @@
+#include <error_utils.hpp>
+#include <benchmark/benchmark.h>
+
+using namespace error_utils;
+
+// Compares a tight loop over a function returning IntResult with the same loop
+// over SmallResult<int>, which is returned in registers and keeps only the error code.
+
+namespace {
+    template <typename R>
+    [[gnu::noinline]] R checked_increment(const int value) {
+        if (value < 0) [[unlikely]] {
+            if constexpr (std::is_same_v<R, IntResult>) {
+                return make_error<int>(std::errc::invalid_argument, "Negative value");
+            } else {
+                return std::unexpected(std::errc::invalid_argument);
+            }
+        }
+        return value + 1;
+    }
+
+    template <typename R>
+    void sum_results(benchmark::State &state, const int sign) {
+        for (auto _ : state) {
+            long sum = 0;
+            int failures = 0;
+            for (int i = 0; i < 1024; ++i) {
+                if (const R result = checked_increment<R>(sign * i); result) {
+                    sum += *result;
+                } else {
+                    ++failures;
+                }
+            }
+            benchmark::DoNotOptimize(sum);
+            benchmark::DoNotOptimize(failures);
+        }
+        state.SetItemsProcessed(state.iterations() * 1024);
+    }
+} // namespace
+
+static void BM_Loop_IntResult_Success(benchmark::State &state) { sum_results<IntResult>(state, 1); }
+
+BENCHMARK(BM_Loop_IntResult_Success);
+
+static void BM_Loop_SmallResult_Success(benchmark::State &state) { sum_results<SmallResult<int>>(state, 1); }
+
+BENCHMARK(BM_Loop_SmallResult_Success);
+
+static void BM_Loop_IntResult_Failure(benchmark::State &state) { sum_results<IntResult>(state, -1); }
+
+BENCHMARK(BM_Loop_IntResult_Failure);
+
+static void BM_Loop_SmallResult_Failure(benchmark::State &state) { sum_results<SmallResult<int>>(state, -1); }
+
+BENCHMARK(BM_Loop_SmallResult_Failure);
@@ -0,0 +1,62 @@
+#include <error_utils.hpp>
+#include <benchmark/benchmark.h>
+
+using namespace error_utils;
+
+// Compares a tight loop over a function returning VoidResult with the same loop
+// over Status, for failures with a bare code and with a context.
+
+namespace {
+    template <typename R, bool Context>
+    [[gnu::noinline]] R check(const int value) {
+        if (value < 0) [[unlikely]] {
+            constexpr std::string_view context = Context ? "Negative value in a long context" : "";
+            if constexpr (std::is_same_v<R, Status>) {
+                return Status{std::errc::invalid_argument, context};
+            } else {
+                return make_error<void>(std::errc::invalid_argument, context);
+            }
+        }
+        return {};
+    }
+
+    template <typename R, bool Context = false>
+    void count_failures(benchmark::State &state, const int sign) {
+        for (auto _ : state) {
+            int failures = 0;
+            for (int i = 0; i < 1024; ++i) {
+                if (const R result = check<R, Context>(sign * i); !result) {
+                    ++failures;
+                }
+            }
+            benchmark::DoNotOptimize(failures);
+        }
+        state.SetItemsProcessed(state.iterations() * 1024);
+    }
+} // namespace
+
+static void BM_Check_VoidResult_Success(benchmark::State &state) { count_failures<VoidResult>(state, 1); }
+
+BENCHMARK(BM_Check_VoidResult_Success);
+
+static void BM_Check_Status_Success(benchmark::State &state) { count_failures<Status>(state, 1); }
+
+BENCHMARK(BM_Check_Status_Success);
+
+static void BM_Check_VoidResult_Failure(benchmark::State &state) { count_failures<VoidResult>(state, -1); }
+
+BENCHMARK(BM_Check_VoidResult_Failure);
+
+static void BM_Check_Status_Failure(benchmark::State &state) { count_failures<Status>(state, -1); }
+
+BENCHMARK(BM_Check_Status_Failure);
+
+static void BM_Check_VoidResult_FailureWithContext(benchmark::State &state) {
+    count_failures<VoidResult, true>(state, -1);
+}
+
+BENCHMARK(BM_Check_VoidResult_FailureWithContext);
+
+static void BM_Check_Status_FailureWithContext(benchmark::State &state) { count_failures<Status, true>(state, -1); }
+
+BENCHMARK(BM_Check_Status_FailureWithContext);
@@ -1,4 +1,6 @@
 #include <error_utils.hpp>
+#include <error_utils_io.hpp>
+#include <algorithm>
 #include <fcntl.h>
 #include <fstream>
 #include <iostream>
@@ -8,12 +10,8 @@
 
 // Example: Wrapper for C file API
 StringResult read_file_c_api(const std::string &filename) {
-    // Open a file using C API
-    errno = 0;
-    const int fd = open(filename.c_str(), O_RDONLY);
-    if (fd == -1) {
-        return error_utils::make_error_from_errno<std::string>(std::format("Opening '{}'", filename));
-    }
+    // Open a file using C API. The descriptor is closed on every return path.
+    CEU_TRY_ASSIGN(const auto fd, error_utils::open_fd(filename, O_RDONLY | O_CLOEXEC));
 
     // Read file content
     std::string content;
@@ -22,7 +20,7 @@ StringResult read_file_c_api(const std::string &filename) {
 
     while (true) {
         errno = 0;
-        bytes_read = read(fd, buffer, sizeof(buffer));
+        bytes_read = read(fd.get(), buffer, sizeof(buffer));
 
         if (bytes_read == 0) {
             // End of the file
@@ -30,15 +28,12 @@ StringResult read_file_c_api(const std::string &filename) {
         }
         if (bytes_read == -1) {
             // Error occurred
-            const auto err = error_utils::last_error();
-            close(fd);
-            return error_utils::make_error<std::string>(err, std::format("Reading '{}'", filename));
+            return error_utils::make_error_from_errno<std::string>(std::format("Reading '{}'", filename));
         }
 
         content.append(buffer, bytes_read);
     }
 
-    close(fd);
     return content;
 }
 
@@ -65,6 +60,14 @@ StringResult read_file_cpp_api(const std::string &filename) {
     return content;
 }
 
+// Example: Memory-mapped file access without copying the contents
+Result<std::size_t> count_lines_mmap(const std::string &filename) {
+    return error_utils::MappedFile::open(filename, error_utils::MapAdvice::sequential)
+            .transform([](const error_utils::MappedFile &file) {
+                return static_cast<std::size_t>(std::ranges::count(file.bytes(), std::byte{'\n'}));
+            });
+}
+
 // Example: Custom error checking logic
 IntResult parse_positive_number(const std::string &str) {
     try {
@@ -99,15 +102,9 @@ IntResult parse_number(const std::string &str) {
     }, std::format("Failed to parse '{}'", str));
 }
 
-// Example: Chaining error calls
+// Example: Chaining error calls. CEU_TRY() yields the value, or returns the error to the caller.
 Result<int> get_file_size(const std::string &filename) {
-    auto content_result = read_file_cpp_api(filename);
-    if (!content_result) {
-        // Forward the error
-        return std::unexpected(content_result.error());
-    }
-
-    return static_cast<int>(content_result.value().size());
+    return static_cast<int>(CEU_TRY(read_file_cpp_api(filename)).size());
 }
 
 // Example of a function that returns a void or an error
@@ -136,15 +133,10 @@ IntResult create_directory_alt(const std::string &path) {
 
 // Example of chaining expected results
 Result<std::vector<int>> read_numbers_from_file(const std::string &filename) {
-    // Read the file
-    auto content_result = read_file_cpp_api(filename);
-    if (!content_result) {
-        // Forward the error
-        return std::unexpected(content_result.error());
-    }
+    // Read the file, forwarding the error if it fails
+    CEU_TRY_ASSIGN(std::string content, read_file_cpp_api(filename));
 
     // Split content into lines
-    std::string content = content_result.value();
     std::vector<std::string> lines;
     size_t pos = 0;
     while ((pos = content.find('\n')) != std::string::npos) {
@@ -154,20 +146,17 @@ Result<std::vector<int>> read_numbers_from_file(const std::string &filename) {
         content.erase(0, pos + 1);
     }
 
-    // Parse each line as an integer
-    std::vector<int> numbers;
-    for (const auto &line : lines) {
+    // Parse each line as an integer, stopping at the first invalid one
+    return error_utils::collect(lines | std::views::transform([](const std::string &line) -> IntResult {
         auto num_result = parse_number(line);
         if (!num_result) {
-            return error_utils::make_error<std::vector<int>>(
+            return error_utils::make_error<int>(
                 num_result.error().error_code(),
                 std::format("Line '{}': {}", line, num_result.error().message())
             );
         }
-        numbers.push_back(num_result.value());
-    }
-
-    return numbers;
+        return num_result;
+    }));
 }
 
 // Example functions that might throw exceptions
@@ -263,13 +252,14 @@ std::error_code allocate_large_buffer(const size_t size) {
     }
 }
 
-// Using first_of to try multiple alternatives
+// Using first_of to try multiple alternatives.
+// The alternatives are evaluated lazily: later locations are read only if the earlier ones fail.
 StringResult read_config_file() {
-    return error_utils::first_of({
-        read_file_c_api("config.ini"),
-        read_file_c_api("/etc/myapp/config.ini"),
-        read_file_c_api("/usr/local/etc/myapp/config.ini")
-    });
+    return error_utils::first_of(
+        [] { return read_file_c_api("config.ini"); },
+        [] { return read_file_c_api("/etc/myapp/config.ini"); },
+        [] { return read_file_c_api("/usr/local/etc/myapp/config.ini"); }
+    );
 }
 
 // Using is_any_of to check multiple error conditions
@@ -393,5 +383,13 @@ int main() {
         std::println("Failed to load config: {}", config_result.error().message());
     }
 
+    // Example 11: Memory-mapped file access
+    std::println("\n=== Example 11: Memory-mapped file access ===");
+    if (auto lines = count_lines_mmap("/etc/passwd")) {
+        std::println("Line count: {}.", lines.value());
+    } else {
+        std::println("Error: {}.", lines.error().message());
+    }
+
     return 0;
 }
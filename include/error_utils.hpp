@@ -41,20 +41,39 @@
 #define CPP_ERROR_UTILS_VERSION_PATCH 0
 
 /// \cond
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cerrno>
+#include <cstddef>
+#include <cstdint>
 #include <chrono>
 #include <concepts>
 #include <expected>
 #include <format>
 #include <functional>
 #include <future>
+#include <initializer_list>
+#include <memory>
+#include <ranges>
 #include <regex>
+#include <source_location>
+#include <span>
 #include <string>
 #include <string_view>
 #include <system_error>
 #include <utility>
+#include <vector>
 /// \endcond
 
+/// Marks a class as trivially relocatable for the purposes of calls, so that it is passed
+/// and returned in registers. Expands to nothing on compilers without the attribute.
+#if defined(__has_cpp_attribute) && __has_cpp_attribute(clang::trivial_abi)
+#define CPP_ERROR_UTILS_TRIVIAL_ABI [[clang::trivial_abi]]
+#else
+#define CPP_ERROR_UTILS_TRIVIAL_ABI
+#endif
+
 
 // ///////////////////////// Error Codes, Conditions, and Categories ///////////////////////
 
@@ -328,6 +347,120 @@ namespace error_utils {
             std::is_same_v<T, std::error_condition> || directly_convertible_to_error_condition<T>;
     } // namespace detail
 
+    /// An observer of the creation of errors, installed with \p set_error_observer().
+    ///
+    /// It sees every \p Error created with a non-zero code, whether directly or through
+    /// \p make_error(), \p make_error_from_errno(), \p try_catch() or the \p errno wrappers,
+    /// at the location of their caller. Copies and moves of an \p Error, and the errors
+    /// recreated from a \p SmallResult, a \p Status or an \p AggregateError, are not reported.
+    ///
+    /// Define \p CPP_ERROR_UTILS_NO_ERROR_OBSERVER to compile the notification out. Otherwise,
+    /// creating an error without an observer costs one relaxed load and a branch.
+    class ErrorObserver {
+    public:
+        virtual ~ErrorObserver() = default;
+
+        /// Called on the thread creating the error, before the constructor returns.
+        /// \param code The error code, never zero
+        /// \param context The context of the error, valid only for the duration of the call
+        /// \param location Where the error was created
+        virtual void on_error(const std::error_code &code, std::string_view context,
+                              const std::source_location &location) noexcept = 0;
+    };
+
+    namespace detail {
+        inline std::atomic<ErrorObserver *> error_observer{};
+
+        [[gnu::cold, gnu::noinline]] inline void notify_error_observer(const std::error_code &code,
+                                                                       const std::string_view context,
+                                                                       const std::source_location &location) noexcept {
+            if (ErrorObserver *observer = error_observer.load(std::memory_order_acquire)) {
+                observer->on_error(code, context, location);
+            }
+        }
+
+        /// Tag for the constructors of \p Error that do not notify the \p ErrorObserver.
+        struct unobserved_t {
+            explicit unobserved_t() = default;
+        };
+
+        inline constexpr unobserved_t unobserved{};
+    } // namespace detail
+
+    /// Install the observer of the creation of errors.
+    ///
+    /// The observer must stay alive until it is replaced, and until the calls made to it
+    /// by other threads have returned. To install several observers, install a
+    /// \p CompositeObserver holding them.
+    /// \param observer The new observer, or null to remove it
+    /// \return The previous observer, or null
+    inline ErrorObserver *set_error_observer(ErrorObserver *observer) noexcept {
+        return detail::error_observer.exchange(observer, std::memory_order_acq_rel);
+    }
+
+    /// An \p ErrorObserver forwarding every error to up to \p capacity other observers, so that
+    /// several of them, such as a counter and a log, can be installed at once.
+    ///
+    /// Observers can be added and removed while errors are reported. As with
+    /// \p set_error_observer(), a removed observer must stay alive until the calls made to it
+    /// by other threads have returned.
+    class CompositeObserver final : public ErrorObserver {
+    public:
+        static constexpr std::size_t capacity = 8; ///< The maximum number of observers
+
+    private:
+        std::array<std::atomic<ErrorObserver *>, capacity> observers_{};
+
+    public:
+        CompositeObserver() = default;
+
+        /// Create a composite observer of \p observers.
+        /// \param observers At most \p capacity observers
+        CompositeObserver(std::initializer_list<ErrorObserver *> observers) noexcept {
+            for (ErrorObserver *observer : observers) {
+                (void) add(observer);
+            }
+        }
+
+        CompositeObserver(const CompositeObserver &) = delete;
+
+        CompositeObserver &operator=(const CompositeObserver &) = delete;
+
+        /// Add an observer.
+        /// \param observer The observer to add, not null
+        /// \return False if there are already \p capacity observers
+        [[nodiscard]] bool add(ErrorObserver *observer) noexcept {
+            for (auto &slot : observers_) {
+                ErrorObserver *expected = nullptr;
+                if (slot.compare_exchange_strong(expected, observer, std::memory_order_acq_rel)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /// Remove an observer.
+        /// \return False if \p observer was not added
+        bool remove(ErrorObserver *observer) noexcept {
+            for (auto &slot : observers_) {
+                ErrorObserver *expected = observer;
+                if (slot.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void on_error(const std::error_code &code, const std::string_view context,
+                      const std::source_location &location) noexcept override {
+            for (auto &slot : observers_) {
+                if (ErrorObserver *observer = slot.load(std::memory_order_acquire)) {
+                    observer->on_error(code, context, location);
+                }
+            }
+        }
+    };
+
     /// A wrapper class for system error codes with additional context.
     class Error {
         // clang-format off
@@ -339,20 +472,43 @@ namespace error_utils {
         // clang-format on
         // @formatter:on
 
+        /// Report the new error to the \p ErrorObserver, if there is one.
+        constexpr void notify([[maybe_unused]] const std::source_location &location) const noexcept {
+#if !defined(CPP_ERROR_UTILS_NO_ERROR_OBSERVER)
+            if !consteval {
+                if (detail::error_observer.load(std::memory_order_relaxed) != nullptr) [[unlikely]] {
+                    if (error_code_) {
+                        detail::notify_error_observer(error_code_, context_, location);
+                    }
+                }
+            }
+#endif
+        }
+
     public:
         constexpr Error() noexcept = default;
 
         /// Create an error with the specified error code and optional context.
         /// \param code The system error code
         /// \param context Additional context information about the error
-        constexpr explicit Error(const std::error_code &code, const std::string_view context = {})
-            : context_{context}, error_code_{code} {}
+        /// \param location Where the error is created, for the \p ErrorObserver
+        constexpr explicit Error(const std::error_code &code, const std::string_view context = {},
+                                 const std::source_location &location = std::source_location::current())
+            : context_{context}, error_code_{code} { notify(location); }
 
         /// Create an error with a type convertible to \p std::error_code and optional context.
         /// \param code The error code
         /// \param context Additional context information about the error
-        constexpr explicit Error(const detail::convertible_to_error_code auto code, const std::string_view context = {})
-            : context_{context}, error_code_{make_error_code(code)} {}
+        /// \param location Where the error is created, for the \p ErrorObserver
+        constexpr explicit Error(const detail::convertible_to_error_code auto code, const std::string_view context = {},
+                                 const std::source_location &location = std::source_location::current())
+            : context_{context}, error_code_{make_error_code(code)} { notify(location); }
+
+        /// Recreate an error that was already reported, without notifying the \p ErrorObserver.
+        /// \param code The system error code
+        /// \param context Additional context information about the error
+        constexpr Error(detail::unobserved_t, const std::error_code &code, const std::string_view context = {})
+            : context_{context}, error_code_{code} {}
 
         constexpr Error(const Error &other) noexcept = default;
 
@@ -499,42 +655,51 @@ namespace error_utils {
     /// \param context Optional context information
     /// \tparam T The type of the result
     /// \tparam E The type of the error code
+    /// \param location Where the error is created, for the \p ErrorObserver
     /// \tparam Ctx The type of the context information
     /// \return An unexpected result with the error.
     template <typename T, typename E, typename Ctx = std::string_view>
         requires detail::convertible_to_error_code<E>
-    [[nodiscard]] constexpr Result<T> make_error(E &&code, Ctx &&context = {}) {
-        return std::unexpected(Error{std::forward<E>(code), std::forward<Ctx>(context)});
+    [[nodiscard]] constexpr Result<T> make_error(E &&code, Ctx &&context = {},
+                                                 const std::source_location &location =
+                                                     std::source_location::current()) {
+        return std::unexpected(Error{std::forward<E>(code), std::forward<Ctx>(context), location});
     }
 
     /// Create an error result of the specified type from a \p std::error_code.
     /// \param code The std::error_code error code
     /// \param context Optional context information
+    /// \param location Where the error is created, for the \p ErrorObserver
     /// \tparam T The type of the result
     /// \return An unexpected result with the error.
     template <typename T>
-    [[nodiscard]] constexpr Result<T> make_error(const std::error_code &code, const std::string_view context = {}) {
-        return std::unexpected(Error{code, context});
+    [[nodiscard]] constexpr Result<T> make_error(const std::error_code &code, const std::string_view context = {},
+                                                 const std::source_location &location =
+                                                     std::source_location::current()) {
+        return std::unexpected(Error{code, context, location});
     }
 
     /// Create an error result of the specified type from a \p std::regex_constants::error_type.
     /// \param code The regex error code
     /// \param context Optional context information
+    /// \param location Where the error is created, for the \p ErrorObserver
     /// \tparam T The type of the result
     /// \return An unexpected result with the regex error.
     template <typename T>
     [[nodiscard]] constexpr Result<T> make_error(const std::regex_constants::error_type code,
-                                                 std::string_view context = {}) {
-        auto create_unexpected = [&context]<typename C>(C &&err_code, const std::string_view msg) {
+                                                 std::string_view context = {},
+                                                 const std::source_location &location =
+                                                     std::source_location::current()) {
+        auto create_unexpected = [&context, &location]<typename C>(C &&err_code, const std::string_view msg) {
             // Ignore the additional message if the error came from an exception.
             // The exception message is already included in the context.
             if (context.ends_with("\x02")) {
                 context.remove_suffix(1);
-                return std::unexpected(Error{std::forward<C>(err_code), context});
+                return std::unexpected(Error{std::forward<C>(err_code), context, location});
             }
 
             return std::unexpected(Error{
-                std::forward<C>(err_code), context.empty() ? msg : std::format("{}: {}", context, msg)
+                std::forward<C>(err_code), context.empty() ? msg : std::format("{}: {}", context, msg), location
             });
         };
 
@@ -600,6 +765,19 @@ namespace error_utils {
         }
     }
 
+    // clang-format off
+    // @formatter:off
+
+    /// Controls how the \p errno-based wrappers read and write \p errno.
+    enum class ErrnoMode {
+        reset,       ///< Clear \p errno before the call, and again after reading an error (the default).
+        preserve,    ///< Like \p reset, but restore the caller's \p errno after the call.
+        on_failure,  ///< Never write \p errno; read it only when the return value signals failure.
+    };
+
+    // clang-format on
+    // @formatter:on
+
     /// Retrieve the last system error code and reset \p errno.
     /// \return The last system error code as \p std::error_code
     [[nodiscard]] inline std::error_code last_error() noexcept {
@@ -610,42 +788,115 @@ namespace error_utils {
 
     /// Create an error result from the current errno value.
     /// \param context Optional context information
+    /// \param location Where the error is created, for the \p ErrorObserver
     /// \tparam T The type of the result
     /// \return An unexpected result with the current \p errno
     template <typename T>
-    [[nodiscard]] Result<T> make_error_from_errno(const std::string_view context = {}) {
-        return make_error<T>(last_error(), context);
+    [[nodiscard]] Result<T> make_error_from_errno(const std::string_view context = {},
+                                                  const std::source_location &location =
+                                                      std::source_location::current()) {
+        return make_error<T>(last_error(), context, location);
     }
 
+    namespace detail {
+        /// Create an error result from a saved \p errno value, without touching \p errno.
+        /// A zero value, i.e. a failure that did not set \p errno, maps to \p ExtraError::unknown_error.
+        template <typename T>
+        [[nodiscard]] Result<T> make_error_from_errno_value(const int err, const std::string_view context,
+                                                            const std::source_location &location) {
+            if (err == 0) [[unlikely]] {
+                return make_error<T>(ExtraError::unknown_error, context, location);
+            }
+            return make_error<T>(std::make_error_code(static_cast<std::errc>(err)), context, location);
+        }
+    } // namespace detail
+
     /// Execute a function that may set errno, capturing the result and any error.
     ///
-    /// \note The errno value is reset before and after the function call.
+    /// \note With the default \p ErrnoMode::reset, the errno value is reset before the call,
+    /// and after it if an error was captured. With \p ErrnoMode::preserve, the caller's errno
+    /// is restored after the call instead.
     ///
     /// \param func Function that may set errno
     /// \param error_context Context to use if an error occurs
+    /// \param location Where the function is called, for the \p ErrorObserver
+    /// \tparam Mode How to treat \p errno. \p ErrnoMode::on_failure is not supported, since
+    /// the function's failure is detected through \p errno alone; use \p with_errno_if() instead.
     /// \tparam Func The type of the function to execute
     /// \tparam R The return type of the function. Automatically deduced.
     /// \return Result of the function or an error if errno was set
-    template <typename Func, typename R = std::invoke_result_t<Func>>
-    [[nodiscard]] auto with_errno(Func &&func, const std::string_view error_context = {}) -> Result<R> {
-        // Reset errno before calling the function to avoid side effects
-        errno = 0;
-
-        if constexpr (std::is_void_v<R>) {
-            std::forward<Func>(func)();
-            if (errno != 0) {
-                return make_error_from_errno<void>(error_context);
+    template <ErrnoMode Mode = ErrnoMode::reset, typename Func, typename R = std::invoke_result_t<Func>>
+    [[nodiscard]] auto with_errno(Func &&func, const std::string_view error_context = {},
+                                  const std::source_location &location = std::source_location::current())
+        -> Result<R> {
+        static_assert(Mode != ErrnoMode::on_failure,
+                      "with_errno() detects errors through errno alone; use with_errno_if() instead");
+
+        if constexpr (Mode == ErrnoMode::preserve) {
+            const int saved = errno;
+            errno = 0;
+
+            if constexpr (std::is_void_v<R>) {
+                std::forward<Func>(func)();
+                const int err = std::exchange(errno, saved);
+                if (err != 0) {
+                    return detail::make_error_from_errno_value<void>(err, error_context, location);
+                }
+                return {};
+            } else {
+                R result = std::forward<Func>(func)();
+                const int err = std::exchange(errno, saved);
+                if (err != 0) {
+                    return detail::make_error_from_errno_value<R>(err, error_context, location);
+                }
+                return result;
             }
-            return {};
         } else {
-            R result = std::forward<Func>(func)();
-            if (errno != 0) {
-                return make_error_from_errno<R>(error_context);
+            // Reset errno before calling the function to avoid side effects
+            errno = 0;
+
+            if constexpr (std::is_void_v<R>) {
+                std::forward<Func>(func)();
+                if (errno != 0) {
+                    return make_error_from_errno<void>(error_context, location);
+                }
+                return {};
+            } else {
+                R result = std::forward<Func>(func)();
+                if (errno != 0) {
+                    return make_error_from_errno<R>(error_context, location);
+                }
+                return result;
             }
-            return result;
         }
     }
 
+    /// Execute a function that signals failure through its return value and sets errno on failure.
+    ///
+    /// \p errno is read only when \p failed returns true, and is never written, so successful
+    /// calls do not touch it at all. If the function fails without setting errno, the error
+    /// is \p ExtraError::unknown_error.
+    ///
+    /// \param func Function that may set errno
+    /// \param failed Predicate on the function's result, returning true if the call failed
+    /// \param error_context Context to use if an error occurs
+    /// \param location Where the function is called, for the \p ErrorObserver
+    /// \tparam Func The type of the function to execute
+    /// \tparam Pred The type of the failure predicate
+    /// \tparam R The return type of the function. Automatically deduced.
+    /// \return Result of the function or an error from errno if the call failed
+    template <typename Func, typename Pred, typename R = std::invoke_result_t<Func>>
+        requires std::predicate<Pred &, const R &>
+    [[nodiscard]] auto with_errno_if(Func &&func, Pred &&failed, const std::string_view error_context = {},
+                                     const std::source_location &location = std::source_location::current())
+        -> Result<R> {
+        R result = std::forward<Func>(func)();
+        if (std::invoke(failed, std::as_const(result))) [[unlikely]] {
+            return detail::make_error_from_errno_value<R>(errno, error_context, location);
+        }
+        return result;
+    }
+
     /// Execute a function that may set \p errno, capturing the result and any error.
     ///
     /// This function is intended for use with system calls that return an integer result,
@@ -654,42 +905,70 @@ namespace error_utils {
     /// \param func Function that may set errno. Expected to return an integral type convertible to int.
     /// \tparam Func Type of the function to execute
     /// \param error_context Context to use if an error occurs
+    /// \param location Where the function is called, for the \p ErrorObserver
+    /// \tparam Mode How to treat \p errno. With \p ErrnoMode::on_failure, a successful call
+    /// neither reads nor writes \p errno.
     /// \tparam Func The type of the function to execute
     /// \return Result of the function or an error if errno was set
     ///
-    /// \note The \p errno value is reset before and after the function call.
+    /// \note With the default \p ErrnoMode::reset, the \p errno value is reset before and after the function call.
     /// \note The function must be \p noexcept to ensure that it does not throw exceptions.
     /// \note Notice that the function must be invocable with no arguments.
     /// \note Use a lambda or \p std::bind to wrap the function.
-    template <typename Func>
+    template <ErrnoMode Mode = ErrnoMode::reset, typename Func>
         requires std::is_nothrow_invocable_v<Func>
-    [[nodiscard]] IntResult invoke_with_syscall_api(Func &&func, const std::string_view error_context = {}) noexcept {
+    [[nodiscard]] IntResult invoke_with_syscall_api(Func &&func, const std::string_view error_context = {},
+                                                    const std::source_location &location =
+                                                        std::source_location::current()) noexcept {
         using R = std::invoke_result_t<Func>;
         static_assert(std::is_integral_v<R> && std::convertible_to<R, int>,
                       "func must return an integral type convertible to int");
 
-        // Reset errno before calling the function to avoid side effects
-        errno = 0;
+        if constexpr (Mode == ErrnoMode::reset) {
+            // Reset errno before calling the function to avoid side effects
+            errno = 0;
 
-        R result = std::forward<Func>(func)();
-        if (result == -1) {
-            return make_error_from_errno<int>(error_context);
-        }
+            R result = std::forward<Func>(func)();
+            if (result == -1) {
+                return make_error_from_errno<int>(error_context, location);
+            }
 
-        return result;
+            return result;
+        } else if constexpr (Mode == ErrnoMode::preserve) {
+            const int saved = errno;
+            R result = std::forward<Func>(func)();
+            const int err = std::exchange(errno, saved);
+            if (result == -1) [[unlikely]] {
+                return detail::make_error_from_errno_value<int>(err, error_context, location);
+            }
+
+            return result;
+        } else {
+            R result = std::forward<Func>(func)();
+            if (result == -1) [[unlikely]] {
+                return detail::make_error_from_errno_value<int>(errno, error_context, location);
+            }
+
+            return result;
+        }
     }
 
     /// Execute a function and catch common exceptions, converting them to errors.
     /// \param func Function to execute
     /// \param context Error context
+    /// \param location Where the function is called, for the \p ErrorObserver
     /// \tparam Func The type of the function to execute
     /// \tparam R The return type of the function. Automatically deduced.
     /// \return Result of the function or an error from caught exceptions
     template <typename Func, typename R = std::invoke_result_t<Func>>
-    [[nodiscard]] constexpr auto try_catch(Func &&func, std::string_view context = {}) -> Result<R> {
-        auto create_error = [&context]<typename T>(T &&code, const std::string_view default_msg) -> Result<R> {
+    [[nodiscard]] constexpr auto try_catch(Func &&func, std::string_view context = {},
+                                           const std::source_location &location = std::source_location::current())
+        -> Result<R> {
+        auto create_error = [&context, &location]<typename T>(T &&code, const std::string_view default_msg)
+            -> Result<R> {
             return make_error<R>(std::forward<T>(code),
-                                 context.empty() ? default_msg : std::format("{}: {}", context, default_msg));
+                                 context.empty() ? default_msg : std::format("{}: {}", context, default_msg),
+                                 location);
         };
 
         try {
@@ -759,29 +1038,1051 @@ namespace error_utils {
         }
     }
 
+    namespace detail {
+        /// A vector that stores up to \p N elements inline and moves to the heap beyond that.
+        ///
+        /// Only the operations needed by the library are provided.
+        /// \tparam T The element type. Its move constructor must not throw.
+        /// \tparam N The number of elements stored inline
+        template <typename T, std::size_t N>
+        class small_vector {
+            static_assert(std::is_nothrow_move_constructible_v<T>);
+
+            // clang-format off
+            // @formatter:off
+
+            alignas(T) std::byte inline_[N * sizeof(T)]; ///< Inline storage for the first N elements
+            T *data_;                                   ///< The current storage, inline or on the heap
+            std::size_t size_{};                        ///< Number of constructed elements
+            std::size_t capacity_{N};                   ///< Number of elements the storage can hold
+
+            // clang-format on
+            // @formatter:on
+
+            [[nodiscard]] T *inline_data() noexcept { return reinterpret_cast<T *>(inline_); }
+
+            [[nodiscard]] bool is_inline() const noexcept { return capacity_ == N; }
+
+            void release_storage() noexcept {
+                clear();
+                if (!is_inline()) {
+                    std::allocator<T>{}.deallocate(data_, capacity_);
+                    data_ = inline_data();
+                    capacity_ = N;
+                }
+            }
+
+            // Take over the elements of other, leaving it empty.
+            void steal(small_vector &other) noexcept {
+                if (other.is_inline()) {
+                    std::uninitialized_move(other.begin(), other.end(), data_);
+                    size_ = other.size_;
+                    other.clear();
+                } else {
+                    data_ = std::exchange(other.data_, other.inline_data());
+                    size_ = std::exchange(other.size_, 0);
+                    capacity_ = std::exchange(other.capacity_, N);
+                }
+            }
+
+        public:
+            small_vector() noexcept : data_{inline_data()} {}
+
+            small_vector(const small_vector &other) : small_vector() {
+                reserve(other.size_);
+                std::uninitialized_copy(other.begin(), other.end(), data_);
+                size_ = other.size_;
+            }
+
+            small_vector(small_vector &&other) noexcept : small_vector() { steal(other); }
+
+            small_vector &operator=(const small_vector &other) {
+                if (this == &other)
+                    return *this;
+                clear();
+                reserve(other.size_);
+                std::uninitialized_copy(other.begin(), other.end(), data_);
+                size_ = other.size_;
+                return *this;
+            }
+
+            small_vector &operator=(small_vector &&other) noexcept {
+                if (this == &other)
+                    return *this;
+                release_storage();
+                steal(other);
+                return *this;
+            }
+
+            ~small_vector() noexcept { release_storage(); }
+
+            /// Ensure the storage can hold at least \p capacity elements.
+            void reserve(const std::size_t capacity) {
+                if (capacity <= capacity_) {
+                    return;
+                }
+                T *storage = std::allocator<T>{}.allocate(capacity);
+                std::uninitialized_move(begin(), end(), storage);
+                std::destroy(begin(), end());
+                if (!is_inline()) {
+                    std::allocator<T>{}.deallocate(data_, capacity_);
+                }
+                data_ = storage;
+                capacity_ = capacity;
+            }
+
+            template <typename... Args>
+            T &emplace_back(Args &&... args) {
+                if (size_ == capacity_) {
+                    reserve(capacity_ * 2);
+                }
+                T *element = std::construct_at(data_ + size_, std::forward<Args>(args)...);
+                ++size_;
+                return *element;
+            }
+
+            void push_back(T &&value) { emplace_back(std::move(value)); }
+
+            void push_back(const T &value) { emplace_back(value); }
+
+            void clear() noexcept {
+                std::destroy(begin(), end());
+                size_ = 0;
+            }
+
+            [[nodiscard]] std::size_t size() const noexcept { return size_; }
+            [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+            [[nodiscard]] T *begin() noexcept { return data_; }
+            [[nodiscard]] T *end() noexcept { return data_ + size_; }
+            [[nodiscard]] const T *begin() const noexcept { return data_; }
+            [[nodiscard]] const T *end() const noexcept { return data_ + size_; }
+
+            [[nodiscard]] T &operator[](const std::size_t i) noexcept { return data_[i]; }
+            [[nodiscard]] const T &operator[](const std::size_t i) const noexcept { return data_[i]; }
+        };
+
+        /// Join the messages of several errors, separated by "; ".
+        /// \param errors A range of \p Error objects
+        template <std::ranges::input_range R>
+        [[nodiscard]] std::string join_error_messages(R &&errors) {
+            std::string combined_errors{};
+            for (const Error &error : errors) {
+                if (!combined_errors.empty()) {
+                    combined_errors += "; ";
+                }
+                combined_errors += error.message();
+            }
+            return combined_errors;
+        }
+
+        /// Rank an error by its \p ExtraErrorCondition, from 0 (least severe) to 4.
+        ///
+        /// The ranking is resource > runtime > access > logic > other. Errors that map to none of
+        /// the conditions rank with \p ExtraErrorCondition::other_error.
+        [[nodiscard]] inline int error_severity(const std::error_code &code) noexcept {
+            if (code == ExtraErrorCondition::resource_error) return 4;
+            if (code == ExtraErrorCondition::runtime_error) return 3;
+            if (code == ExtraErrorCondition::access_error) return 2;
+            if (code == ExtraErrorCondition::logic_error) return 1;
+            return 0;
+        }
+    } // namespace detail
+
+    // clang-format off
+    // @formatter:off
+
+    /// Strategies for choosing the overall error code of an \p AggregateError.
+    enum class AggregateCode {
+        unknown_error,  ///< Always \p ExtraError::unknown_error.
+        first,          ///< The code of the first error added.
+        last,           ///< The code of the last error added.
+        most_severe,    ///< The code of the first error with the most severe \p ExtraErrorCondition.
+    };
+
+    // clang-format on
+    // @formatter:on
+
+    /// A collection of errors reported as a single failure, e.g. when every alternative failed.
+    ///
+    /// The individual errors keep their codes and contexts. Up to four of them are stored
+    /// without allocating, and the combined message is rendered only when requested.
+    class AggregateError {
+        // clang-format off
+        // @formatter:off
+
+        detail::small_vector<Error, 4> errors_{};                        ///< The individual errors
+        std::error_code error_code_{make_error_code(ExtraError::unknown_error)}; ///< The overall code
+        AggregateCode policy_{AggregateCode::unknown_error};            ///< How the overall code is chosen
+
+        // clang-format on
+        // @formatter:on
+
+    public:
+        AggregateError() noexcept = default;
+
+        /// Create an empty aggregate that chooses its overall code with \p policy.
+        /// \param policy The strategy for choosing the overall error code
+        explicit AggregateError(const AggregateCode policy) noexcept : policy_{policy} {}
+
+        /// Add an error to the aggregate, updating the overall code according to the policy.
+        /// \param error The error to add
+        void push_back(Error error) {
+            switch (policy_) {
+                case AggregateCode::first:
+                    if (errors_.empty()) error_code_ = error.error_code();
+                    break;
+                case AggregateCode::last:
+                    error_code_ = error.error_code();
+                    break;
+                case AggregateCode::most_severe:
+                    if (errors_.empty() ||
+                        detail::error_severity(error.error_code()) > detail::error_severity(error_code_)) {
+                        error_code_ = error.error_code();
+                    }
+                    break;
+                case AggregateCode::unknown_error: [[fallthrough]];
+                default:
+                    break;
+            }
+            errors_.push_back(std::move(error));
+        }
+
+        /// Override the overall error code, regardless of the policy.
+        /// \param code The new overall error code
+        void set_error_code(const std::error_code &code) noexcept { error_code_ = code; }
+
+        /// Returns the individual errors, in the order they were added.
+        [[nodiscard]] std::span<const Error> errors() const noexcept { return {errors_.begin(), errors_.size()}; }
+
+        [[nodiscard]] const Error *begin() const noexcept { return errors_.begin(); }
+        [[nodiscard]] const Error *end() const noexcept { return errors_.end(); }
+
+        /// Returns the number of individual errors.
+        [[nodiscard]] std::size_t size() const noexcept { return errors_.size(); }
+
+        /// Check whether the aggregate holds no errors.
+        [[nodiscard]] bool empty() const noexcept { return errors_.empty(); }
+
+        /// Returns a constant reference to the overall error code.
+        [[nodiscard]] const std::error_code &error_code() const noexcept { return error_code_; }
+
+        /// Returns the value of the overall error code.
+        [[nodiscard]] int value() const noexcept { return error_code_.value(); }
+
+        /// Returns the category of the overall error code.
+        [[nodiscard]] const std::error_category &category() const noexcept { return error_code_.category(); }
+
+        /// Render the messages of the individual errors, separated by "; ".
+        [[nodiscard]] std::string context() const { return detail::join_error_messages(errors_); }
+
+        /// Render the combined error message, in the same format as \p Error::message().
+        [[nodiscard]] std::string message() const {
+            if (errors_.empty()) {
+                return error_code_.message();
+            }
+            return std::format("{}: {}", context(), error_code_.message());
+        }
+
+        /// Check if any of the individual errors is of a specific type.
+        /// \param code The error code to check against
+        /// \tparam T The type of the error code
+        /// \return True if any individual error matches the specified code.
+        template <typename T>
+            requires detail::comparable_to_error_code<std::remove_cvref_t<T>>
+        [[nodiscard]] bool is(T &&code) const noexcept {
+            return std::ranges::any_of(errors_, [&code](const Error &error) {
+                return error.is(std::remove_cvref_t<T>{code});
+            });
+        }
+
+        /// Check if any of the individual errors matches any of the specified codes or conditions.
+        /// \param code The first error code/condition to check against
+        /// \param others Other error codes/conditions to check against
+        /// \return True if any individual error matches any of the arguments.
+        template <typename Code, typename... Others>
+            requires detail::comparable_to_error_code<std::remove_cvref_t<Code>> &&
+                     (detail::comparable_to_error_code<std::remove_cvref_t<Others>> && ...)
+        [[nodiscard]] bool is_any_of(Code &&code, Others &&... others) const noexcept {
+            return is(code) || (is(others) || ...);
+        }
+
+        /// Render the aggregate as a single \p Error with the overall code.
+        [[nodiscard]] Error to_error() const { return Error{detail::unobserved, error_code_, context()}; }
+
+        /// Implicit conversion to \p Error, so that an \p AggregateResult converts to a \p Result.
+        operator Error() const { return to_error(); } // NOLINT(*-explicit-constructor)
+    };
+
+    /// A specialization of \p std::expected for the \p AggregateError type.
+    /// \tparam T The type of the expected value. Defaults to \p void
+    template <typename T = void>
+    using AggregateResult = std::expected<T, AggregateError>;
+
+    namespace detail {
+        /// A concept for the values a \p SmallResult can hold: trivially copyable, default
+        /// constructible, and no larger than a pointer.
+        template <typename T>
+        concept small_result_value = std::is_object_v<T> && std::is_trivially_copyable_v<T> &&
+                                     std::is_default_constructible_v<T> && sizeof(T) <= sizeof(void *) &&
+                                     alignof(T) <= alignof(void *);
+    } // namespace detail
+
+    /// A compact, trivially copyable \p Result<T> for small values such as \p int or \p bool.
+    ///
+    /// A \p SmallResult is two words: the value or the error code value, and the error category,
+    /// which is null on success. It has no destructor and is passed and returned in registers,
+    /// whereas \p std::expected<int, Error> holds a whole \p Error (over 40 bytes, with a
+    /// \p std::string) and must test which alternative to destroy. Creating an error never
+    /// allocates.
+    ///
+    /// The price is that a \p SmallResult keeps only the error code, not the context string.
+    /// It converts implicitly to \p Result<T>, and explicitly from one, dropping the context.
+    /// It has the observers and monadic operations of \p std::expected, with \p error()
+    /// returning an \p Error built from the code.
+    ///
+    /// \code
+    /// SmallResult<int> parse_digit(const char c) {
+    ///     if (c < '0' || c > '9') {
+    ///         return std::unexpected(std::errc::invalid_argument);
+    ///     }
+    ///     return c - '0';
+    /// }
+    /// \endcode
+    ///
+    /// \tparam T The type of the expected value
+    template <detail::small_result_value T>
+    class SmallResult {
+        union Storage {
+            T value;
+            int code;
+        };
+
+        // clang-format off
+        // @formatter:off
+
+        Storage storage_{.value = T{}};               ///< The value, or the error code value
+        const std::error_category *category_{};       ///< The error category, or null on success
+
+        // clang-format on
+        // @formatter:on
+
+        /// Selects \p SmallResult<U> if \p U is small enough, \p Result<U> otherwise.
+        template <typename U>
+        [[nodiscard]] static consteval auto result_for() noexcept {
+            if constexpr (detail::small_result_value<U>) {
+                return std::type_identity<SmallResult<U>>{};
+            } else {
+                return std::type_identity<Result<U>>{};
+            }
+        }
+
+    public:
+        using value_type = T;
+        using error_type = Error;
+        using unexpected_type = std::unexpected<Error>;
+
+        template <typename U>
+        using rebind = SmallResult<U>;
+
+        /// Create a result holding a value-initialized \p T.
+        constexpr SmallResult() noexcept = default;
+
+        /// Create a successful result.
+        /// \param value The value to hold
+        constexpr SmallResult(const T value) noexcept : storage_{.value = value} {} // NOLINT(*-explicit-constructor)
+
+        /// Create a successful result.
+        /// \param value The value to hold
+        constexpr explicit SmallResult(std::in_place_t, const T value) noexcept : storage_{.value = value} {}
+
+        /// Create a failed result.
+        /// \param code The error code
+        constexpr explicit SmallResult(std::unexpect_t, const std::error_code &code) noexcept
+            : storage_{.code = code.value()}, category_{&code.category()} {}
+
+        /// Create a failed result from an error code enum.
+        /// \param code The error code
+        constexpr explicit SmallResult(std::unexpect_t, const detail::convertible_to_error_code auto code) noexcept
+            : SmallResult{std::unexpect, std::error_code{make_error_code(code)}} {}
+
+        /// Create a failed result with the code of \p error. Its context is dropped.
+        /// \param error The error whose code to keep
+        constexpr explicit SmallResult(std::unexpect_t, const Error &error) noexcept
+            : SmallResult{std::unexpect, error.error_code()} {}
+
+        /// Create a failed result from \p std::unexpected of an error code, an error code
+        /// enum, or an \p Error (whose context is dropped).
+        template <typename G>
+            requires std::same_as<G, std::error_code> || std::same_as<G, Error> ||
+                     detail::convertible_to_error_code<G>
+        constexpr SmallResult(const std::unexpected<G> &error) noexcept // NOLINT(*-explicit-constructor)
+            : SmallResult{std::unexpect, error.error()} {}
+
+        /// Convert a \p Result<T>, keeping only the code of its error.
+        constexpr explicit SmallResult(const Result<T> &result) noexcept
+            : storage_{.value = result ? *result : T{}},
+              category_{result ? nullptr : &result.error().category()} {
+            if (!result) {
+                storage_.code = result.error().value();
+            }
+        }
+
+        /// Convert to a \p Result<T>, with an error that has no context.
+        [[nodiscard]] constexpr operator Result<T>() const { // NOLINT(*-explicit-constructor)
+            if (category_ != nullptr) {
+                return std::unexpected(error());
+            }
+            return storage_.value;
+        }
+
+        /// Check whether the result holds a value.
+        [[nodiscard]] constexpr bool has_value() const noexcept { return category_ == nullptr; }
+
+        /// Implicit conversion to bool, indicating whether the result holds a value.
+        [[nodiscard]] constexpr explicit operator bool() const noexcept { return has_value(); }
+
+        /// Returns the value. The result must hold one.
+        [[nodiscard]] constexpr const T &operator*() const noexcept { return storage_.value; }
+
+        /// Returns the value. The result must hold one.
+        [[nodiscard]] constexpr T &operator*() noexcept { return storage_.value; }
+
+        [[nodiscard]] constexpr const T *operator->() const noexcept { return &storage_.value; }
+
+        [[nodiscard]] constexpr T *operator->() noexcept { return &storage_.value; }
+
+        /// Returns the value.
+        /// \throws std::bad_expected_access<Error> if the result holds an error
+        [[nodiscard]] constexpr const T &value() const {
+            if (category_ != nullptr) {
+                throw std::bad_expected_access<Error>(error());
+            }
+            return storage_.value;
+        }
+
+        /// Returns the value, or \p default_value if the result holds an error.
+        template <typename U>
+            requires std::convertible_to<U, T>
+        [[nodiscard]] constexpr T value_or(U &&default_value) const noexcept {
+            return category_ == nullptr ? storage_.value : static_cast<T>(std::forward<U>(default_value));
+        }
+
+        /// Returns the error code. The result must hold an error.
+        [[nodiscard]] constexpr std::error_code error_code() const noexcept {
+            return std::error_code{storage_.code, *category_};
+        }
+
+        /// Returns the error, without context. The result must hold an error.
+        [[nodiscard]] constexpr Error error() const noexcept { return Error{detail::unobserved, error_code()}; }
+
+        /// Invoke \p func with the value, returning its result, or propagate the error.
+        /// \param func A callable taking \p T and returning a \p Result or a \p SmallResult
+        template <typename F>
+        [[nodiscard]] constexpr auto and_then(F &&func) const {
+            using U = std::remove_cvref_t<std::invoke_result_t<F, const T &>>;
+            static_assert(std::is_same_v<typename U::error_type, Error>,
+                          "The callable must return a Result or a SmallResult");
+            if (has_value()) {
+                return std::invoke(std::forward<F>(func), storage_.value);
+            }
+            return U{std::unexpect, error()};
+        }
+
+        /// Transform the value with \p func, or propagate the error.
+        /// \return A \p SmallResult if the new value type is small enough, a \p Result otherwise
+        template <typename F>
+        [[nodiscard]] constexpr auto transform(F &&func) const {
+            using U = std::remove_cv_t<std::invoke_result_t<F, const T &>>;
+            using Out = typename decltype(result_for<U>())::type;
+            if (!has_value()) {
+                return Out{std::unexpect, error()};
+            }
+            if constexpr (std::is_void_v<U>) {
+                std::invoke(std::forward<F>(func), storage_.value);
+                return Out{};
+            } else {
+                return Out{std::invoke(std::forward<F>(func), storage_.value)};
+            }
+        }
+
+        /// Invoke \p func with the error, returning its result, or propagate the value.
+        /// \param func A callable taking an \p Error and returning a result with value type \p T
+        template <typename F>
+        [[nodiscard]] constexpr auto or_else(F &&func) const {
+            using G = std::remove_cvref_t<std::invoke_result_t<F, Error>>;
+            static_assert(std::is_same_v<typename G::value_type, T>,
+                          "The callable must return a result with the same value type");
+            if (has_value()) {
+                return G{std::in_place, storage_.value};
+            }
+            return std::invoke(std::forward<F>(func), error());
+        }
+
+        /// Transform the error with \p func, or propagate the value.
+        /// \return A \p SmallResult if \p func returns an \p Error or a \p std::error_code,
+        /// a \p std::expected otherwise
+        template <typename F>
+        [[nodiscard]] constexpr auto transform_error(F &&func) const {
+            using G = std::remove_cv_t<std::invoke_result_t<F, Error>>;
+            using Out = std::conditional_t<std::is_same_v<G, Error> || std::is_same_v<G, std::error_code>,
+                                           SmallResult, std::expected<T, G>>;
+            if (has_value()) {
+                return Out{std::in_place, storage_.value};
+            }
+            return Out{std::unexpect, std::invoke(std::forward<F>(func), error())};
+        }
+
+        /// Compare two results: equal if both hold equal values, or both hold the same error code.
+        [[nodiscard]] constexpr friend bool operator==(const SmallResult &lhs, const SmallResult &rhs) noexcept
+            requires std::equality_comparable<T> {
+            if (lhs.has_value() != rhs.has_value()) {
+                return false;
+            }
+            return lhs.has_value() ? lhs.storage_.value == rhs.storage_.value : lhs.error_code() == rhs.error_code();
+        }
+
+        /// Compare the value of a result with \p value.
+        [[nodiscard]] constexpr friend bool operator==(const SmallResult &lhs, const T &value) noexcept
+            requires std::equality_comparable<T> {
+            return lhs.has_value() && lhs.storage_.value == value;
+        }
+    };
+
+    static_assert(sizeof(SmallResult<int>) == 2 * sizeof(void *));
+    static_assert(std::is_trivially_copyable_v<SmallResult<int>>);
+
+    namespace detail {
+        /// Check if a type is a \p SmallResult.
+        template <typename T>
+        inline constexpr bool is_small_result_v = false;
+
+        template <typename T>
+        inline constexpr bool is_small_result_v<SmallResult<T>> = true;
+    } // namespace detail
+
+    /// A register-sized \p VoidResult: success, or an error code with optional context.
+    ///
+    /// A \p Status holds the error code value and a single word, which is null on success,
+    /// points to the error category when there is no context, or owns a single heap block with
+    /// the category and the characters of the context. Checking for success is a comparison
+    /// with zero, and only errors with a context allocate. Since ownership is tracked by a tag bit in that
+    /// word, a \p Status is trivially relocatable, and Clang passes and returns it in registers.
+    ///
+    /// It converts to and from \p VoidResult and \p Error without loss, and works with
+    /// \p CEU_TRY and \p CEU_TRY_ASSIGN.
+    ///
+    /// \code
+    /// Status flush(Page &page) {
+    ///     if (page.dirty() && ::pwrite(page.fd(), page.data(), page.size(), page.offset()) == -1) {
+    ///         return Status{std::error_code{errno, std::system_category()}};
+    ///     }
+    ///     return {};
+    /// }
+    /// \endcode
+    class [[nodiscard]] CPP_ERROR_UTILS_TRIVIAL_ABI Status {
+        /// Header of the out-of-line block, followed by the characters of the context.
+        struct Block {
+            const std::error_category *category;
+            std::size_t size;
+
+            [[nodiscard]] std::string_view context() const noexcept {
+                return {reinterpret_cast<const char *>(this + 1), size};
+            }
+
+            [[nodiscard]] static Block *create(const std::error_category &category, const std::string_view context) {
+                void *memory = ::operator new(sizeof(Block) + context.size());
+                auto *block = ::new(memory) Block{&category, context.size()};
+                context.copy(reinterpret_cast<char *>(block + 1), context.size());
+                return block;
+            }
+
+            static void destroy(Block *block) noexcept { ::operator delete(block); }
+        };
+
+        static_assert(alignof(std::error_category) >= 2 && alignof(Block) >= 2, "The tag bit must be free");
+
+        static constexpr std::uintptr_t owned_tag = 1;
+
+        // clang-format off
+        // @formatter:off
+
+        std::uintptr_t rep_{}; ///< Null, a category pointer, or a tagged pointer to a \p Block
+        int code_{};           ///< The error code value
+
+        // clang-format on
+        // @formatter:on
+
+        [[nodiscard]] bool owns_block() const noexcept { return (rep_ & owned_tag) != 0; }
+
+        [[nodiscard]] Block *block() const noexcept { return reinterpret_cast<Block *>(rep_ & ~owned_tag); }
+
+        void assign(const std::error_code &code, const std::string_view context) {
+            code_ = code.value();
+            if (context.empty()) {
+                rep_ = reinterpret_cast<std::uintptr_t>(&code.category());
+            } else {
+                rep_ = reinterpret_cast<std::uintptr_t>(Block::create(code.category(), context)) | owned_tag;
+            }
+        }
+
+    public:
+        using value_type = void;
+        using error_type = Error;
+
+        /// Create a successful status.
+        constexpr Status() noexcept = default;
+
+        /// Create a failed status.
+        /// \param code The error code
+        /// \param context Context information, stored out of line if not empty
+        explicit Status(const std::error_code &code, const std::string_view context = {}) {
+            assign(code, context);
+        }
+
+        /// Create a failed status from an error code enum.
+        /// \param code The error code
+        /// \param context Context information, stored out of line if not empty
+        explicit Status(const detail::convertible_to_error_code auto code, const std::string_view context = {})
+            : Status{std::error_code{make_error_code(code)}, context} {}
+
+        /// Create a failed status from an \p Error, keeping its context.
+        Status(const Error &error) { // NOLINT(*-explicit-constructor)
+            assign(error.error_code(), error.context());
+        }
+
+        /// Create a failed status from \p std::unexpected of an \p Error, an error code,
+        /// or an error code enum.
+        template <typename G>
+            requires std::constructible_from<Status, G>
+        Status(const std::unexpected<G> &error) : Status{error.error()} {} // NOLINT(*-explicit-constructor)
+
+        /// Convert a \p VoidResult, keeping the context of its error.
+        Status(const VoidResult &result) { // NOLINT(*-explicit-constructor)
+            if (!result) {
+                assign(result.error().error_code(), result.error().context());
+            }
+        }
+
+        Status(const Status &other) : rep_{other.rep_}, code_{other.code_} {
+            if (other.owns_block()) {
+                const Block *source = other.block();
+                const Block *copy = Block::create(*source->category, source->context());
+                rep_ = reinterpret_cast<std::uintptr_t>(copy) | owned_tag;
+            }
+        }
+
+        /// Move the context out of \p other, which keeps its error code.
+        Status(Status &&other) noexcept : rep_{other.rep_}, code_{other.code_} {
+            if (other.owns_block()) {
+                other.rep_ = reinterpret_cast<std::uintptr_t>(other.block()->category);
+            }
+        }
+
+        Status &operator=(const Status &other) {
+            if (this == &other)
+                return *this;
+            Status copy{other};
+            swap(*this, copy);
+            return *this;
+        }
+
+        Status &operator=(Status &&other) noexcept {
+            if (this == &other)
+                return *this;
+            Status moved{std::move(other)};
+            swap(*this, moved);
+            return *this;
+        }
+
+        ~Status() noexcept {
+            if (owns_block()) [[unlikely]] {
+                Block::destroy(block());
+            }
+        }
+
+        /// Check whether the status is a success.
+        [[nodiscard]] bool ok() const noexcept { return rep_ == 0; }
+
+        /// Check whether the status is a success, like \p VoidResult::has_value().
+        [[nodiscard]] bool has_value() const noexcept { return rep_ == 0; }
+
+        /// Implicit conversion to bool, indicating success.
+        [[nodiscard]] explicit operator bool() const noexcept { return rep_ == 0; }
+
+        /// Returns the error category. The status must be a failure.
+        [[nodiscard]] const std::error_category &category() const noexcept {
+            return owns_block() ? *block()->category : *reinterpret_cast<const std::error_category *>(rep_);
+        }
+
+        /// Returns the error code, or a default-constructed one on success.
+        [[nodiscard]] std::error_code error_code() const noexcept {
+            return rep_ == 0 ? std::error_code{} : std::error_code{code_, category()};
+        }
+
+        /// Returns the value of the error code, or 0 on success.
+        [[nodiscard]] int value() const noexcept { return code_; }
+
+        /// Returns the context, which is empty on success or if the error has none.
+        [[nodiscard]] std::string_view context() const noexcept {
+            return owns_block() ? block()->context() : std::string_view{};
+        }
+
+        /// Returns the error as an \p Error, with its context. The status must be a failure.
+        [[nodiscard]] Error error() const { return Error{detail::unobserved, error_code(), context()}; }
+
+        /// Get the error message including context if available, as \p Error::message() does.
+        [[nodiscard]] std::string message() const {
+            if (!owns_block()) {
+                return error_code().message();
+            }
+            return std::format("{}: {}", context(), error_code().message());
+        }
+
+        /// Check if the error is of a specific type, as \p Error::is() does. Always false on success.
+        /// \param code The error code or condition to check against
+        template <typename T>
+            requires detail::comparable_to_error_code<std::remove_cvref_t<T>>
+        [[nodiscard]] bool is(T &&code) const noexcept {
+            return rep_ != 0 && Error{detail::unobserved, error_code()}.is(std::remove_cvref_t<T>{code});
+        }
+
+        /// Convert to a \p VoidResult, keeping the context.
+        [[nodiscard]] operator VoidResult() const { // NOLINT(*-explicit-constructor)
+            if (rep_ == 0) {
+                return {};
+            }
+            return std::unexpected(error());
+        }
+
+        /// Compare two statuses by error code, like \p Error. All successes are equal.
+        [[nodiscard]] friend bool operator==(const Status &lhs, const Status &rhs) noexcept {
+            return lhs.error_code() == rhs.error_code() && lhs.ok() == rhs.ok();
+        }
+
+        /// Swap the contents of two Status objects.
+        friend void swap(Status &lhs, Status &rhs) noexcept {
+            std::swap(lhs.rep_, rhs.rep_);
+            std::swap(lhs.code_, rhs.code_);
+        }
+    };
+
+    static_assert(sizeof(Status) == 2 * sizeof(void *));
+
+    namespace detail {
+        /// A concept for callables taking no arguments and returning a \p Result.
+        template <typename F>
+        concept result_invocable = std::invocable<F> && is_expected_v<std::remove_cvref_t<std::invoke_result_t<F>>>;
+
+        /// The \p Result type returned by a \p result_invocable.
+        template <typename F>
+        using invoke_result_value_t = std::remove_cvref_t<std::invoke_result_t<F>>;
+
+        /// Convert the successful \p Result of an alternative into the output type of \p first_of.
+        template <typename Out, typename In>
+        [[nodiscard]] constexpr Out forward_success(In &&result) {
+            if constexpr (std::is_same_v<Out, std::remove_cvref_t<In>>) {
+                return std::forward<In>(result);
+            } else if constexpr (std::is_void_v<typename Out::value_type>) {
+                return Out{};
+            } else {
+                return Out{std::in_place, *std::forward<In>(result)};
+            }
+        }
+
+        /// Convert the errors of all the alternatives into the output type of \p first_of.
+        template <typename Out>
+        [[nodiscard]] Out forward_failure(AggregateError &&errors) {
+            if constexpr (std::is_same_v<typename Out::error_type, AggregateError>) {
+                return std::unexpected(std::move(errors));
+            } else {
+                return std::unexpected(errors.to_error());
+            }
+        }
+
+        /// Evaluate the alternatives in order, recording the error of each failed one.
+        template <typename Out, typename F, typename... Fs>
+        [[nodiscard]] constexpr Out first_of_lazy(AggregateError &errors, F &&func, Fs &&... others) {
+            auto result = std::invoke(std::forward<F>(func));
+            if (result) {
+                return forward_success<Out>(std::move(result));
+            }
+            errors.push_back(std::move(result).error());
+            if constexpr (sizeof...(Fs) == 0) {
+                return forward_failure<Out>(std::move(errors));
+            } else {
+                return first_of_lazy<Out>(errors, std::forward<Fs>(others)...);
+            }
+        }
+
+        /// Evaluate a range of alternatives in order, recording the error of each failed one.
+        template <typename Out, typename R>
+        [[nodiscard]] constexpr Out first_of_range(AggregateError &&errors, R &&alternatives) {
+            for (auto &&alternative : alternatives) {
+                auto result = std::invoke(alternative);
+                if (result) {
+                    return forward_success<Out>(std::move(result));
+                }
+                errors.push_back(std::move(result).error());
+            }
+
+            if (errors.empty()) {
+                if constexpr (std::is_same_v<typename Out::error_type, AggregateError>) {
+                    errors.set_error_code(std::make_error_code(std::errc::invalid_argument));
+                    return std::unexpected(std::move(errors));
+                } else {
+                    return make_error<typename Out::value_type>(std::errc::invalid_argument,
+                                                                "No alternatives provided");
+                }
+            }
+            return forward_failure<Out>(std::move(errors));
+        }
+    } // namespace detail
+
     /// Return first success result from multiple alternatives
     /// \param results Multiple results of the same type
     /// \tparam T The type of the result
     /// \return First successful result or combined error
+    ///
+    /// \note All the alternatives are evaluated before the call. Pass callables instead
+    /// to evaluate them lazily.
     template <typename T>
     [[nodiscard]] constexpr Result<T> first_of(std::initializer_list<Result<T>> results) {
         if (results.size() == 0) {
             return make_error<T>(std::errc::invalid_argument, "No alternatives provided");
         }
-        std::string combined_errors{};
 
         for (const auto &result : results) {
             if (result) {
                 return result;
             }
-            if (!combined_errors.empty()) {
-                combined_errors += "; ";
-            }
-            combined_errors += result.error().message();
         }
 
-        return make_error<T>(ExtraError::unknown_error, combined_errors);
+        return make_error<T>(ExtraError::unknown_error, detail::join_error_messages(
+                                 results | std::views::transform([](const Result<T> &result) -> const Error & {
+                                     return result.error();
+                                 })));
+    }
+
+    /// Return the first success result from alternatives evaluated lazily, in order.
+    ///
+    /// Evaluation stops at the first alternative that succeeds, and its result is moved out.
+    /// The combined error is built only if every alternative fails.
+    ///
+    /// \param func The first alternative
+    /// \param others The other alternatives
+    /// \tparam F The type of the first alternative
+    /// \tparam Fs The types of the other alternatives. They must return the same \p Result type.
+    /// \return First successful result or combined error
+    template <typename F, typename... Fs>
+        requires detail::result_invocable<F> &&
+                 (std::same_as<detail::invoke_result_value_t<F>, std::remove_cvref_t<std::invoke_result_t<Fs>>> && ...)
+    [[nodiscard]] constexpr auto first_of(F &&func, Fs &&... others) -> detail::invoke_result_value_t<F> {
+        AggregateError errors{};
+        return detail::first_of_lazy<detail::invoke_result_value_t<F>>(errors, std::forward<F>(func),
+                                                                       std::forward<Fs>(others)...);
+    }
+
+    /// Return the first success result from a range of alternatives evaluated lazily, in order.
+    ///
+    /// Evaluation stops at the first alternative that succeeds, and its result is moved out.
+    /// The combined error is built only if every alternative fails.
+    ///
+    /// \param alternatives A range of callables returning the same \p Result type
+    /// \tparam R The type of the range
+    /// \return First successful result or combined error
+    template <std::ranges::input_range R>
+        requires detail::result_invocable<std::ranges::range_reference_t<R>>
+    [[nodiscard]] constexpr auto first_of(R &&alternatives)
+        -> detail::invoke_result_value_t<std::ranges::range_reference_t<R>> {
+        using Out = detail::invoke_result_value_t<std::ranges::range_reference_t<R>>;
+        return detail::first_of_range<Out>(AggregateError{}, std::forward<R>(alternatives));
+    }
+
+    /// Return the first success result from alternatives evaluated lazily, in order,
+    /// keeping every error if they all fail.
+    ///
+    /// Unlike \p first_of(), the failure is an \p AggregateError: the individual errors keep
+    /// their codes and can be queried with \p is() and \p is_any_of(), and no message is
+    /// rendered unless requested. An \p AggregateResult converts implicitly to a \p Result.
+    ///
+    /// \param func The first alternative
+    /// \param others The other alternatives
+    /// \tparam Code The strategy for choosing the overall error code
+    /// \tparam F The type of the first alternative
+    /// \tparam Fs The types of the other alternatives. They must return the same \p Result type.
+    /// \return First successful result or the aggregate of all errors
+    template <AggregateCode Code = AggregateCode::last, typename F, typename... Fs>
+        requires detail::result_invocable<F> &&
+                 (std::same_as<detail::invoke_result_value_t<F>, std::remove_cvref_t<std::invoke_result_t<Fs>>> && ...)
+    [[nodiscard]] auto first_of_aggregate(F &&func, Fs &&... others)
+        -> AggregateResult<typename detail::invoke_result_value_t<F>::value_type> {
+        using Out = AggregateResult<typename detail::invoke_result_value_t<F>::value_type>;
+        AggregateError errors{Code};
+        return detail::first_of_lazy<Out>(errors, std::forward<F>(func), std::forward<Fs>(others)...);
+    }
+
+    /// Return the first success result from a range of alternatives evaluated lazily, in order,
+    /// keeping every error if they all fail.
+    ///
+    /// \param alternatives A range of callables returning the same \p Result type
+    /// \tparam Code The strategy for choosing the overall error code
+    /// \tparam R The type of the range
+    /// \return First successful result or the aggregate of all errors
+    /// \see first_of_aggregate(F &&, Fs &&...)
+    template <AggregateCode Code = AggregateCode::last, std::ranges::input_range R>
+        requires detail::result_invocable<std::ranges::range_reference_t<R>>
+    [[nodiscard]] auto first_of_aggregate(R &&alternatives)
+        -> AggregateResult<typename detail::invoke_result_value_t<std::ranges::range_reference_t<R>>::value_type> {
+        using Out = AggregateResult<
+            typename detail::invoke_result_value_t<std::ranges::range_reference_t<R>>::value_type>;
+        return detail::first_of_range<Out>(AggregateError{Code}, std::forward<R>(alternatives));
     }
+
+    namespace detail {
+        /// A concept for input ranges whose elements are non-void \p Result values.
+        template <typename R>
+        concept result_range = std::ranges::input_range<R> &&
+                               is_expected_v<std::remove_cvref_t<std::ranges::range_reference_t<R>>> &&
+                               !std::is_void_v<typename std::remove_cvref_t<std::ranges::range_reference_t<R>>::value_type>;
+
+        /// The value type of the \p Result elements of a \p result_range.
+        template <typename R>
+        using range_result_value_t = typename std::remove_cvref_t<std::ranges::range_reference_t<R>>::value_type;
+
+        /// Whether the elements of \p R can be moved from: they are temporaries (e.g. produced by
+        /// \p std::views::transform), or the range is an owning container passed as an rvalue.
+        template <typename R>
+        inline constexpr bool moves_elements = !std::is_lvalue_reference_v<std::ranges::range_reference_t<R>> ||
+                                               (!std::is_lvalue_reference_v<R> &&
+                                                !std::ranges::view<std::remove_cvref_t<R>>);
+
+        /// Implementation of \p collect and \p collect_all.
+        /// \tparam All Whether to keep going after the first error, gathering every error
+        template <bool All>
+        struct collect_fn {
+            template <result_range R>
+            [[nodiscard]] constexpr auto operator()(R &&results) const {
+                using T = range_result_value_t<R>;
+                using Out = std::conditional_t<All, AggregateResult<std::vector<T>>, Result<std::vector<T>>>;
+
+                std::vector<T> values{};
+                if constexpr (std::ranges::sized_range<R>) {
+                    values.reserve(static_cast<std::size_t>(std::ranges::size(results)));
+                }
+
+                [[maybe_unused]] AggregateError errors{AggregateCode::first};
+                for (auto &&result : results) {
+                    if (!result) {
+                        if constexpr (All) {
+                            if constexpr (moves_elements<R>) {
+                                errors.push_back(std::move(result).error());
+                            } else {
+                                errors.push_back(result.error());
+                            }
+                            continue;
+                        } else {
+                            if constexpr (moves_elements<R>) {
+                                return Out{std::unexpect, std::move(result).error()};
+                            } else {
+                                return Out{std::unexpect, result.error()};
+                            }
+                        }
+                    }
+                    if constexpr (All) {
+                        // The values are discarded anyway
+                        if (!errors.empty()) continue;
+                    }
+                    if constexpr (moves_elements<R>) {
+                        values.push_back(*std::move(result));
+                    } else {
+                        values.push_back(*result);
+                    }
+                }
+
+                if constexpr (All) {
+                    if (!errors.empty()) {
+                        return Out{std::unexpect, std::move(errors)};
+                    }
+                }
+                return Out{std::in_place, std::move(values)};
+            }
+
+            /// Returns the adaptor itself, so that both <tt>r | collect</tt> and <tt>r | collect()</tt> work.
+            [[nodiscard]] constexpr const collect_fn &operator()() const noexcept { return *this; }
+
+            template <result_range R>
+            [[nodiscard]] friend constexpr auto operator|(R &&results, const collect_fn &collect) {
+                return collect(std::forward<R>(results));
+            }
+        };
+    } // namespace detail
+
+    /// Collect a range of \p Result<T> into a \p Result<std::vector<T>>, stopping at the first error.
+    ///
+    /// Works with any input range, as a function or as a range adaptor:
+    /// \code
+    /// auto numbers = collect(lines | std::views::transform(parse_number));
+    /// auto numbers = lines | std::views::transform(parse_number) | collect;
+    /// \endcode
+    ///
+    /// The vector is reserved up front when the size of the range is known. Values are moved
+    /// when the elements are temporaries or the range is an owning container passed as an rvalue,
+    /// and copied otherwise.
+    ///
+    /// \return The values in the order of the range, or the first error
+    inline constexpr detail::collect_fn<false> collect{};
+
+    /// Collect a range of \p Result<T> into an \p AggregateResult<std::vector<T>>, gathering
+    /// every error instead of stopping at the first one.
+    ///
+    /// The overall error code is that of the first error (\p AggregateCode::first).
+    /// Usable as a function or as a range adaptor, like \p collect.
+    ///
+    /// \return The values in the order of the range, or the aggregate of all errors
+    inline constexpr detail::collect_fn<true> collect_all{};
+
+    namespace detail {
+        /// Take the value out of a successful \p std::expected for \p CEU_TRY.
+        /// Rvalues are moved from, lvalues are copied.
+        template <typename R>
+            requires is_expected_v<std::remove_cvref_t<R>> || is_small_result_v<std::remove_cvref_t<R>> ||
+                     std::same_as<std::remove_cvref_t<R>, Status>
+        [[nodiscard]] constexpr typename std::remove_cvref_t<R>::value_type try_take(R &&result) {
+            if constexpr (!std::is_void_v<typename std::remove_cvref_t<R>::value_type>) {
+                return *std::forward<R>(result);
+            }
+        }
+
+        /// Hash an error code together with a fingerprint of its context.
+        [[nodiscard]] inline std::size_t hash_error(const std::error_code &code,
+                                                    const std::string_view context) noexcept {
+            const std::size_t seed = std::hash<std::error_code>{}(code);
+            const std::size_t fingerprint = std::hash<std::string_view>{}(context);
+            return seed ^ (fingerprint + 0x9e37'79b9'7f4a'7c15ULL + (seed << 6) + (seed >> 2));
+        }
+    } // namespace detail
+
+    /// Hashes an \p Error together with its context.
+    ///
+    /// \p std::hash<Error> only hashes the error code, consistently with \p operator== which
+    /// ignores the context. Use this hash with \p ErrorContextEqual to tell apart errors that only
+    /// differ by their context:
+    /// \code
+    /// std::unordered_set<Error, ErrorContextHash, ErrorContextEqual> distinct;
+    /// \endcode
+    struct ErrorContextHash {
+        [[nodiscard]] std::size_t operator()(const Error &error) const noexcept {
+            return detail::hash_error(error.error_code(), error.context());
+        }
+    };
+
+    /// Compares two \p Error by their error code and their context.
+    struct ErrorContextEqual {
+        [[nodiscard]] bool operator()(const Error &lhs, const Error &rhs) const noexcept {
+            return lhs == rhs && lhs.context() == rhs.context();
+        }
+    };
 } // namespace error_utils
 
 namespace std {
@@ -813,3 +2114,67 @@ using error_utils::VoidResult;
 using error_utils::StringResult;
 using error_utils::IntResult;
 using error_utils::BoolResult;
+
+
+// ///////////////////////// Error Propagation Macros /////////////////////////
+
+/// \cond
+#define CPP_ERROR_UTILS_CONCAT_IMPL(a, b) a##b
+#define CPP_ERROR_UTILS_CONCAT(a, b) CPP_ERROR_UTILS_CONCAT_IMPL(a, b)
+/// \endcond
+
+/// Evaluate \p expr, a \p std::expected, into \p var, or return its error from the enclosing function.
+///
+/// \p var may be a declaration or any assignable expression. A temporary \p expr is moved
+/// from, so neither the value nor the error is copied:
+///
+/// \code
+/// StringResult read_config(const std::string &path) {
+///     CEU_TRY_ASSIGN(const auto fd, open_fd(path, O_RDONLY));
+///     CEU_TRY_ASSIGN(std::string text, read_all(fd));
+///     return text;
+/// }
+/// \endcode
+///
+/// \note The enclosing function must return a \p std::expected constructible from
+/// \p std::unexpected of the error type of \p expr. In a coroutine, use \p co_await instead
+/// (see \p error_utils_coro.hpp).
+#define CEU_TRY_ASSIGN(var, expr) \
+    CPP_ERROR_UTILS_TRY_ASSIGN_IMPL(var, expr, CPP_ERROR_UTILS_CONCAT(ceu_try_result_, __COUNTER__))
+
+/// \cond
+#define CPP_ERROR_UTILS_TRY_ASSIGN_IMPL(var, expr, result)                           \
+    auto &&result = (expr);                                                          \
+    if (!result) [[unlikely]] {                                                      \
+        return std::unexpected(std::forward<decltype(result)>(result).error());      \
+    }                                                                                \
+    var = ::error_utils::detail::try_take(std::forward<decltype(result)>(result))
+/// \endcond
+
+#if defined(__GNUC__) || defined(__clang__)
+/// Evaluate \p expr, a \p std::expected, to its value, or return its error from the enclosing function.
+///
+/// Usable wherever an expression is expected. For a \p VoidResult, the expression is \p void.
+///
+/// \code
+/// Result<std::size_t> file_size(const std::string &path) {
+///     return CEU_TRY(read_file(path)).size();
+/// }
+/// \endcode
+///
+/// \note This relies on statement expressions, a GCC and Clang extension, and is not defined
+/// with other compilers. The extension is marked so that \p -Wpedantic does not warn about it.
+/// \see CEU_TRY_ASSIGN
+#define CEU_TRY(expr) CPP_ERROR_UTILS_TRY_IMPL(expr, CPP_ERROR_UTILS_CONCAT(ceu_try_result_, __COUNTER__))
+
+/// \cond
+#define CPP_ERROR_UTILS_TRY_IMPL(expr, result)                                       \
+    __extension__({                                                                  \
+        auto &&result = (expr);                                                      \
+        if (!result) [[unlikely]] {                                                  \
+            return std::unexpected(std::forward<decltype(result)>(result).error());  \
+        }                                                                            \
+        ::error_utils::detail::try_take(std::forward<decltype(result)>(result));     \
+    })
+/// \endcond
+#endif
@@ -0,0 +1,1531 @@
+// MIT License
+//
+// Copyright (c) 2025 Ian Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+/// \file
+/// \brief Concurrency utilities built on top of \p Result<T>.
+///
+/// \details This module runs \p Result-returning work on several threads, propagating
+/// errors and cancellation (through \p std::stop_token) between them. It also provides
+/// a lazy \p task coroutine type, a work-stealing \p ThreadPool to run tasks on,
+/// \p when_all() / \p when_any() combinators that aggregate the errors of several tasks or
+/// futures (\p FutureGroup), deadlines (\p with_deadline(), \p with_timeout()) served by a
+/// single timer thread, and \p parallel_transform() over ranges with first-error cancellation.
+
+#pragma once
+
+/// \cond
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <stop_token>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+/// \endcond
+
+#include "error_utils.hpp"
+#include "error_utils_coro.hpp"
+
+
+namespace error_utils {
+    namespace detail {
+        /// A concept for callables returning a \p Result, optionally taking a \p std::stop_token.
+        template <typename F>
+        concept stoppable_result_invocable = result_invocable<F> ||
+            (std::invocable<F, std::stop_token> &&
+             is_expected_v<std::remove_cvref_t<std::invoke_result_t<F, std::stop_token>>>);
+
+        /// The \p Result type returned by a \p stoppable_result_invocable.
+        template <typename F>
+        struct stoppable_result {
+            using type = std::remove_cvref_t<std::invoke_result_t<F>>;
+        };
+
+        template <typename F>
+            requires std::invocable<F, std::stop_token>
+        struct stoppable_result<F> {
+            using type = std::remove_cvref_t<std::invoke_result_t<F, std::stop_token>>;
+        };
+
+        template <typename F>
+        using stoppable_result_t = typename stoppable_result<F>::type;
+
+        /// Invoke \p func, passing it \p token if it accepts one.
+        /// Exceptions escaping \p func are converted to errors with \p try_catch().
+        template <typename F>
+        [[nodiscard]] stoppable_result_t<F> invoke_stoppable(F &&func, std::stop_token token) {
+            using R = stoppable_result_t<F>;
+            auto result = try_catch([&]() -> R {
+                if constexpr (std::invocable<F, std::stop_token>) {
+                    return std::invoke(std::forward<F>(func), std::move(token));
+                } else {
+                    return std::invoke(std::forward<F>(func));
+                }
+            });
+            if (!result) {
+                return std::unexpected(std::move(result).error());
+            }
+            return std::move(*result);
+        }
+
+        /// State shared by the threads of \p first_of_parallel().
+        template <typename R, std::size_t N>
+        struct parallel_race {
+            std::mutex mutex{};
+            std::condition_variable_any started{};
+            std::stop_source stop{};
+            std::optional<R> winner{};
+            std::array<std::optional<Error>, N> errors{};
+            std::size_t failures{};
+            std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
+
+            /// Record the outcome of alternative \p index, cancelling the others on success.
+            void finish(const std::size_t index, R &&result) {
+                {
+                    std::scoped_lock lock{mutex};
+                    if (result) {
+                        if (!winner) {
+                            winner.emplace(std::move(result));
+                            stop.request_stop();
+                        }
+                        return;
+                    }
+                    errors[index].emplace(std::move(result).error());
+                    ++failures;
+                }
+                started.notify_all();
+            }
+
+            /// Wait until alternative \p index is due to start.
+            ///
+            /// It is due after <tt>index * hedge_delay</tt>, or as soon as \p index alternatives
+            /// have failed, since there is no point in waiting for a backup that is needed anyway.
+            ///
+            /// \return False if a winner was found in the meantime.
+            bool wait_turn(const std::size_t index, const std::chrono::nanoseconds hedge_delay) {
+                if (index == 0 || hedge_delay <= std::chrono::nanoseconds::zero()) {
+                    return !stop.stop_requested();
+                }
+                std::unique_lock lock{mutex};
+                started.wait_until(lock, stop.get_token(), start + hedge_delay * index,
+                                   [this, index] { return failures >= index; });
+                return !stop.stop_requested();
+            }
+        };
+
+        template <AggregateCode Code, std::size_t... I, typename... Fs>
+        [[nodiscard]] auto first_of_parallel(std::index_sequence<I...>, const std::chrono::nanoseconds hedge_delay,
+                                             Fs &&... alternatives) {
+            using R = std::common_type_t<stoppable_result_t<Fs>...>;
+            using Out = AggregateResult<typename R::value_type>;
+            constexpr std::size_t count = sizeof...(Fs);
+
+            parallel_race<R, count> race{};
+            auto run = [&race, hedge_delay]<typename F>(const std::size_t index, F &func) {
+                if (race.wait_turn(index, hedge_delay)) {
+                    race.finish(index, invoke_stoppable(func, race.stop.get_token()));
+                }
+            };
+
+            {
+                // The first alternative runs on the calling thread; the others start after their delay.
+                std::array<std::jthread, count - 1> threads{};
+                auto launch = [&]<std::size_t Index, typename F>(std::integral_constant<std::size_t, Index>, F &func) {
+                    if constexpr (Index > 0) {
+                        threads[Index - 1] = std::jthread{[&run, &func] { run(Index, func); }};
+                    }
+                };
+                (launch(std::integral_constant<std::size_t, I>{}, alternatives), ...);
+
+                auto &first = std::get<0>(std::forward_as_tuple(alternatives...));
+                run(0, first);
+            } // Join all the threads
+
+            if (race.winner) {
+                auto &winner = *race.winner;
+                if constexpr (std::is_void_v<typename R::value_type>) {
+                    return Out{};
+                } else {
+                    return Out{std::in_place, std::move(*winner)};
+                }
+            }
+
+            AggregateError errors{Code};
+            for (auto &error : race.errors) {
+                if (error) {
+                    errors.push_back(std::move(*error));
+                }
+            }
+            return Out{std::unexpect, std::move(errors)};
+        }
+    } // namespace detail
+
+    /// Run alternatives concurrently and return the first successful result.
+    ///
+    /// Each alternative is a callable returning the same \p Result type. It may take a
+    /// \p std::stop_token, which is signalled as soon as another alternative succeeds.
+    /// The first alternative runs on the calling thread, and each of the others on its own thread.
+    ///
+    /// With a non-zero \p hedge_delay, alternative \p i starts only after <tt>i * hedge_delay</tt>,
+    /// or as soon as that many alternatives have failed, and is skipped altogether if an earlier
+    /// one succeeded by then. This issues backup requests only when the primary is slow.
+    ///
+    /// \note The call returns once every started alternative has returned. Alternatives that
+    /// observe their \p std::stop_token return promptly after a winner is found.
+    /// \note Exceptions thrown by an alternative are converted to errors with \p try_catch().
+    ///
+    /// \param hedge_delay Delay between the starts of consecutive alternatives
+    /// \param alternatives The alternatives to run
+    /// \tparam Code The strategy for choosing the overall error code if every alternative fails
+    /// \return First successful result, or the aggregate of all errors in the order of the alternatives
+    template <AggregateCode Code = AggregateCode::last, typename Rep, typename Period, typename... Fs>
+        requires (sizeof...(Fs) > 0) && (detail::stoppable_result_invocable<Fs &> && ...)
+    [[nodiscard]] auto first_of_parallel(const std::chrono::duration<Rep, Period> hedge_delay, Fs &&... alternatives) {
+        return detail::first_of_parallel<Code>(std::index_sequence_for<Fs...>{},
+                                               std::chrono::duration_cast<std::chrono::nanoseconds>(hedge_delay),
+                                               std::forward<Fs>(alternatives)...);
+    }
+
+    /// Run alternatives concurrently, all at once, and return the first successful result.
+    /// \param alternatives The alternatives to run
+    /// \tparam Code The strategy for choosing the overall error code if every alternative fails
+    /// \return First successful result, or the aggregate of all errors in the order of the alternatives
+    /// \see first_of_parallel(std::chrono::duration, Fs &&...)
+    template <AggregateCode Code = AggregateCode::last, typename... Fs>
+        requires (sizeof...(Fs) > 0) && (detail::stoppable_result_invocable<Fs &> && ...)
+    [[nodiscard]] auto first_of_parallel(Fs &&... alternatives) {
+        return detail::first_of_parallel<Code>(std::index_sequence_for<Fs...>{}, std::chrono::nanoseconds::zero(),
+                                               std::forward<Fs>(alternatives)...);
+    }
+
+    /// A fixed-size pool of worker threads that resume coroutines, with work stealing.
+    ///
+    /// Each worker owns a queue. Work posted from a worker goes to the back of its own queue,
+    /// and work posted from elsewhere is spread over the queues in turn. A worker takes from
+    /// the back of its own queue (the most recent work, which is likely still in cache) and,
+    /// when that is empty, steals from the front of the others. Idle workers sleep on a single
+    /// atomic counter instead of spinning.
+    ///
+    /// \note The pool must outlive the coroutines scheduled on it. Its destructor runs the
+    /// work already queued, then joins the workers.
+    class ThreadPool {
+        struct alignas(64) WorkerQueue {
+            std::mutex mutex{};
+            std::deque<std::coroutine_handle<>> handles{};
+        };
+
+        // clang-format off
+        // @formatter:off
+
+        std::size_t size_;                                  ///< Number of workers
+        std::unique_ptr<WorkerQueue[]> queues_;             ///< One queue per worker
+        std::atomic<std::uint32_t> epoch_{};                ///< Bumped whenever work is posted
+        std::atomic<std::size_t> next_{};                   ///< Next queue for external posts
+        std::atomic<bool> stopping_{};                      ///< Set by the destructor
+        std::vector<std::jthread> workers_{};               ///< The worker threads
+
+        inline static thread_local ThreadPool *current_pool_{};   ///< Pool of the calling worker
+        inline static thread_local std::size_t current_index_{};  ///< Index of the calling worker
+
+        // clang-format on
+        // @formatter:on
+
+        [[nodiscard]] static std::coroutine_handle<> pop(WorkerQueue &queue, const bool back) {
+            std::scoped_lock lock{queue.mutex};
+            if (queue.handles.empty()) {
+                return nullptr;
+            }
+            std::coroutine_handle<> handle;
+            if (back) {
+                handle = queue.handles.back();
+                queue.handles.pop_back();
+            } else {
+                handle = queue.handles.front();
+                queue.handles.pop_front();
+            }
+            return handle;
+        }
+
+        /// Take work from the queue of worker \p index, or steal it from another worker.
+        [[nodiscard]] std::coroutine_handle<> take(const std::size_t index) {
+            if (auto handle = pop(queues_[index], true)) {
+                return handle;
+            }
+            for (std::size_t i = 1; i < size_; ++i) {
+                if (auto handle = pop(queues_[(index + i) % size_], false)) {
+                    return handle;
+                }
+            }
+            return nullptr;
+        }
+
+        void run(const std::size_t index) {
+            current_pool_ = this;
+            current_index_ = index;
+            while (true) {
+                const std::uint32_t epoch = epoch_.load(std::memory_order_acquire);
+                if (auto handle = take(index)) {
+                    handle.resume();
+                    continue;
+                }
+                if (stopping_.load(std::memory_order_acquire)) {
+                    break;
+                }
+                epoch_.wait(epoch, std::memory_order_acquire);
+            }
+            current_pool_ = nullptr;
+        }
+
+    public:
+        /// Start a pool of \p threads workers.
+        /// \param threads The number of workers. Defaults to the number of hardware threads.
+        explicit ThreadPool(const std::size_t threads = std::thread::hardware_concurrency())
+            : size_{threads == 0 ? 1 : threads}, queues_{std::make_unique<WorkerQueue[]>(size_)} {
+            workers_.reserve(size_);
+            for (std::size_t i = 0; i < size_; ++i) {
+                workers_.emplace_back([this, i] { run(i); });
+            }
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        ~ThreadPool() {
+            stopping_.store(true, std::memory_order_release);
+            epoch_.fetch_add(1, std::memory_order_release);
+            epoch_.notify_all();
+            workers_.clear(); // Join the workers
+        }
+
+        /// Returns the number of workers.
+        [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+        /// Queue a coroutine to be resumed on one of the workers.
+        /// \param handle The coroutine to resume
+        void post(const std::coroutine_handle<> handle) {
+            const std::size_t index = current_pool_ == this
+                                          ? current_index_
+                                          : next_.fetch_add(1, std::memory_order_relaxed) % size_;
+            {
+                std::scoped_lock lock{queues_[index].mutex};
+                queues_[index].handles.push_back(handle);
+            }
+            epoch_.fetch_add(1, std::memory_order_release);
+            epoch_.notify_one();
+        }
+
+        /// Returns an awaitable that moves the awaiting coroutine onto one of the workers.
+        ///
+        /// \code
+        /// task<IntResult> compute(ThreadPool &pool) {
+        ///     co_await pool.schedule();
+        ///     // Now running on a worker
+        /// }
+        /// \endcode
+        [[nodiscard]] auto schedule() noexcept {
+            struct awaiter {
+                ThreadPool &pool;
+
+                [[nodiscard]] static bool await_ready() noexcept { return false; }
+
+                void await_suspend(const std::coroutine_handle<> handle) const { pool.post(handle); }
+
+                static void await_resume() noexcept {}
+            };
+            return awaiter{*this};
+        }
+    };
+
+    namespace detail {
+        /// A concept for the \p std::expected types a \p task can produce: their error type
+        /// must be \p Error or \p AggregateError.
+        template <typename R>
+        concept task_result = is_expected_v<R> &&
+                              (std::same_as<typename R::error_type, Error> ||
+                               std::same_as<typename R::error_type, AggregateError>);
+
+        /// Convert an \p Error to the error type \p E of a \p task_result.
+        template <typename E>
+        [[nodiscard]] E to_error_type(Error &&error) {
+            if constexpr (std::same_as<E, AggregateError>) {
+                AggregateError errors{AggregateCode::first};
+                errors.push_back(std::move(error));
+                return errors;
+            } else {
+                return std::move(error);
+            }
+        }
+    } // namespace detail
+
+    /// A lazy coroutine producing a \p Result.
+    ///
+    /// The body starts running only when the task is awaited, and resumes the awaiting
+    /// coroutine directly when it completes (symmetric transfer), so chains of tasks do not
+    /// grow the stack. Frames come from the per-thread freelist of \p error_utils_coro.hpp.
+    ///
+    /// Exceptions escaping the body are converted to errors with \p try_catch().
+    ///
+    /// \code
+    /// task<IntResult> parse(ThreadPool &pool, std::string text) {
+    ///     co_await pool.schedule();
+    ///     co_return parse_number(text);
+    /// }
+    /// IntResult number = sync_wait(parse(pool, "42"));
+    /// \endcode
+    ///
+    /// \note A task producing a \p VoidResult completes with <tt>co_return {};</tt>.
+    /// \tparam R The \p Result (or \p AggregateResult) type produced by the task
+    template <detail::task_result R>
+    class [[nodiscard]] task {
+    public:
+        class promise_type {
+            friend class task;
+
+            std::optional<R> result_{};
+            std::coroutine_handle<> continuation_{std::noop_coroutine()};
+
+            struct final_awaiter {
+                [[nodiscard]] static bool await_ready() noexcept { return false; }
+
+                [[nodiscard]] static std::coroutine_handle<>
+                await_suspend(const std::coroutine_handle<promise_type> handle) noexcept {
+                    return handle.promise().continuation_;
+                }
+
+                static void await_resume() noexcept {}
+            };
+
+        public:
+            [[nodiscard]] static void *operator new(const std::size_t size) {
+                return detail::frame_pool::local().allocate(size);
+            }
+
+            static void operator delete(void *frame, const std::size_t size) noexcept {
+                detail::frame_pool::local().deallocate(frame, size);
+            }
+
+            [[nodiscard]] task get_return_object() noexcept {
+                return task{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            [[nodiscard]] static std::suspend_always initial_suspend() noexcept { return {}; }
+
+            [[nodiscard]] static final_awaiter final_suspend() noexcept { return {}; }
+
+            template <typename U = R>
+                requires std::convertible_to<U, R>
+            void return_value(U &&value) {
+                result_.emplace(std::forward<U>(value));
+            }
+
+            void unhandled_exception() {
+                auto result = try_catch([]() -> bool { throw; });
+                result_.emplace(std::unexpect, detail::to_error_type<typename R::error_type>(
+                                                   std::move(result).error()));
+            }
+        };
+
+    private:
+        std::coroutine_handle<promise_type> handle_{};
+
+        explicit task(const std::coroutine_handle<promise_type> handle) noexcept : handle_{handle} {}
+
+    public:
+        task() noexcept = default;
+
+        task(const task &) = delete;
+
+        task &operator=(const task &) = delete;
+
+        task(task &&other) noexcept : handle_{std::exchange(other.handle_, {})} {}
+
+        task &operator=(task &&other) noexcept {
+            if (this == &other) return *this;
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, {});
+            return *this;
+        }
+
+        ~task() {
+            if (handle_) {
+                handle_.destroy();
+            }
+        }
+
+        /// Check whether the task holds a coroutine.
+        [[nodiscard]] explicit operator bool() const noexcept { return static_cast<bool>(handle_); }
+
+        /// Start the task and suspend the awaiting coroutine until it completes.
+        /// \return The result of the task, moved out of it
+        [[nodiscard]] auto operator co_await() && noexcept {
+            struct awaiter {
+                std::coroutine_handle<promise_type> handle;
+
+                [[nodiscard]] bool await_ready() const noexcept { return handle.done(); }
+
+                [[nodiscard]] std::coroutine_handle<>
+                await_suspend(const std::coroutine_handle<> continuation) const noexcept {
+                    handle.promise().continuation_ = continuation;
+                    return handle;
+                }
+
+                [[nodiscard]] R await_resume() const { return std::move(*handle.promise().result_); }
+            };
+            return awaiter{handle_};
+        }
+    };
+
+    namespace detail {
+        /// A fire-and-forget coroutine, destroyed when it completes.
+        struct detached_task {
+            struct promise_type {
+                [[nodiscard]] static void *operator new(const std::size_t size) {
+                    return frame_pool::local().allocate(size);
+                }
+
+                static void operator delete(void *frame, const std::size_t size) noexcept {
+                    frame_pool::local().deallocate(frame, size);
+                }
+
+                [[nodiscard]] static detached_task get_return_object() noexcept { return {}; }
+
+                [[nodiscard]] static std::suspend_never initial_suspend() noexcept { return {}; }
+
+                [[nodiscard]] static std::suspend_never final_suspend() noexcept { return {}; }
+
+                static void return_void() noexcept {}
+
+                // Tasks never throw out of their body
+                [[noreturn]] static void unhandled_exception() noexcept { std::terminate(); }
+            };
+        };
+
+        /// Run \p work to completion, handing its result to \p on_done.
+        template <typename R, typename F>
+        detached_task start_detached(task<R> work, F on_done) {
+            on_done(co_await std::move(work));
+        }
+
+        /// The value type of the \p AggregateResult produced by \p when_all().
+        template <typename T>
+        using when_all_value_t = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+
+        /// Wait for all the tasks, gathering their results by index.
+        template <typename R>
+        class when_all_awaiter {
+            std::vector<task<R>> &tasks_;
+            std::vector<std::optional<R>> results_;
+            std::atomic<std::size_t> remaining_;
+            std::coroutine_handle<> continuation_{};
+
+            void finish(const std::size_t index, R &&result) {
+                results_[index].emplace(std::move(result));
+                if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    continuation_.resume();
+                }
+            }
+
+        public:
+            explicit when_all_awaiter(std::vector<task<R>> &tasks)
+                : tasks_{tasks}, results_(tasks.size()), remaining_{tasks.size() + 1} {}
+
+            [[nodiscard]] bool await_ready() const noexcept { return tasks_.empty(); }
+
+            /// Start every task; the extra count held here keeps a task that completes
+            /// synchronously from resuming the caller before all of them are started.
+            [[nodiscard]] bool await_suspend(const std::coroutine_handle<> continuation) {
+                continuation_ = continuation;
+                for (std::size_t i = 0; i < tasks_.size(); ++i) {
+                    start_detached(std::move(tasks_[i]), [this, i](R &&result) { finish(i, std::move(result)); });
+                }
+                return remaining_.fetch_sub(1, std::memory_order_acq_rel) != 1;
+            }
+
+            [[nodiscard]] AggregateResult<when_all_value_t<typename R::value_type>> await_resume() {
+                using T = typename R::value_type;
+                AggregateError errors{AggregateCode::first};
+                for (auto &result : results_) {
+                    if (!*result) {
+                        if constexpr (std::same_as<typename R::error_type, AggregateError>) {
+                            for (const auto &error : result->error()) {
+                                errors.push_back(error);
+                            }
+                        } else {
+                            errors.push_back(std::move(*result).error());
+                        }
+                    }
+                }
+                if (!errors.empty()) {
+                    return std::unexpected(std::move(errors));
+                }
+                if constexpr (std::is_void_v<T>) {
+                    return {};
+                } else {
+                    std::vector<T> values;
+                    values.reserve(results_.size());
+                    for (auto &result : results_) {
+                        values.push_back(*std::move(*result));
+                    }
+                    return values;
+                }
+            }
+        };
+
+        /// State of \p when_any(), shared with the tasks that may outlive the awaiting coroutine.
+        template <typename R>
+        struct when_any_state {
+            std::vector<std::optional<Error>> errors;
+            std::optional<R> winner{};
+            std::atomic<std::size_t> remaining;
+            std::atomic<bool> decided{};
+            std::atomic<int> gate{2};  ///< Released by the decision and by the end of the start-up
+            std::coroutine_handle<> continuation{};
+
+            explicit when_any_state(const std::size_t count) : errors(count), remaining{count} {}
+
+            void release() {
+                if (gate.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    continuation.resume();
+                }
+            }
+
+            void finish(const std::size_t index, R &&result) {
+                if (result) {
+                    if (!decided.exchange(true, std::memory_order_acq_rel)) {
+                        winner.emplace(std::move(result));
+                        release();
+                    }
+                } else {
+                    if constexpr (std::same_as<typename R::error_type, AggregateError>) {
+                        errors[index].emplace(result.error().to_error());
+                    } else {
+                        errors[index].emplace(std::move(result).error());
+                    }
+                }
+                // The last task to finish reports the failure if nobody succeeded
+                if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 &&
+                    !decided.exchange(true, std::memory_order_acq_rel)) {
+                    release();
+                }
+            }
+        };
+
+        /// Wait for the first task to succeed, or for all of them to fail.
+        template <typename R>
+        class when_any_awaiter {
+            std::vector<task<R>> &tasks_;
+            std::shared_ptr<when_any_state<R>> state_;
+
+        public:
+            explicit when_any_awaiter(std::vector<task<R>> &tasks)
+                : tasks_{tasks}, state_{std::make_shared<when_any_state<R>>(tasks.size())} {}
+
+            [[nodiscard]] static bool await_ready() noexcept { return false; }
+
+            [[nodiscard]] bool await_suspend(const std::coroutine_handle<> continuation) {
+                state_->continuation = continuation;
+                for (std::size_t i = 0; i < tasks_.size(); ++i) {
+                    start_detached(std::move(tasks_[i]), [state = state_, i](R &&result) {
+                        state->finish(i, std::move(result));
+                    });
+                }
+                return state_->gate.fetch_sub(1, std::memory_order_acq_rel) != 1;
+            }
+
+            [[nodiscard]] AggregateResult<typename R::value_type> await_resume() {
+                if (state_->winner) {
+                    if constexpr (std::is_void_v<typename R::value_type>) {
+                        return {};
+                    } else {
+                        return *std::move(*state_->winner);
+                    }
+                }
+                AggregateError errors{AggregateCode::last};
+                for (auto &error : state_->errors) {
+                    errors.push_back(std::move(*error));
+                }
+                return std::unexpected(std::move(errors));
+            }
+        };
+    } // namespace detail
+
+    /// Run a task on the calling thread and block until it completes.
+    ///
+    /// The task may move itself to a \p ThreadPool; the calling thread then waits for it.
+    /// \param work The task to run
+    /// \return The result of the task
+    template <typename R>
+    [[nodiscard]] R sync_wait(task<R> work) {
+        std::mutex mutex;
+        std::condition_variable done;
+        std::optional<R> result;
+
+        detail::start_detached(std::move(work), [&](R &&value) {
+            // Notify under the lock, so that this frame outlives the notification
+            std::scoped_lock lock{mutex};
+            result.emplace(std::move(value));
+            done.notify_one();
+        });
+
+        std::unique_lock lock{mutex};
+        done.wait(lock, [&result] { return result.has_value(); });
+        return std::move(*result);
+    }
+
+    /// Run tasks concurrently and wait for all of them.
+    ///
+    /// The tasks are started in order on the awaiting thread, and run concurrently once they
+    /// move to a \p ThreadPool. Every task runs to completion, even if some of them fail.
+    ///
+    /// \param tasks The tasks to run
+    /// \return The values in the order of the tasks, or the errors of all the failed tasks,
+    /// in the order of the tasks. The overall error code is that of the first of them.
+    template <typename R>
+    task<AggregateResult<detail::when_all_value_t<typename R::value_type>>> when_all(std::vector<task<R>> tasks) {
+        co_return co_await detail::when_all_awaiter<R>{tasks};
+    }
+
+    /// Run tasks concurrently and return the result of the first one to succeed.
+    ///
+    /// The awaiting coroutine resumes as soon as a task succeeds. The remaining tasks keep
+    /// running, detached, and their results are discarded.
+    ///
+    /// \param tasks The tasks to run
+    /// \return The first successful result, or the errors of all the tasks in their order
+    template <typename R>
+    task<AggregateResult<typename R::value_type>> when_any(std::vector<task<R>> tasks) {
+        if (tasks.empty()) {
+            AggregateError errors{};
+            errors.set_error_code(std::make_error_code(std::errc::invalid_argument));
+            co_return std::unexpected(std::move(errors));
+        }
+        co_return co_await detail::when_any_awaiter<R>{tasks};
+    }
+
+    namespace detail {
+        /// Get the result of \p future, converting the exceptions it throws to errors.
+        template <typename T>
+        [[nodiscard]] Result<T> get_future_result(std::future<Result<T>> &future) {
+            if (!future.valid()) {
+                return make_error<T>(std::future_errc::no_state, "Future without a shared state");
+            }
+            auto result = try_catch([&future] { return future.get(); });
+            if (!result) {
+                return std::unexpected(std::move(result).error());
+            }
+            return std::move(*result);
+        }
+
+        /// State shared by a \p FutureGroup and its promises.
+        ///
+        /// Each promise, once fulfilled or broken, claims the next slot of \p order and stores
+        /// its index there. The waiting thread thus learns which futures are ready, in the order
+        /// they completed, by waiting on one atomic at a time, and only reads ready futures.
+        template <typename T>
+        struct future_group_state {
+            // clang-format off
+            // @formatter:off
+
+            std::vector<std::future<Result<T>>> futures;
+            std::unique_ptr<std::atomic<std::size_t>[]> order; ///< Completed indices plus one, in completion order
+            std::atomic<std::size_t> completed{};              ///< Slots of \p order claimed so far
+
+            // clang-format on
+            // @formatter:on
+
+            explicit future_group_state(const std::size_t size)
+                : futures(size), order{std::make_unique<std::atomic<std::size_t>[]>(size)} {}
+
+            void complete(const std::size_t index) noexcept {
+                const std::size_t slot = completed.fetch_add(1, std::memory_order_relaxed);
+                order[slot].store(index + 1, std::memory_order_release);
+                order[slot].notify_one();
+            }
+
+            /// Wait for the completion number \p slot.
+            /// \return The index of the future that completed
+            [[nodiscard]] std::size_t wait(const std::size_t slot) const noexcept {
+                std::size_t value;
+                while ((value = order[slot].load(std::memory_order_acquire)) == 0) {
+                    order[slot].wait(0, std::memory_order_acquire);
+                }
+                return value - 1;
+            }
+        };
+    } // namespace detail
+
+    /// Wait for all the futures and gather their results.
+    ///
+    /// The futures are waited on in order on the calling thread. \p std::future offers no way
+    /// to learn which of several futures completes first without a thread per future, and
+    /// since every result is needed, waiting in order takes as long as the slowest future
+    /// anyway. Producers that can fulfil a \p GroupPromise should use a \p FutureGroup instead,
+    /// which sleeps on a single atomic at a time. Exceptions stored in the futures, such as
+    /// \p std::future_error for a broken promise, are converted to errors with \p try_catch(),
+    /// and invalid futures give \p std::future_errc::no_state.
+    ///
+    /// \param futures The futures to wait for
+    /// \return The values in the order of the futures, or the errors of all the failed futures,
+    /// in their order. The overall error code is that of the first of them.
+    template <typename T>
+    [[nodiscard]] AggregateResult<detail::when_all_value_t<T>> when_all(std::vector<std::future<Result<T>>> futures) {
+        AggregateError errors{AggregateCode::first};
+        auto collect = [&errors](std::future<Result<T>> &future) {
+            auto result = detail::get_future_result(future);
+            if (!result) {
+                errors.push_back(result.error());
+            }
+            return result;
+        };
+
+        if constexpr (std::is_void_v<T>) {
+            for (auto &future : futures) {
+                (void) collect(future);
+            }
+            if (!errors.empty()) {
+                return std::unexpected(std::move(errors));
+            }
+            return {};
+        } else {
+            std::vector<T> values;
+            values.reserve(futures.size());
+            for (auto &future : futures) {
+                auto result = collect(future);
+                if (result && errors.empty()) {
+                    values.push_back(*std::move(result));
+                }
+            }
+            if (!errors.empty()) {
+                return std::unexpected(std::move(errors));
+            }
+            return values;
+        }
+    }
+
+    template <typename T>
+    class FutureGroup;
+
+    /// The promise of a future of a \p FutureGroup.
+    ///
+    /// Fulfilling it, or destroying it unfulfilled, which stores a
+    /// \p std::future_errc::broken_promise error, signals the group.
+    template <typename T>
+    class GroupPromise {
+        std::promise<Result<T>> promise_{};
+        std::shared_ptr<detail::future_group_state<T>> state_{};
+        std::size_t index_{};
+
+        friend class FutureGroup<T>;
+
+        GroupPromise(std::shared_ptr<detail::future_group_state<T>> state, const std::size_t index)
+            : state_{std::move(state)}, index_{index} {
+            state_->futures[index_] = promise_.get_future();
+        }
+
+        void complete() noexcept { std::exchange(state_, nullptr)->complete(index_); }
+
+        void abandon() noexcept {
+            if (state_) {
+                (void) std::promise<Result<T>>{std::move(promise_)}; // Breaks the promise
+                complete();
+            }
+        }
+
+    public:
+        GroupPromise() = default;
+
+        GroupPromise(GroupPromise &&) noexcept = default;
+
+        GroupPromise &operator=(GroupPromise &&other) noexcept {
+            if (this != &other) {
+                abandon();
+                promise_ = std::move(other.promise_);
+                state_ = std::move(other.state_);
+                index_ = other.index_;
+            }
+            return *this;
+        }
+
+        ~GroupPromise() { abandon(); }
+
+        /// Store the result, and signal the group.
+        /// \throw std::future_error If the promise was already fulfilled, or has no state
+        void set_value(Result<T> result) {
+            promise_.set_value(std::move(result));
+            complete();
+        }
+
+        /// Store an exception, to be converted to an error, and signal the group.
+        /// \throw std::future_error If the promise was already fulfilled, or has no state
+        void set_exception(std::exception_ptr exception) {
+            promise_.set_exception(std::move(exception));
+            complete();
+        }
+    };
+
+    /// A fixed number of futures that can be waited on together.
+    ///
+    /// \p std::future has no completion callback, so waiting for the first of several
+    /// futures would take a thread per future. The promises of a group instead signal their
+    /// completion through atomics that the waiting thread sleeps on, one at a time, so
+    /// \p when_all() and \p when_any() cost no thread and do not poll the futures.
+    ///
+    /// \code
+    /// FutureGroup<Reply> replies{replicas.size()};
+    /// for (std::size_t i = 0; i < replicas.size(); ++i) {
+    ///     send_request(replicas[i], replies.promise(i));
+    /// }
+    /// AggregateResult<Reply> fastest = when_any(std::move(replies));
+    /// \endcode
+    template <typename T>
+    class FutureGroup {
+        std::shared_ptr<detail::future_group_state<T>> state_;
+        std::vector<GroupPromise<T>> promises_;
+
+        template <typename U>
+        friend AggregateResult<detail::when_all_value_t<U>> when_all(FutureGroup<U> group);
+
+        template <typename U>
+        friend AggregateResult<U> when_any(FutureGroup<U> group);
+
+    public:
+        /// Create \p size futures and their promises.
+        explicit FutureGroup(const std::size_t size)
+            : state_{std::make_shared<detail::future_group_state<T>>(size)} {
+            promises_.reserve(size);
+            for (std::size_t i = 0; i < size; ++i) {
+                promises_.push_back(GroupPromise<T>{state_, i});
+            }
+        }
+
+        /// Returns the number of futures.
+        [[nodiscard]] std::size_t size() const noexcept { return promises_.size(); }
+
+        /// Take the promise of future \p index, to be handed to its producer.
+        /// The promise is taken only once: later calls return a promise without a state.
+        [[nodiscard]] GroupPromise<T> promise(const std::size_t index) { return std::move(promises_.at(index)); }
+    };
+
+    /// Wait for all the futures of a group and gather their results.
+    ///
+    /// The promises not taken from the group are broken. The calling thread sleeps until the
+    /// last future completes; exceptions stored in the futures are converted to errors.
+    ///
+    /// \param group The futures to wait for
+    /// \return The values in the order of the futures, or the errors of all the failed futures,
+    /// in their order. The overall error code is that of the first of them.
+    template <typename T>
+    [[nodiscard]] AggregateResult<detail::when_all_value_t<T>> when_all(FutureGroup<T> group) {
+        group.promises_.clear();
+        auto &state = *group.state_;
+        for (std::size_t slot = 0; slot < state.futures.size(); ++slot) {
+            (void) state.wait(slot);
+        }
+        // Every future is ready, so getting them in order does not block
+        return when_all(std::move(state.futures));
+    }
+
+    /// Wait for the first future of a group to succeed, or for all of them to fail.
+    ///
+    /// The promises not taken from the group are broken. The calling thread sleeps until a
+    /// future completes, then looks at that future only. The futures still pending when this
+    /// function returns are released by their promises, and their results are discarded.
+    ///
+    /// \param group The futures to wait for
+    /// \return The first successful result, or the errors of all the futures in their order
+    template <typename T>
+    [[nodiscard]] AggregateResult<T> when_any(FutureGroup<T> group) {
+        group.promises_.clear();
+        auto &state = *group.state_;
+        if (state.futures.empty()) {
+            AggregateError errors{};
+            errors.set_error_code(std::make_error_code(std::errc::invalid_argument));
+            return std::unexpected(std::move(errors));
+        }
+
+        std::vector<std::optional<Error>> errors(state.futures.size());
+        for (std::size_t slot = 0; slot < state.futures.size(); ++slot) {
+            const std::size_t index = state.wait(slot);
+            auto result = detail::get_future_result(state.futures[index]);
+            if (result) {
+                if constexpr (std::is_void_v<T>) {
+                    return {};
+                } else {
+                    return AggregateResult<T>{std::in_place, *std::move(result)};
+                }
+            }
+            errors[index].emplace(std::move(result).error());
+        }
+
+        AggregateError aggregate{AggregateCode::last};
+        for (auto &error : errors) {
+            aggregate.push_back(std::move(*error));
+        }
+        return std::unexpected(std::move(aggregate));
+    }
+
+    namespace detail {
+        /// A single thread that requests stops on \p std::stop_source objects at their deadlines.
+        ///
+        /// The deadlines are kept in a min-heap, so the thread sleeps until the earliest one.
+        /// Cancelled timers are dropped as soon as they reach the top of the heap, and the heap
+        /// is compacted once they make up more than half of it, so that it does not grow with
+        /// timers that were cancelled long before their deadline.
+        class timer_service {
+            using clock = std::chrono::steady_clock;
+
+            struct Timer {
+                clock::time_point deadline;
+                std::uint64_t id;
+                std::stop_source source;
+
+                // Reversed, for a min-heap
+                [[nodiscard]] bool operator<(const Timer &other) const noexcept { return deadline > other.deadline; }
+            };
+
+            // clang-format off
+            // @formatter:off
+
+            std::mutex mutex_{};
+            std::condition_variable changed_{};
+            std::vector<Timer> heap_{};                 ///< Pending timers, earliest first
+            std::unordered_set<std::uint64_t> pending_{};   ///< Timers that have neither fired nor been cancelled
+            std::unordered_set<std::uint64_t> cancelled_{}; ///< Cancelled timers still in the heap
+            std::uint64_t next_id_{};
+            bool stopping_{};
+            std::thread thread_{};                      ///< Started with the first timer
+
+            // clang-format on
+            // @formatter:on
+
+            /// Drop the cancelled timers at the top of the heap.
+            void prune() {
+                while (!heap_.empty() && cancelled_.erase(heap_.front().id) != 0) {
+                    std::pop_heap(heap_.begin(), heap_.end());
+                    heap_.pop_back();
+                }
+            }
+
+            /// Drop all the cancelled timers, once they make up more than half of the heap.
+            void compact() {
+                if (cancelled_.size() <= heap_.size() / 2) {
+                    return;
+                }
+                std::erase_if(heap_, [this](const Timer &timer) { return cancelled_.contains(timer.id); });
+                std::make_heap(heap_.begin(), heap_.end());
+                cancelled_.clear();
+            }
+
+            void run() {
+                std::unique_lock lock{mutex_};
+                while (!stopping_) {
+                    prune();
+                    if (heap_.empty()) {
+                        changed_.wait(lock);
+                        continue;
+                    }
+                    if (clock::now() < heap_.front().deadline) {
+                        changed_.wait_until(lock, heap_.front().deadline);
+                        continue;
+                    }
+                    std::pop_heap(heap_.begin(), heap_.end());
+                    Timer timer = std::move(heap_.back());
+                    heap_.pop_back();
+                    pending_.erase(timer.id);
+
+                    lock.unlock();
+                    timer.source.request_stop(); // Runs the stop callbacks
+                    lock.lock();
+                }
+            }
+
+        public:
+            timer_service() = default;
+
+            timer_service(const timer_service &) = delete;
+
+            timer_service &operator=(const timer_service &) = delete;
+
+            ~timer_service() {
+                {
+                    std::scoped_lock lock{mutex_};
+                    stopping_ = true;
+                }
+                changed_.notify_one();
+                if (thread_.joinable()) {
+                    thread_.join();
+                }
+            }
+
+            /// Returns the process-wide timer service.
+            [[nodiscard]] static timer_service &instance() {
+                static timer_service service;
+                return service;
+            }
+
+            /// Request a stop on \p source at \p deadline.
+            /// \return An identifier for \p cancel()
+            [[nodiscard]] std::uint64_t schedule(const clock::time_point deadline, std::stop_source source) {
+                bool earliest;
+                std::uint64_t id;
+                {
+                    std::scoped_lock lock{mutex_};
+                    if (!thread_.joinable()) {
+                        thread_ = std::thread{[this] { run(); }};
+                    }
+                    id = next_id_++;
+                    heap_.push_back(Timer{deadline, id, std::move(source)});
+                    pending_.insert(id);
+                    std::push_heap(heap_.begin(), heap_.end());
+                    earliest = heap_.front().id == id;
+                }
+                if (earliest) {
+                    changed_.notify_one();
+                }
+                return id;
+            }
+
+            /// Cancel a timer that may not have fired yet.
+            void cancel(const std::uint64_t id) {
+                std::scoped_lock lock{mutex_};
+                if (pending_.erase(id) != 0) {
+                    cancelled_.insert(id);
+                    prune();
+                    compact();
+                }
+            }
+
+            /// Returns the number of timers in the heap, including the cancelled ones not yet dropped.
+            [[nodiscard]] std::size_t size() {
+                std::scoped_lock lock{mutex_};
+                return heap_.size();
+            }
+        };
+
+        /// Returns the process-wide pool that runs the callables of \p with_deadline() that do not
+        /// take a \p std::stop_token. It is started by the first such call, and has at least four
+        /// workers, since these callables usually block.
+        [[nodiscard]] inline ThreadPool &deadline_pool() {
+            static ThreadPool pool{std::max<std::size_t>(std::thread::hardware_concurrency(), 4)};
+            return pool;
+        }
+
+        /// Run \p work on one of the workers of \p pool.
+        template <typename R>
+        detached_task run_on(ThreadPool &pool, std::packaged_task<R()> work) {
+            co_await pool.schedule();
+            work();
+        }
+
+        /// Returns the error reported when a deadline is exceeded.
+        template <typename R>
+        [[nodiscard]] R deadline_exceeded(const std::string_view context) {
+            return std::unexpected(Error{std::errc::timed_out, context.empty() ? "Deadline exceeded" : context});
+        }
+    } // namespace detail
+
+    /// Run a callable on a thread pool with a deadline, returning \p std::errc::timed_out if it is
+    /// exceeded.
+    ///
+    /// \p func runs on one of the workers of \p pool, and the call returns the timeout error as
+    /// soon as the deadline passes, whether \p func is still queued or already running. It then
+    /// finishes in the background, so it must not refer to objects that may be destroyed by then.
+    ///
+    /// \param pool The pool to run \p func on
+    /// \param deadline The time by which \p func must complete
+    /// \param func The callable to run. It must return a \p Result and not take a \p std::stop_token.
+    /// \param error_context Context for the timeout error. Defaults to "Deadline exceeded".
+    /// \return The result of \p func, or a \p std::errc::timed_out error
+    template <typename Clock, typename Duration, typename Func>
+        requires detail::stoppable_result_invocable<Func> && (!std::invocable<Func, std::stop_token>)
+    [[nodiscard]] auto with_deadline(ThreadPool &pool, const std::chrono::time_point<Clock, Duration> deadline,
+                                     Func &&func, const std::string_view error_context = {})
+        -> detail::stoppable_result_t<Func> {
+        using R = detail::stoppable_result_t<Func>;
+        const auto steady_deadline = std::chrono::steady_clock::now() +
+                                     std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                         deadline - Clock::now());
+
+        std::packaged_task<R()> work{[func = std::forward<Func>(func)]() mutable {
+            return detail::invoke_stoppable(func, std::stop_token{});
+        }};
+        auto future = work.get_future();
+        detail::run_on(pool, std::move(work));
+
+        if (future.wait_until(steady_deadline) == std::future_status::timeout) {
+            return detail::deadline_exceeded<R>(error_context);
+        }
+        return future.get();
+    }
+
+    /// Run a callable with a deadline, returning \p std::errc::timed_out if it is exceeded.
+    ///
+    /// If \p func takes a \p std::stop_token, it runs on the calling thread, and the token is
+    /// signalled at the deadline by the process-wide timer thread; \p func is expected to give
+    /// up promptly. Its result is returned if it succeeds, even after the deadline, while a
+    /// failure after the deadline is reported as a timeout.
+    ///
+    /// Otherwise, \p func runs on a process-wide pool of helper threads, as with the overload
+    /// taking a \p ThreadPool. The number of helpers is bounded, so when they are all busy, \p func
+    /// waits for one in a queue, and may time out before it starts. Callables that block for long
+    /// should be given a pool of their own.
+    ///
+    /// \param deadline The time by which \p func must complete
+    /// \param func The callable to run. It must return a \p Result.
+    /// \param error_context Context for the timeout error. Defaults to "Deadline exceeded".
+    /// \return The result of \p func, or a \p std::errc::timed_out error
+    template <typename Clock, typename Duration, typename Func>
+        requires detail::stoppable_result_invocable<Func>
+    [[nodiscard]] auto with_deadline(const std::chrono::time_point<Clock, Duration> deadline, Func &&func,
+                                     const std::string_view error_context = {}) -> detail::stoppable_result_t<Func> {
+        using R = detail::stoppable_result_t<Func>;
+
+        if constexpr (std::invocable<Func, std::stop_token>) {
+            const auto steady_deadline = std::chrono::steady_clock::now() +
+                                         std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                             deadline - Clock::now());
+            std::stop_source source;
+            auto &timers = detail::timer_service::instance();
+            const std::uint64_t timer = timers.schedule(steady_deadline, source);
+            R result = detail::invoke_stoppable(std::forward<Func>(func), source.get_token());
+            timers.cancel(timer);
+
+            if (!result && source.stop_requested()) {
+                return detail::deadline_exceeded<R>(error_context);
+            }
+            return result;
+        } else {
+            return with_deadline(detail::deadline_pool(), deadline, std::forward<Func>(func), error_context);
+        }
+    }
+
+    /// Run a callable with a time limit, returning \p std::errc::timed_out if it is exceeded.
+    /// \param timeout The time \p func may take
+    /// \param func The callable to run. It must return a \p Result.
+    /// \param error_context Context for the timeout error. Defaults to "Deadline exceeded".
+    /// \return The result of \p func, or a \p std::errc::timed_out error
+    /// \see with_deadline()
+    template <typename Rep, typename Period, typename Func>
+        requires detail::stoppable_result_invocable<Func>
+    [[nodiscard]] auto with_timeout(const std::chrono::duration<Rep, Period> timeout, Func &&func,
+                                    const std::string_view error_context = {}) -> detail::stoppable_result_t<Func> {
+        return with_deadline(std::chrono::steady_clock::now() + timeout, std::forward<Func>(func), error_context);
+    }
+
+    /// Run a callable on a thread pool with a time limit, returning \p std::errc::timed_out if it
+    /// is exceeded.
+    /// \param pool The pool to run \p func on
+    /// \param timeout The time \p func may take
+    /// \param func The callable to run. It must return a \p Result and not take a \p std::stop_token.
+    /// \param error_context Context for the timeout error. Defaults to "Deadline exceeded".
+    /// \return The result of \p func, or a \p std::errc::timed_out error
+    /// \see with_deadline()
+    template <typename Rep, typename Period, typename Func>
+        requires detail::stoppable_result_invocable<Func> && (!std::invocable<Func, std::stop_token>)
+    [[nodiscard]] auto with_timeout(ThreadPool &pool, const std::chrono::duration<Rep, Period> timeout, Func &&func,
+                                    const std::string_view error_context = {}) -> detail::stoppable_result_t<Func> {
+        return with_deadline(pool, std::chrono::steady_clock::now() + timeout, std::forward<Func>(func),
+                             error_context);
+    }
+
+    namespace detail {
+        /// A concept for callables taking an element of the range \p R and a \p std::stop_token.
+        template <typename F, typename R>
+        concept element_stoppable = std::invocable<F &, std::ranges::range_reference_t<R>, std::stop_token>;
+
+        /// The \p Result type returned by \p F for an element of the range \p R.
+        template <typename F, typename R>
+        struct element_result {
+            using type = std::remove_cvref_t<std::invoke_result_t<F &, std::ranges::range_reference_t<R>>>;
+        };
+
+        template <typename F, typename R>
+            requires element_stoppable<F, R>
+        struct element_result<F, R> {
+            using type =
+                std::remove_cvref_t<std::invoke_result_t<F &, std::ranges::range_reference_t<R>, std::stop_token>>;
+        };
+
+        template <typename F, typename R>
+        using element_result_t = typename element_result<F, R>::type;
+
+        /// A concept for callables mapping the elements of \p R to a \p Result, optionally
+        /// taking a \p std::stop_token.
+        template <typename F, typename R>
+        concept element_result_invocable =
+            (std::invocable<F &, std::ranges::range_reference_t<R>> || element_stoppable<F, R>) &&
+            is_expected_v<element_result_t<F, R>> &&
+            std::same_as<typename element_result_t<F, R>::error_type, Error>;
+
+        /// The \p Result produced by \p parallel_transform().
+        template <typename F, typename R>
+        using parallel_transform_t = Result<when_all_value_t<typename element_result_t<F, R>::value_type>>;
+
+        /// Output slots of \p parallel_transform(), written concurrently at distinct indices.
+        template <typename T>
+        class transform_slots {
+            // std::vector<bool> packs its elements, so they cannot be written concurrently
+            static constexpr bool direct = std::default_initializable<T> && !std::same_as<T, bool>;
+
+            std::conditional_t<direct, std::vector<T>, std::vector<std::optional<T>>> values_;
+
+        public:
+            explicit transform_slots(const std::size_t size) : values_(size) {}
+
+            void set(const std::size_t index, T &&value) {
+                if constexpr (direct) {
+                    values_[index] = std::move(value);
+                } else {
+                    values_[index].emplace(std::move(value));
+                }
+            }
+
+            [[nodiscard]] std::vector<T> take() && {
+                if constexpr (direct) {
+                    return std::move(values_);
+                } else {
+                    std::vector<T> values;
+                    values.reserve(values_.size());
+                    for (auto &value: values_) {
+                        values.push_back(std::move(*value));
+                    }
+                    return values;
+                }
+            }
+        };
+
+        template <>
+        class transform_slots<void> {
+        public:
+            explicit transform_slots(std::size_t) noexcept {}
+        };
+
+        /// State shared by the caller and the workers of \p parallel_transform().
+        ///
+        /// Chunks are claimed in increasing order. The first error requests a stop, after which
+        /// elements past the earliest failed index are skipped, while those before it still run:
+        /// one of them may fail too, and the earliest error must not depend on the timing. For the
+        /// same reason, callables taking a \p std::stop_token get the token of their chunk, which is
+        /// only signalled once the chunk lies past the earliest failed index.
+        template <typename R, typename F>
+        struct parallel_transform_state {
+            using result_type = element_result_t<F, R>;
+
+            // clang-format off
+            // @formatter:off
+
+            std::ranges::iterator_t<R> first;
+            F *func;
+            std::size_t size;
+            std::size_t chunk;
+            std::size_t chunks;
+            transform_slots<typename result_type::value_type> slots;
+            std::stop_source stop{};
+            std::atomic<std::size_t> next_chunk{};  ///< Next chunk to claim
+            std::atomic<std::size_t> done_chunks{}; ///< Chunks processed or skipped
+            std::atomic<std::size_t> cutoff;        ///< Earliest failed index, or \p size
+            std::mutex mutex{};
+            std::optional<Error> error{};           ///< The error at \p cutoff
+            /// The first index and the stop source of the chunks being processed, for callables
+            /// taking a \p std::stop_token
+            std::vector<std::pair<std::size_t, std::stop_source *>> running{};
+
+            // clang-format on
+            // @formatter:on
+
+            parallel_transform_state(const std::ranges::iterator_t<R> first, F *func, const std::size_t size,
+                                     const std::size_t chunk)
+                : first{first}, func{func}, size{size}, chunk{chunk}, chunks{(size + chunk - 1) / chunk},
+                  slots{size}, cutoff{size} {}
+
+            [[nodiscard]] bool skipped(const std::size_t index) const noexcept {
+                return stop.stop_requested() && index >= cutoff.load(std::memory_order_relaxed);
+            }
+
+            void fail(const std::size_t index, Error &&failure) {
+                std::scoped_lock lock{mutex};
+                if (index < cutoff.load(std::memory_order_relaxed)) {
+                    error.emplace(std::move(failure));
+                    cutoff.store(index, std::memory_order_relaxed);
+                }
+                // Under the lock, so that a chunk registering afterwards sees the stop
+                stop.request_stop();
+                for (const auto &[begin, source] : running) {
+                    if (begin >= cutoff.load(std::memory_order_relaxed)) {
+                        source->request_stop();
+                    }
+                }
+            }
+
+            void process(const std::size_t begin, [[maybe_unused]] const std::stop_token &token) {
+                const std::size_t end = std::min(begin + chunk, size);
+                for (std::size_t i = begin; i < end && !skipped(i); ++i) {
+                    auto result = try_catch([this, i, &token]() -> result_type {
+                        auto &&element = first[static_cast<std::ranges::range_difference_t<R>>(i)];
+                        if constexpr (element_stoppable<F, R>) {
+                            return std::invoke(*func, std::forward<decltype(element)>(element), token);
+                        } else {
+                            return std::invoke(*func, std::forward<decltype(element)>(element));
+                        }
+                    });
+                    if (!result) {
+                        fail(i, std::move(result).error());
+                    } else if (!*result) {
+                        fail(i, std::move(*result).error());
+                    } else if constexpr (!std::is_void_v<typename result_type::value_type>) {
+                        slots.set(i, std::move(**result));
+                    }
+                }
+            }
+
+            void run_chunk(const std::size_t begin) {
+                if constexpr (element_stoppable<F, R>) {
+                    std::stop_source chunk_stop;
+                    const std::pair entry{begin, &chunk_stop};
+                    {
+                        std::scoped_lock lock{mutex};
+                        if (skipped(begin)) {
+                            return;
+                        }
+                        running.push_back(entry);
+                    }
+                    process(begin, chunk_stop.get_token());
+                    std::scoped_lock lock{mutex};
+                    std::erase(running, entry);
+                } else {
+                    process(begin, {});
+                }
+            }
+
+            /// Claim and process chunks until there are none left.
+            void run() {
+                for (std::size_t c; (c = next_chunk.fetch_add(1, std::memory_order_relaxed)) < chunks;) {
+                    if (!skipped(c * chunk)) {
+                        run_chunk(c * chunk);
+                    }
+                    if (done_chunks.fetch_add(1, std::memory_order_acq_rel) + 1 == chunks) {
+                        done_chunks.notify_all();
+                    }
+                }
+            }
+
+            /// Wait until every chunk has been processed or skipped.
+            void wait() const noexcept {
+                for (std::size_t done; (done = done_chunks.load(std::memory_order_acquire)) != chunks;) {
+                    done_chunks.wait(done, std::memory_order_acquire);
+                }
+            }
+        };
+
+        /// Run \p state on one of the workers of \p pool.
+        template <typename State>
+        detached_task run_on(ThreadPool &pool, std::shared_ptr<State> state) {
+            co_await pool.schedule();
+            state->run();
+        }
+    } // namespace detail
+
+    /// Apply a \p Result-returning callable to every element of a range, in parallel.
+    ///
+    /// The range is split into chunks, which the workers of \p pool and the calling thread
+    /// claim in order. As soon as an element fails, the workers are asked to stop, and skip
+    /// the elements after it. The elements before it are
+    /// still transformed, so the error returned is always that of the earliest failed element,
+    /// regardless of the scheduling.
+    ///
+    /// If \p func also takes a \p std::stop_token, the token is signalled for the elements after
+    /// the earliest failed one, so that a long element in flight may give up, returning an error
+    /// of its own. The elements before it are never asked to stop, so the error returned still
+    /// does not depend on the scheduling.
+    ///
+    /// Since the calling thread takes part in the work, this may be called from a worker of
+    /// \p pool without deadlocking.
+    ///
+    /// \code
+    /// ThreadPool pool;
+    /// Result<std::vector<int>> numbers = parallel_transform(lines, parse_number, pool);
+    /// \endcode
+    ///
+    /// \param range The elements to transform. Its elements may be read from several threads.
+    /// \param func The callable to apply, with an element and optionally a \p std::stop_token.
+    /// It is invoked concurrently from several threads. Exceptions escaping it are converted
+    /// to errors with \p try_catch().
+    /// \param pool The pool providing the workers
+    /// \param chunk_size The number of elements per chunk, or 0 to pick one from the size of
+    /// the range and the number of workers
+    /// \return The transformed values in the order of the range (nothing for \p VoidResult),
+    /// or the error of the earliest failed element
+    template <std::ranges::random_access_range R, typename Func>
+        requires std::ranges::sized_range<R> && detail::element_result_invocable<std::remove_reference_t<Func>, R>
+    [[nodiscard]] auto parallel_transform(R &&range, Func &&func, ThreadPool &pool, std::size_t chunk_size = 0)
+        -> detail::parallel_transform_t<std::remove_reference_t<Func>, R> {
+        using State = detail::parallel_transform_state<R, std::remove_reference_t<Func>>;
+
+        const auto size = static_cast<std::size_t>(std::ranges::size(range));
+        if (size == 0) {
+            return {};
+        }
+        const std::size_t threads = pool.size() + 1; // The caller helps
+        if (chunk_size == 0) {
+            // A few chunks per thread, to balance uneven elements
+            chunk_size = std::max<std::size_t>(1, size / (threads * 4));
+        }
+
+        const auto state = std::make_shared<State>(std::ranges::begin(range), std::addressof(func), size, chunk_size);
+        if constexpr (detail::element_stoppable<std::remove_reference_t<Func>, R>) {
+            state->running.reserve(threads);
+        }
+        for (std::size_t i = 0, helpers = std::min(pool.size(), state->chunks - 1); i < helpers; ++i) {
+            detail::run_on(pool, state);
+        }
+        state->run();
+        state->wait();
+
+        // Every failure happened before the last chunk was counted
+        if (state->error) {
+            return std::unexpected(std::move(*state->error));
+        }
+        if constexpr (requires { std::move(state->slots).take(); }) {
+            return std::move(state->slots).take();
+        } else {
+            return {};
+        }
+    }
+} // namespace error_utils
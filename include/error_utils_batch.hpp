@@ -0,0 +1,378 @@
+// MIT License
+//
+// Copyright (c) 2025 Ian Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+/// \file
+/// \brief Bulk validation of contiguous data, reporting failures as a bitmask.
+///
+/// \details Validating millions of values with one \p Result each is too heavy for columnar
+/// data. \p validate_batch() checks a whole span with a predicate and records the failures
+/// in a \p FailureMask, one bit per value; the \p Error of a failing value is only created
+/// when it is asked for. The predicates \p in_range(), \p is_non_null and \p is_finite are
+/// branch-free, so that the compiler can vectorize the loop.
+
+#pragma once
+
+/// \cond
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+/// \endcond
+
+#include "error_utils.hpp"
+
+
+namespace error_utils {
+    /// One bit per validated value, set when the value failed validation.
+    class FailureMask {
+        // clang-format off
+        // @formatter:off
+
+        std::vector<std::uint64_t> words_{};   ///< The bits, 64 values per word
+        std::size_t size_{};                   ///< The number of values
+
+        // clang-format on
+        // @formatter:on
+
+    public:
+        /// The number of values covered by a word of the mask.
+        static constexpr std::size_t word_bits = 64;
+
+        /// A forward iterator over the indices of the failed values, in increasing order.
+        class iterator {
+            const std::uint64_t *word_{};
+            const std::uint64_t *end_{};
+            std::uint64_t bits_{};
+            std::size_t base_{};
+
+            /// Move to the next word with a bit set, or to the end.
+            constexpr void settle() noexcept {
+                while (bits_ == 0 && word_ != end_) {
+                    if (++word_ != end_) {
+                        bits_ = *word_;
+                        base_ += word_bits;
+                    }
+                }
+            }
+
+        public:
+            using value_type = std::size_t;
+            using difference_type = std::ptrdiff_t;
+            using iterator_concept = std::forward_iterator_tag;
+
+            constexpr iterator() noexcept = default;
+
+            constexpr iterator(const std::uint64_t *begin, const std::uint64_t *end) noexcept
+                : word_{begin}, end_{end}, bits_{begin != end ? *begin : 0} { settle(); }
+
+            [[nodiscard]] constexpr std::size_t operator*() const noexcept {
+                return base_ + static_cast<std::size_t>(std::countr_zero(bits_));
+            }
+
+            constexpr iterator &operator++() noexcept {
+                bits_ &= bits_ - 1;
+                settle();
+                return *this;
+            }
+
+            constexpr iterator operator++(int) noexcept {
+                auto copy = *this;
+                ++*this;
+                return copy;
+            }
+
+            [[nodiscard]] constexpr bool operator==(const iterator &other) const noexcept {
+                return word_ == other.word_ && bits_ == other.bits_;
+            }
+        };
+
+        constexpr FailureMask() noexcept = default;
+
+        /// Create a mask for \p size values, none of which failed.
+        constexpr explicit FailureMask(const std::size_t size)
+            : words_((size + word_bits - 1) / word_bits), size_{size} {}
+
+        /// \return The number of values covered by the mask
+        [[nodiscard]] constexpr std::size_t size() const noexcept { return size_; }
+
+        /// \return The number of failed values
+        [[nodiscard]] constexpr std::size_t count() const noexcept {
+            std::size_t total = 0;
+            for (const std::uint64_t word : words_) {
+                total += static_cast<std::size_t>(std::popcount(word));
+            }
+            return total;
+        }
+
+        /// \return True if no value failed
+        [[nodiscard]] constexpr bool none() const noexcept {
+            return std::ranges::all_of(words_, [](const std::uint64_t word) { return word == 0; });
+        }
+
+        /// \return True if the value at \p index failed
+        [[nodiscard]] constexpr bool test(const std::size_t index) const noexcept {
+            return (words_[index / word_bits] >> (index % word_bits) & 1) != 0;
+        }
+
+        /// Mark the value at \p index as failed.
+        constexpr void set(const std::size_t index) noexcept {
+            words_[index / word_bits] |= std::uint64_t{1} << (index % word_bits);
+        }
+
+        /// \return The words of the mask. Bit \p i of word \p w is the value at <tt>w * 64 + i</tt>.
+        [[nodiscard]] constexpr std::span<const std::uint64_t> words() const noexcept { return words_; }
+
+        /// \return The words of the mask, for kernels that fill them directly.
+        [[nodiscard]] constexpr std::span<std::uint64_t> words() noexcept { return words_; }
+
+        /// \return The indices of the failed values, in increasing order
+        [[nodiscard]] constexpr std::ranges::subrange<iterator> indices() const noexcept {
+            const auto *begin = words_.data();
+            const auto *end = begin + words_.size();
+            return {iterator{begin, end}, iterator{end, end}};
+        }
+
+        /// Merge the failures of another mask of the same size, such as another check on the same data.
+        constexpr FailureMask &operator|=(const FailureMask &other) noexcept {
+            for (std::size_t i = 0; i < words_.size() && i < other.words_.size(); ++i) {
+                words_[i] |= other.words_[i];
+            }
+            return *this;
+        }
+
+        [[nodiscard]] constexpr bool operator==(const FailureMask &) const noexcept = default;
+    };
+
+    /// The outcome of \p validate_batch(): a \p FailureMask and the error to report for each failure.
+    ///
+    /// The \p Error of a failed value is only materialized when \p error_at() or \p errors() is called.
+    class BatchValidation {
+        // clang-format off
+        // @formatter:off
+
+        FailureMask failures_{};        ///< The failed values
+        std::error_code code_{};        ///< The code of the error of every failed value
+        std::string context_{};         ///< The context of the errors, without the index
+
+        // clang-format on
+        // @formatter:on
+
+    public:
+        BatchValidation() = default;
+
+        BatchValidation(FailureMask failures, const std::error_code &code, const std::string_view context)
+            : failures_{std::move(failures)}, code_{code}, context_{context} {}
+
+        /// \return True if every value passed validation
+        [[nodiscard]] bool ok() const noexcept { return failures_.none(); }
+
+        /// \return True if every value passed validation
+        [[nodiscard]] explicit operator bool() const noexcept { return ok(); }
+
+        /// \return The mask of the failed values
+        [[nodiscard]] const FailureMask &failures() const noexcept { return failures_; }
+
+        /// \return The number of failed values
+        [[nodiscard]] std::size_t failure_count() const noexcept { return failures_.count(); }
+
+        /// \return The code reported for the failed values
+        [[nodiscard]] const std::error_code &error_code() const noexcept { return code_; }
+
+        /// Create the error of the value at \p index.
+        /// \param index The index of a value, usually a failed one
+        /// \return An error with the code of the batch, and its context followed by the index
+        [[nodiscard]] Error error_at(const std::size_t index) const {
+            if (context_.empty()) {
+                return Error{code_, std::format("At index {}", index)};
+            }
+            return Error{code_, std::format("{} (at index {})", context_, index)};
+        }
+
+        /// \return A lazy view of the errors of the failed values, in increasing index order
+        [[nodiscard]] auto errors() const {
+            return failures_.indices() | std::views::transform([this](const std::size_t i) { return error_at(i); });
+        }
+
+        /// \return Success, or the error of the first failed value
+        [[nodiscard]] VoidResult first_error() const {
+            const auto indices = failures_.indices();
+            if (indices.empty()) {
+                return {};
+            }
+            return std::unexpected(error_at(*indices.begin()));
+        }
+    };
+
+    namespace detail {
+        /// A branch-free check that a value is within a closed interval.
+        template <typename T>
+        struct range_check {
+            T min;
+            T max;
+
+            [[nodiscard]] constexpr bool operator()(const T &value) const noexcept {
+                return static_cast<bool>(static_cast<int>(min <= value) & static_cast<int>(value <= max));
+            }
+        };
+
+        /// A check that a pointer-like value is not null.
+        struct non_null_check {
+            template <typename T>
+                requires requires(const T &value) { { value != nullptr } -> std::convertible_to<bool>; }
+            [[nodiscard]] constexpr bool operator()(const T &value) const noexcept { return value != nullptr; }
+        };
+
+        /// A branch-free check that a floating-point value is neither infinite nor NaN.
+        ///
+        /// It compares the exponent bits as an integer, since \p std::isfinite() is a library
+        /// call that the compiler does not vectorize.
+        struct finite_check {
+            template <std::floating_point T>
+            [[nodiscard]] constexpr bool operator()(const T value) const noexcept {
+                if constexpr (std::numeric_limits<T>::is_iec559 && sizeof(T) == sizeof(std::uint32_t)) {
+                    return (std::bit_cast<std::uint32_t>(value) & 0x7f80'0000U) != 0x7f80'0000U;
+                } else if constexpr (std::numeric_limits<T>::is_iec559 && sizeof(T) == sizeof(std::uint64_t)) {
+                    return (std::bit_cast<std::uint64_t>(value) & 0x7ff0'0000'0000'0000ULL) !=
+                           0x7ff0'0000'0000'0000ULL;
+                } else {
+                    return value - value == T{};  // Infinities and NaN give NaN
+                }
+            }
+        };
+
+        /// Check 64 values, returning a word with a bit set for each failed value.
+        ///
+        /// With AVX2, the compiler vectorizes the plain loop, shifts included. Without it, the
+        /// predicate results are stored as bytes, then packed eight at a time with a
+        /// multiplication that gathers the low bit of each byte into the top byte, which is
+        /// cheaper than 64 scalar shifts.
+        template <typename T, typename Pred>
+        [[nodiscard]] constexpr std::uint64_t validate_word(const T *values, const Pred &pred) {
+            std::uint64_t bits = 0;
+#if defined(__AVX2__)
+            for (std::size_t i = 0; i < 64; ++i) {
+                bits |= static_cast<std::uint64_t>(!std::invoke(pred, values[i])) << i;
+            }
+#else
+            std::array<std::uint8_t, 64> failed;
+            for (std::size_t i = 0; i < failed.size(); ++i) {
+                failed[i] = static_cast<std::uint8_t>(!std::invoke(pred, values[i]));
+            }
+            for (std::size_t byte = 0; byte < failed.size() / 8; ++byte) {
+                std::uint64_t eight = 0;
+                for (std::size_t i = 0; i < 8; ++i) {
+                    eight |= std::uint64_t{failed[byte * 8 + i]} << (i * 8);
+                }
+                bits |= (eight * 0x0102'0408'1020'4080ULL >> 56) << (byte * 8);
+            }
+#endif
+            return bits;
+        }
+
+        /// Check the last \p count values of a batch, fewer than 64, one at a time.
+        template <typename T, typename Pred>
+        [[nodiscard]] constexpr std::uint64_t validate_tail(const T *values, const std::size_t count,
+                                                            const Pred &pred) {
+            std::uint64_t bits = 0;
+            for (std::size_t i = 0; i < count; ++i) {
+                bits |= static_cast<std::uint64_t>(!std::invoke(pred, values[i])) << i;
+            }
+            return bits;
+        }
+    } // namespace detail
+
+    /// A check that values are within <tt>[min, max]</tt>. NaN is out of every range.
+    template <typename T>
+    [[nodiscard]] constexpr detail::range_check<T> in_range(const T min, const T max) noexcept {
+        return {min, max};
+    }
+
+    /// A check that pointers (or any type comparable with \p nullptr) are not null.
+    inline constexpr detail::non_null_check is_non_null{};
+
+    /// A check that floating-point values are neither infinite nor NaN.
+    inline constexpr detail::finite_check is_finite{};
+
+    /// Validate a contiguous range of values in bulk.
+    ///
+    /// The values are checked 64 at a time, each block giving one word of the \p FailureMask
+    /// without branches, so simple predicates are vectorized. No \p Error is created here.
+    ///
+    /// \code
+    /// std::vector<double> prices = load_column("price");
+    /// auto check = validate_batch(prices, in_range(0.0, 1e6), std::errc::result_out_of_range, "Bad price");
+    /// if (!check) {
+    ///     for (const Error &error : check.errors() | std::views::take(10)) {
+    ///         log(error.message());
+    ///     }
+    /// }
+    /// \endcode
+    ///
+    /// \param values The values to check, such as a \p std::span<const T>
+    /// \param pred A predicate returning true for a valid value
+    /// \param code The error code reported for the values that fail the predicate
+    /// \param context The context of the errors, which also report the index of the value
+    /// \return The failures, with the errors materialized on demand
+    template <std::ranges::contiguous_range R, typename Pred>
+        requires std::ranges::sized_range<R> &&
+                 std::predicate<const Pred &, const std::ranges::range_value_t<R> &>
+    [[nodiscard]] BatchValidation validate_batch(R &&values, const Pred &pred, const std::error_code &code,
+                                                 const std::string_view context = {}) {
+        const std::span<const std::ranges::range_value_t<R>> span{values};
+        FailureMask failures{span.size()};
+        const auto words = failures.words();
+        const std::size_t full = span.size() / FailureMask::word_bits;
+
+        for (std::size_t w = 0; w < full; ++w) {
+            words[w] = detail::validate_word(span.data() + w * FailureMask::word_bits, pred);
+        }
+        if (const std::size_t rest = span.size() % FailureMask::word_bits; rest != 0) {
+            words[full] = detail::validate_tail(span.data() + full * FailureMask::word_bits, rest, pred);
+        }
+        return {std::move(failures), code, context};
+    }
+
+    /// Validate a contiguous range of values in bulk, reporting failures with an error code enum.
+    /// \see validate_batch()
+    template <std::ranges::contiguous_range R, typename Pred>
+        requires std::ranges::sized_range<R> &&
+                 std::predicate<const Pred &, const std::ranges::range_value_t<R> &>
+    [[nodiscard]] BatchValidation validate_batch(R &&values, const Pred &pred,
+                                                 const detail::convertible_to_error_code auto code,
+                                                 const std::string_view context = {}) {
+        return validate_batch(std::forward<R>(values), pred, std::error_code{make_error_code(code)}, context);
+    }
+} // namespace error_utils
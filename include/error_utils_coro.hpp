@@ -0,0 +1,291 @@
+// MIT License
+//
+// Copyright (c) 2025 Ian Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+/// \file
+/// \brief Coroutine support for \p Result<T>.
+///
+/// \details Including this header turns any function returning \p Result<T> that uses
+/// \p co_await or \p co_return into a synchronous coroutine. <tt>co_await result</tt> yields
+/// the value of a successful \p Result, and returns the error from the enclosing function
+/// otherwise:
+///
+/// \code
+/// Result<int> get_file_size(const std::string &filename) {
+///     const std::string content = co_await read_file(filename);
+///     co_return static_cast<int>(content.size());
+/// }
+/// \endcode
+///
+/// The coroutine runs to completion (or to the first error) before the call returns.
+/// Its frame is taken from a per-thread freelist, and it is destroyed by the caller,
+/// so compilers that implement heap allocation elision can place it on the caller's stack.
+///
+/// \note The return object is converted to \p Result<T> after the body has run. GCC and
+/// Clang 17+ do this; compilers converting it eagerly (before the body) are rejected.
+
+#pragma once
+
+#if defined(__apple_build_version__) && __clang_major__ < 16
+#error "error_utils_coro.hpp needs Apple Clang 16 or later, which converts the return object of a coroutine late"
+#elif defined(__clang__) && !defined(__apple_build_version__) && __clang_major__ < 17
+#error "error_utils_coro.hpp needs Clang 17 or later, which converts the return object of a coroutine late"
+#elif defined(_MSC_VER) && !defined(__clang__)
+#error "error_utils_coro.hpp does not support MSVC, which converts the return object of a coroutine eagerly"
+#endif
+
+/// \cond
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+/// \endcond
+
+#include "error_utils.hpp"
+
+
+namespace error_utils {
+    namespace detail {
+        /// A per-thread cache of coroutine frames, in size classes of 64 bytes up to 1 KiB.
+        ///
+        /// Frames are allocated and released on the same thread in the common case, so the
+        /// freelists need no synchronization. A frame released on another thread simply joins
+        /// that thread's cache; every block of a class has the same size, wherever it came from.
+        class frame_pool {
+            // clang-format off
+            // @formatter:off
+
+            static constexpr std::size_t granularity = 64;  ///< Size class granularity
+            static constexpr std::size_t classes = 16;      ///< Number of size classes
+            static constexpr std::size_t max_cached = 64;   ///< Maximum cached frames per class
+
+            struct node { node *next; };
+
+            std::array<node *, classes> free_{};            ///< Freelist heads
+            std::array<std::size_t, classes> cached_{};     ///< Freelist lengths
+
+            // clang-format on
+            // @formatter:on
+
+            [[nodiscard]] static constexpr std::size_t size_class(const std::size_t size) noexcept {
+                return (size - 1) / granularity;
+            }
+
+        public:
+            frame_pool() noexcept = default;
+
+            frame_pool(const frame_pool &) = delete;
+
+            frame_pool &operator=(const frame_pool &) = delete;
+
+            ~frame_pool() {
+                for (std::size_t i = 0; i < classes; ++i) {
+                    while (free_[i] != nullptr) {
+                        node *next = free_[i]->next;
+                        ::operator delete(free_[i], (i + 1) * granularity);
+                        free_[i] = next;
+                    }
+                }
+            }
+
+            /// Returns the pool of the calling thread.
+            [[nodiscard]] static frame_pool &local() noexcept {
+                thread_local frame_pool pool;
+                return pool;
+            }
+
+            [[nodiscard]] void *allocate(const std::size_t size) {
+                const std::size_t index = size_class(size);
+                if (index >= classes) {
+                    return ::operator new(size);
+                }
+                if (node *frame = free_[index]; frame != nullptr) {
+                    free_[index] = frame->next;
+                    --cached_[index];
+                    return frame;
+                }
+                return ::operator new((index + 1) * granularity);
+            }
+
+            void deallocate(void *frame, const std::size_t size) noexcept {
+                const std::size_t index = size_class(size);
+                if (index >= classes) {
+                    ::operator delete(frame, size);
+                    return;
+                }
+                if (cached_[index] == max_cached) {
+                    ::operator delete(frame, (index + 1) * granularity);
+                    return;
+                }
+                free_[index] = ::new(frame) node{free_[index]};
+                ++cached_[index];
+            }
+        };
+
+        /// The awaiter for <tt>co_await</tt> on a \p std::expected inside a \p Result coroutine.
+        ///
+        /// The operand is held by reference: a temporary lives until the end of the full
+        /// expression, which spans the suspension. The value of an rvalue operand is moved out,
+        /// while that of an lvalue is returned by reference.
+        ///
+        /// On error, the coroutine stays suspended and its error is recorded in the promise,
+        /// so control returns straight to the caller.
+        template <typename Expected>
+        struct result_awaiter {
+            using value_type = typename std::remove_cvref_t<Expected>::value_type;
+            using resume_type = std::conditional_t<std::is_lvalue_reference_v<Expected>,
+                                                   decltype(*std::declval<Expected>()), value_type>;
+
+            Expected result;
+
+            [[nodiscard]] bool await_ready() const noexcept { return result.has_value(); }
+
+            template <typename Promise>
+            void await_suspend(std::coroutine_handle<Promise> handle) {
+                handle.promise().set_error(std::forward<Expected>(result).error());
+            }
+
+            resume_type await_resume() {
+                if constexpr (!std::is_void_v<value_type>) {
+                    return *std::forward<Expected>(result);
+                }
+            }
+        };
+
+        template <typename T>
+        class result_promise;
+
+        /// The object returned to the caller of a \p Result coroutine.
+        ///
+        /// It converts to the \p Result once the body has run, and destroys the frame afterward.
+        template <typename T>
+        class result_return {
+            std::coroutine_handle<result_promise<T>> handle_;
+
+        public:
+            explicit result_return(const std::coroutine_handle<result_promise<T>> handle) noexcept : handle_{handle} {}
+
+            result_return(const result_return &) = delete;
+
+            result_return &operator=(const result_return &) = delete;
+
+            ~result_return() {
+                if (handle_) {
+                    handle_.destroy();
+                }
+            }
+
+            operator Result<T>() { // NOLINT(*-explicit-constructor)
+                auto &result = handle_.promise().result_;
+                if (!result.has_value()) [[unlikely]] {
+                    // Converted before the body ran: there is no result to return
+                    std::terminate();
+                }
+                return std::move(*result);
+            }
+        };
+
+        /// The part of the promise that does not depend on whether \p T is \p void.
+        template <typename T>
+        class result_promise_base {
+            friend class result_return<T>;
+
+        protected:
+            std::optional<Result<T>> result_{};
+
+        public:
+            [[nodiscard]] static void *operator new(const std::size_t size) {
+                return frame_pool::local().allocate(size);
+            }
+
+            static void operator delete(void *frame, const std::size_t size) noexcept {
+                frame_pool::local().deallocate(frame, size);
+            }
+
+            [[nodiscard]] result_return<T> get_return_object() noexcept {
+                return result_return<T>{
+                    std::coroutine_handle<result_promise<T>>::from_promise(static_cast<result_promise<T> &>(*this))
+                };
+            }
+
+            [[nodiscard]] static std::suspend_never initial_suspend() noexcept { return {}; }
+
+            // The caller destroys the frame once it has taken the result
+            [[nodiscard]] static std::suspend_always final_suspend() noexcept { return {}; }
+
+            /// Convert an exception escaping the body to an error, as \p try_catch() does.
+            void unhandled_exception() {
+                auto result = try_catch([]() -> bool { throw; });
+                set_error(std::move(result).error());
+            }
+
+            /// Record the error of an awaited \p Result.
+            void set_error(Error error) { result_.emplace(std::unexpect, std::move(error)); }
+
+            template <typename U, typename E>
+                requires std::convertible_to<E, Error>
+            [[nodiscard]] static result_awaiter<std::expected<U, E> &&> await_transform(std::expected<U, E> &&result) {
+                return {std::move(result)};
+            }
+
+            template <typename U, typename E>
+                requires std::convertible_to<E, Error>
+            [[nodiscard]] static result_awaiter<std::expected<U, E> &> await_transform(std::expected<U, E> &result) {
+                return {result};
+            }
+
+            template <typename U, typename E>
+                requires std::convertible_to<E, Error>
+            [[nodiscard]] static result_awaiter<const std::expected<U, E> &>
+            await_transform(const std::expected<U, E> &result) {
+                return {result};
+            }
+        };
+
+        /// The promise type of coroutines returning \p Result<T>.
+        template <typename T>
+        class result_promise : public result_promise_base<T> {
+        public:
+            template <typename U = T>
+                requires std::convertible_to<U, Result<T>>
+            void return_value(U &&value) {
+                this->result_.emplace(std::forward<U>(value));
+            }
+        };
+
+        template <>
+        class result_promise<void> : public result_promise_base<void> {
+        public:
+            void return_void() { this->result_.emplace(); }
+        };
+    } // namespace detail
+} // namespace error_utils
+
+/// Make functions returning \p Result<T> that use \p co_await or \p co_return coroutines.
+template <typename T, typename... Args>
+struct std::coroutine_traits<error_utils::Result<T>, Args...> {
+    using promise_type = error_utils::detail::result_promise<T>;
+};
@@ -0,0 +1,909 @@
+// MIT License
+//
+// Copyright (c) 2025 Ian Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+/// \file
+/// \brief Diagnostics of the errors of a running process.
+///
+/// \details \p FlightRecorder keeps the last errors of each thread in preallocated rings, so
+/// that a crash handler can dump the errors that led to the crash. Recording copies the error
+/// into a slot owned by the calling thread, without locks or allocation, and dumping is
+/// async-signal-safe.
+///
+/// \p RateLimitedLog writes errors to a log from a background thread, and collapses repeats of
+/// the same error within a time window into a single "repeated N times" line, so that an error
+/// storm costs an atomic increment per error instead of a formatted line.
+
+#pragma once
+
+/// \cond
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <source_location>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#endif
+/// \endcond
+
+#include "error_utils.hpp"
+
+
+namespace error_utils {
+    /// An error kept by a \p FlightRecorder.
+    struct ErrorRecord {
+        // clang-format off
+        // @formatter:off
+
+        /// The maximum length of the context; longer contexts are truncated.
+        static constexpr std::size_t context_capacity = 64;
+
+        std::int64_t timestamp{};                       ///< Nanoseconds since the epoch of \p system_clock
+        std::uint64_t thread{};                         ///< The id of the thread in the operating system
+        const std::error_category *category{};          ///< The category of the error code
+        const char *file{};                             ///< The source file where the error was created
+        int value{};                                    ///< The value of the error code
+        std::uint32_t line{};                           ///< The line where the error was created
+        std::uint32_t length{};                         ///< The length of the (truncated) context
+        std::array<char, context_capacity> context{};   ///< The context, not null-terminated
+
+        // clang-format on
+        // @formatter:on
+
+        /// \return The error code of the record
+        [[nodiscard]] std::error_code code() const noexcept { return {value, *category}; }
+
+        /// \return The context of the record, truncated to \p context_capacity characters
+        [[nodiscard]] std::string_view context_view() const noexcept { return {context.data(), length}; }
+    };
+
+    namespace detail {
+        /// A slot of a recorder ring, protected by a sequence lock.
+        ///
+        /// The sequence is odd while the owning thread writes the slot, and zero until the slot
+        /// is first written. Every field is atomic, so that a reader racing with the writer only
+        /// needs to check that the sequence did not change.
+        struct recorder_slot {
+            static constexpr std::size_t context_words = ErrorRecord::context_capacity / sizeof(std::uint64_t);
+
+            std::atomic<std::uint64_t> sequence{};
+            std::atomic<std::int64_t> timestamp{};
+            std::atomic<std::uint64_t> thread{};
+            std::atomic<const std::error_category *> category{};
+            std::atomic<const char *> file{};
+            std::atomic<int> value{};
+            std::atomic<std::uint32_t> line{};
+            std::atomic<std::uint32_t> length{};
+            std::array<std::atomic<std::uint64_t>, context_words> context{};
+
+            /// Overwrite the slot. Only called by the thread owning the ring.
+            void write(const ErrorRecord &record) noexcept {
+                const std::uint64_t start = sequence.load(std::memory_order_relaxed);
+                sequence.store(start + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+
+                timestamp.store(record.timestamp, std::memory_order_relaxed);
+                thread.store(record.thread, std::memory_order_relaxed);
+                category.store(record.category, std::memory_order_relaxed);
+                file.store(record.file, std::memory_order_relaxed);
+                value.store(record.value, std::memory_order_relaxed);
+                line.store(record.line, std::memory_order_relaxed);
+                length.store(record.length, std::memory_order_relaxed);
+                std::array<std::uint64_t, context_words> words{};
+                std::memcpy(words.data(), record.context.data(), record.length);
+                for (std::size_t i = 0; i < context_words; ++i) {
+                    context[i].store(words[i], std::memory_order_relaxed);
+                }
+
+                sequence.store(start + 2, std::memory_order_release);
+            }
+
+            /// Copy the slot into \p out, from any thread or signal handler.
+            /// \return False if the slot is empty or was being written
+            [[nodiscard]] bool read(ErrorRecord &out) const noexcept {
+                const std::uint64_t start = sequence.load(std::memory_order_acquire);
+                if (start == 0 || start % 2 != 0) {
+                    return false;
+                }
+
+                out.timestamp = timestamp.load(std::memory_order_relaxed);
+                out.thread = thread.load(std::memory_order_relaxed);
+                out.category = category.load(std::memory_order_relaxed);
+                out.file = file.load(std::memory_order_relaxed);
+                out.value = value.load(std::memory_order_relaxed);
+                out.line = line.load(std::memory_order_relaxed);
+                out.length = std::min<std::uint32_t>(length.load(std::memory_order_relaxed),
+                                                     ErrorRecord::context_capacity);
+                std::array<std::uint64_t, context_words> words{};
+                for (std::size_t i = 0; i < context_words; ++i) {
+                    words[i] = context[i].load(std::memory_order_relaxed);
+                }
+                std::memcpy(out.context.data(), words.data(), out.context.size());
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return sequence.load(std::memory_order_relaxed) == start;
+            }
+        };
+
+        /// The last errors of one thread.
+        struct alignas(64) recorder_ring {
+            std::atomic<bool> owned{};
+            std::uint64_t next{};  ///< Only used by the owning thread
+            std::unique_ptr<recorder_slot[]> slots{};
+        };
+
+        /// The rings of a \p FlightRecorder, shared with the threads that own them.
+        struct recorder_state {
+            std::size_t ring_capacity;
+            std::size_t ring_count;
+            std::unique_ptr<recorder_ring[]> rings;
+            std::unique_ptr<ErrorRecord[]> dump_buffer;
+            std::atomic<std::uint64_t> dropped{};
+            std::atomic<std::size_t> cursor{};
+            std::atomic_flag dumping{};
+
+            recorder_state(const std::size_t per_thread, const std::size_t threads)
+                : ring_capacity{std::max<std::size_t>(per_thread, 1)}, ring_count{std::max<std::size_t>(threads, 1)},
+                  rings{std::make_unique<recorder_ring[]>(ring_count)},
+                  dump_buffer{std::make_unique<ErrorRecord[]>(ring_capacity * ring_count)} {
+                for (std::size_t i = 0; i < ring_count; ++i) {
+                    rings[i].slots = std::make_unique<recorder_slot[]>(ring_capacity);
+                }
+            }
+
+            /// Claim a ring that no thread owns. The scan starts after the last ring claimed, so
+            /// that the records of exited threads are overwritten as late as possible.
+            /// \return The ring, or null if every ring is owned
+            [[nodiscard]] recorder_ring *claim() noexcept {
+                const std::size_t start = cursor.fetch_add(1, std::memory_order_relaxed);
+                for (std::size_t n = 0; n < ring_count; ++n) {
+                    const std::size_t i = (start + n) % ring_count;
+                    bool expected = false;
+                    if (!rings[i].owned.load(std::memory_order_relaxed) &&
+                        rings[i].owned.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                        return &rings[i];
+                    }
+                }
+                return nullptr;
+            }
+        };
+
+        /// The rings owned by the current thread, given back when it exits.
+        ///
+        /// A fixed number of bindings is kept, so that binding a thread never allocates;
+        /// beyond that, the oldest binding is given back first.
+        struct recorder_bindings {
+            struct Binding {
+                std::uint64_t id{};
+                recorder_ring *ring{};
+                std::weak_ptr<recorder_state> state{};
+            };
+
+            std::array<Binding, 4> bindings{};
+            std::size_t next{};
+
+            recorder_bindings() = default;
+            recorder_bindings(const recorder_bindings &) = delete;
+            recorder_bindings &operator=(const recorder_bindings &) = delete;
+
+            static void release(Binding &binding) noexcept {
+                if (const auto state = binding.state.lock()) {
+                    binding.ring->owned.store(false, std::memory_order_release);
+                }
+                binding = {};
+            }
+
+            ~recorder_bindings();
+        };
+
+        inline thread_local recorder_bindings thread_recorder_bindings{};
+
+        // The last ring used by this thread. Trivial, so reading them needs no TLS guard.
+        inline thread_local std::uint64_t cached_recorder_id{};
+        inline thread_local recorder_ring *cached_recorder_ring{};
+        inline thread_local std::uint64_t cached_thread_id{};
+
+        inline recorder_bindings::~recorder_bindings() {
+            cached_recorder_id = 0;
+            cached_recorder_ring = nullptr;
+            for (auto &binding : bindings) {
+                if (binding.ring != nullptr) {
+                    release(binding);
+                }
+            }
+        }
+
+        /// \return The id of the calling thread in the operating system
+        [[nodiscard]] inline std::uint64_t current_thread_id() noexcept {
+            if (cached_thread_id == 0) {
+#if defined(__linux__)
+                cached_thread_id = static_cast<std::uint64_t>(::syscall(SYS_gettid));
+#elif defined(__APPLE__)
+                ::pthread_threadid_np(nullptr, &cached_thread_id);
+#else
+                cached_thread_id = reinterpret_cast<std::uintptr_t>(::pthread_self());
+#endif
+            }
+            return cached_thread_id;
+        }
+
+        /// Write all of \p text to \p fd, retrying on partial writes and interruptions.
+        /// \return False if a write failed
+        [[nodiscard]] inline bool write_all(const int fd, const std::string_view text) noexcept {
+            std::size_t written = 0;
+            while (written < text.size()) {
+                const auto count = ::write(fd, text.data() + written, text.size() - written);
+                if (count < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                written += static_cast<std::size_t>(count);
+            }
+            return true;
+        }
+
+        /// A fixed-size line buffer for writing records with \p write(2), without allocating.
+        class signal_safe_line {
+            std::array<char, 512> buffer_{};
+            std::size_t size_{};
+
+        public:
+            void append(const std::string_view text) noexcept {
+                const std::size_t count = std::min(text.size(), buffer_.size() - size_);
+                std::memcpy(buffer_.data() + size_, text.data(), count);
+                size_ += count;
+            }
+
+            void append(const std::int64_t number) noexcept {
+                std::array<char, 24> digits{};
+                std::size_t start = digits.size();
+                const bool negative = number < 0;
+                auto magnitude = negative ? 0 - static_cast<std::uint64_t>(number) : static_cast<std::uint64_t>(number);
+                do {
+                    digits[--start] = static_cast<char>('0' + magnitude % 10);
+                    magnitude /= 10;
+                } while (magnitude != 0);
+                if (negative) {
+                    digits[--start] = '-';
+                }
+                append(std::string_view{digits.data() + start, digits.size() - start});
+            }
+
+            /// Write the line to \p fd. Async-signal-safe.
+            /// \return False if the write failed
+            [[nodiscard]] bool write_to(const int fd) const noexcept {
+                return write_all(fd, {buffer_.data(), size_});
+            }
+        };
+    } // namespace detail
+
+    /// Keeps the last errors of each thread, for crash handlers and post-mortem debugging.
+    ///
+    /// Each thread gets a ring of preallocated slots the first time it records an error,
+    /// and gives it back when it exits; the records of an exited thread stay in its ring until
+    /// another thread reuses it. Recording is lock-free and does not allocate: the error is
+    /// copied into the next slot of the ring, with its context truncated to
+    /// \p ErrorRecord::context_capacity characters.
+    ///
+    /// Install the recorder with \p set_error_observer() to record every \p Error created:
+    /// \code
+    /// static error_utils::FlightRecorder recorder;
+    /// error_utils::set_error_observer(&recorder);
+    ///
+    /// extern "C" void on_fatal_signal(int) {
+    ///     recorder.dump(STDERR_FILENO);  // Async-signal-safe
+    ///     std::_Exit(EXIT_FAILURE);
+    /// }
+    /// \endcode
+    class FlightRecorder final : public ErrorObserver {
+        // clang-format off
+        // @formatter:off
+
+        std::shared_ptr<detail::recorder_state> state_;
+        std::uint64_t id_{next_id()};       ///< Never reused, unlike the address of the object
+
+        // clang-format on
+        // @formatter:on
+
+        [[nodiscard]] static std::uint64_t next_id() noexcept {
+            static std::atomic<std::uint64_t> last{};
+            return last.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+
+        /// Find or claim the ring of the calling thread.
+        /// \return The ring, or null if every ring is owned by another thread
+        [[nodiscard]] detail::recorder_ring *bind() noexcept {
+            auto &local = detail::thread_recorder_bindings;
+            for (const auto &binding : local.bindings) {
+                if (binding.id == id_) {
+                    detail::cached_recorder_id = id_;
+                    detail::cached_recorder_ring = binding.ring;
+                    return binding.ring;
+                }
+            }
+
+            detail::recorder_ring *ring = state_->claim();
+            if (ring == nullptr) {
+                return nullptr;
+            }
+            auto &slot = local.bindings[local.next++ % local.bindings.size()];
+            if (slot.ring != nullptr) {
+                detail::recorder_bindings::release(slot);
+            }
+            slot = {id_, ring, state_};
+            detail::cached_recorder_id = id_;
+            detail::cached_recorder_ring = ring;
+            return ring;
+        }
+
+    public:
+        /// Create a recorder, allocating all its slots up front.
+        /// \param per_thread The number of errors kept for each thread
+        /// \param max_threads The number of threads that can record at the same time
+        explicit FlightRecorder(const std::size_t per_thread = 32, const std::size_t max_threads = 64)
+            : state_{std::make_shared<detail::recorder_state>(per_thread, max_threads)} {}
+
+        FlightRecorder(const FlightRecorder &) = delete;
+        FlightRecorder &operator=(const FlightRecorder &) = delete;
+
+        /// \return The maximum number of records kept, for all the threads
+        [[nodiscard]] std::size_t capacity() const noexcept { return state_->ring_capacity * state_->ring_count; }
+
+        /// \return The number of errors not recorded because every ring was owned by another thread
+        [[nodiscard]] std::uint64_t dropped() const noexcept {
+            return state_->dropped.load(std::memory_order_relaxed);
+        }
+
+        /// Record an error in the ring of the calling thread. Success codes are ignored.
+        /// \param code The error code
+        /// \param context The context of the error, truncated to \p ErrorRecord::context_capacity
+        /// \param location Where the error was created
+        void record(const std::error_code &code, const std::string_view context = {},
+                    const std::source_location &location = std::source_location::current()) noexcept {
+            if (!code) {
+                return;
+            }
+            detail::recorder_ring *ring = detail::cached_recorder_ring;
+            if (detail::cached_recorder_id != id_) [[unlikely]] {
+                ring = bind();
+                if (ring == nullptr) {
+                    state_->dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+
+            ErrorRecord record{};
+            record.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            record.thread = detail::current_thread_id();
+            record.category = &code.category();
+            record.file = location.file_name();
+            record.value = code.value();
+            record.line = location.line();
+            record.length = static_cast<std::uint32_t>(std::min(context.size(), ErrorRecord::context_capacity));
+            std::memcpy(record.context.data(), context.data(), record.length);
+
+            ring->slots[ring->next++ % state_->ring_capacity].write(record);
+        }
+
+        /// Record an \p Error in the ring of the calling thread.
+        void record(const Error &error,
+                    const std::source_location &location = std::source_location::current()) noexcept {
+            record(error.error_code(), error.context(), location);
+        }
+
+        void on_error(const std::error_code &code, const std::string_view context,
+                      const std::source_location &location) noexcept override {
+            record(code, context, location);
+        }
+
+        /// Copy the records of all the threads, oldest first. Async-signal-safe.
+        ///
+        /// Slots being written at the time of the call are skipped. If \p out is too small,
+        /// the most recent records are kept.
+        /// \param out Where to copy the records; \p capacity() records are always enough
+        /// \return The number of records copied to the start of \p out
+        std::size_t snapshot(const std::span<ErrorRecord> out) const noexcept {
+            std::size_t count = 0;
+            ErrorRecord record{};
+            for (std::size_t r = 0; r < state_->ring_count; ++r) {
+                const auto &ring = state_->rings[r];
+                for (std::size_t s = 0; s < state_->ring_capacity; ++s) {
+                    if (!ring.slots[s].read(record)) {
+                        continue;
+                    }
+                    if (count < out.size()) {
+                        out[count++] = record;
+                    } else if (count != 0) {
+                        // Full: replace the oldest record if this one is more recent
+                        auto oldest = std::ranges::min_element(out, {}, &ErrorRecord::timestamp);
+                        if (oldest->timestamp < record.timestamp) {
+                            *oldest = record;
+                        }
+                    }
+                }
+            }
+            std::ranges::sort(out.first(count), {}, &ErrorRecord::timestamp);
+            return count;
+        }
+
+        /// Write the records of all the threads to \p fd, oldest first, one per line.
+        ///
+        /// Async-signal-safe: it uses a buffer allocated with the recorder, and only \p write(2).
+        /// Each line reads <tt>timestamp thread category:value file:line context</tt>.
+        /// \param fd The file descriptor to write to
+        /// \return False if another dump is in progress or a write failed
+        bool dump(const int fd) const noexcept {
+            if (state_->dumping.test_and_set(std::memory_order_acquire)) {
+                return false;
+            }
+            const std::size_t count = snapshot({state_->dump_buffer.get(), capacity()});
+            bool written = true;
+            for (std::size_t i = 0; i < count && written; ++i) {
+                const ErrorRecord &record = state_->dump_buffer[i];
+                detail::signal_safe_line line;
+                line.append(record.timestamp);
+                line.append(" ");
+                line.append(static_cast<std::int64_t>(record.thread));
+                line.append(" ");
+                line.append(record.category->name());
+                line.append(":");
+                line.append(std::int64_t{record.value});
+                line.append(" ");
+                line.append(record.file != nullptr ? record.file : "?");
+                line.append(":");
+                line.append(std::int64_t{record.line});
+                line.append(" ");
+                line.append(record.context_view());
+                line.append("\n");
+                written = line.write_to(fd);
+            }
+            state_->dumping.clear(std::memory_order_release);
+            return written;
+        }
+    };
+
+    namespace detail {
+        /// The throttling state of one distinct error of a \p RateLimitedLog.
+        struct log_entry {
+            std::atomic<std::uint64_t> key{};           ///< Zero while the entry is free
+            std::atomic<std::int64_t> window_end{};     ///< In nanoseconds of \p steady_clock
+            std::atomic<std::uint64_t> suppressed{};    ///< Occurrences not written in the current window
+        };
+
+        /// An error waiting to be written by the thread of a \p RateLimitedLog.
+        struct log_message {
+            static constexpr std::size_t context_capacity = 128;
+            static constexpr std::uint32_t no_entry = std::numeric_limits<std::uint32_t>::max();
+
+            const std::error_category *category{};
+            const char *file{};
+            int value{};
+            std::uint32_t line{};
+            std::uint32_t entry{no_entry};
+            std::uint32_t length{};
+            std::uint64_t repeated{};   ///< Occurrences suppressed in the previous window
+            std::array<char, context_capacity> context{};
+        };
+
+        /// A bounded queue of messages with many producers and a single consumer.
+        ///
+        /// Each cell carries a sequence number telling whether it is free for the producer of a
+        /// given position, or filled for the consumer, so pushing and popping take no lock.
+        class log_queue {
+            struct Cell {
+                std::atomic<std::size_t> sequence{};
+                log_message message{};
+            };
+
+            std::unique_ptr<Cell[]> cells_;
+            std::size_t mask_;
+            alignas(64) std::atomic<std::size_t> head_{};   ///< The next position to push
+            alignas(64) std::size_t tail_{};                ///< The next position to pop, owned by the consumer
+
+        public:
+            explicit log_queue(const std::size_t capacity)
+                : cells_{std::make_unique<Cell[]>(std::bit_ceil(std::max<std::size_t>(capacity, 2)))},
+                  mask_{std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1} {
+                for (std::size_t i = 0; i <= mask_; ++i) {
+                    cells_[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            /// \return False if the queue is full
+            [[nodiscard]] bool push(const log_message &message) noexcept {
+                std::size_t position = head_.load(std::memory_order_relaxed);
+                while (true) {
+                    Cell &cell = cells_[position & mask_];
+                    const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                    const auto lag = static_cast<std::ptrdiff_t>(sequence - position);
+                    if (lag == 0) {
+                        if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                            cell.message = message;
+                            cell.sequence.store(position + 1, std::memory_order_release);
+                            return true;
+                        }
+                    } else if (lag < 0) {
+                        return false;
+                    } else {
+                        position = head_.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            /// \return False if the queue is empty. Only called by the consumer.
+            [[nodiscard]] bool pop(log_message &message) noexcept {
+                Cell &cell = cells_[tail_ & mask_];
+                if (cell.sequence.load(std::memory_order_acquire) != tail_ + 1) {
+                    return false;
+                }
+                message = cell.message;
+                cell.sequence.store(tail_ + mask_ + 1, std::memory_order_release);
+                ++tail_;
+                return true;
+            }
+
+            /// \return True if nothing can be popped. Only called by the consumer.
+            [[nodiscard]] bool empty() const noexcept {
+                return cells_[tail_ & mask_].sequence.load(std::memory_order_acquire) != tail_ + 1;
+            }
+        };
+
+        /// Wakes a thread sleeping in \p poll(2): an eventfd on Linux, a non-blocking pipe elsewhere.
+        ///
+        /// Signalling is a single \p write(2), without locks. Without a file descriptor, waiting
+        /// degrades to sleeping for the whole timeout.
+        class wakeup {
+            int read_fd_{-1};
+            int write_fd_{-1};
+
+        public:
+            wakeup() noexcept {
+#ifdef __linux__
+                read_fd_ = write_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#else
+                if (int fds[2]; ::pipe(fds) == 0) {
+                    for (const int fd : fds) {
+                        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+                        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+                    }
+                    read_fd_ = fds[0];
+                    write_fd_ = fds[1];
+                }
+#endif
+            }
+
+            wakeup(const wakeup &) = delete;
+            wakeup &operator=(const wakeup &) = delete;
+
+            ~wakeup() {
+                if (write_fd_ != read_fd_ && write_fd_ >= 0) {
+                    ::close(write_fd_);
+                }
+                if (read_fd_ >= 0) {
+                    ::close(read_fd_);
+                }
+            }
+
+            /// Wake the waiting thread, or make its next wait return immediately.
+            void signal() const noexcept {
+                const std::uint64_t one = 1; // An eventfd takes 8 bytes, a pipe any of them
+                (void) ::write(write_fd_, &one, sizeof(one));
+            }
+
+            /// Sleep until signalled, or for \p timeout, and clear the signal.
+            void wait(const std::chrono::nanoseconds timeout) const noexcept {
+                const auto milliseconds = static_cast<int>(std::clamp<std::int64_t>(
+                    std::chrono::ceil<std::chrono::milliseconds>(timeout).count(), 1,
+                    std::numeric_limits<int>::max()));
+                if (read_fd_ < 0) [[unlikely]] {
+                    std::this_thread::sleep_for(std::chrono::milliseconds{milliseconds});
+                    return;
+                }
+                pollfd events{read_fd_, POLLIN, 0};
+                if (::poll(&events, 1, milliseconds) > 0) {
+                    std::array<char, 64> buffer; // NOLINT(*-member-init)
+                    while (::read(read_fd_, buffer.data(), buffer.size()) > 0) {
+                    }
+                }
+            }
+        };
+
+        [[nodiscard]] inline std::int64_t steady_nanoseconds() noexcept {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+    } // namespace detail
+
+    /// Writes errors to a log from a background thread, collapsing repeats.
+    ///
+    /// Errors with the same category, value and context are written once per time window; the
+    /// other occurrences are only counted, and written as a single "repeated N times" line when
+    /// the window ends. Logging an error is lock-free and does not allocate: a repeat costs a
+    /// hash and an atomic increment, and an error to write is copied into a bounded queue, with
+    /// its context truncated to 128 characters, and wakes the background thread with a
+    /// \p write(2) only if it is sleeping. Only the errors taken off the queue are
+    /// formatted, with \p std::formatter<Error>, by the background thread.
+    ///
+    /// The number of distinct errors tracked at once is bounded; errors that find no room are
+    /// written without deduplication, and errors that find the queue full are dropped.
+    /// \code
+    /// static error_utils::RateLimitedLog log{STDERR_FILENO, std::chrono::seconds{10}};
+    /// log.log(error);  // Or install it with set_error_observer(&log)
+    /// \endcode
+    class RateLimitedLog final : public ErrorObserver {
+    public:
+        /// Receives each line to write, from the background thread.
+        using Writer = std::function<void(std::string_view)>;
+
+    private:
+        /// The number of entries probed before giving up on deduplicating an error
+        static constexpr std::size_t probe_limit = 8;
+        /// The number of idle windows after which an entry is reused for another error
+        static constexpr std::int64_t idle_windows = 4;
+
+        // clang-format off
+        // @formatter:off
+
+        Writer writer_;
+        std::int64_t window_;                               ///< In nanoseconds
+        std::size_t entry_mask_;
+        std::unique_ptr<detail::log_entry[]> entries_;
+        detail::log_queue queue_;
+        std::vector<std::string> descriptions_;             ///< By entry, owned by the background thread
+        std::atomic<std::uint64_t> written_{};
+        std::atomic<std::uint64_t> dropped_{};
+        std::atomic<bool> sleeping_{};                      ///< Whether the background thread waits on \p wakeup_
+        detail::wakeup wakeup_{};
+        std::jthread thread_{};                             ///< Last, so it stops before the rest is destroyed
+
+        // clang-format on
+        // @formatter:on
+
+        /// \return A non-zero hash of the category, the value and the context of an error
+        [[nodiscard]] static std::uint64_t key_of(const std::error_code &code,
+                                                  const std::string_view context) noexcept {
+            constexpr std::uint64_t golden = 0x9e37'79b9'7f4a'7c15ULL;
+            std::uint64_t key = std::hash<std::string_view>{}(context);
+            key ^= reinterpret_cast<std::uintptr_t>(&code.category()) + golden + (key << 6) + (key >> 2);
+            key ^= static_cast<std::uint32_t>(code.value()) + golden + (key << 6) + (key >> 2);
+            // Zero marks a free entry. Setting a bit instead would merge errors, and leave
+            // half of the entries unreachable without probing.
+            return key != 0 ? key : 1;
+        }
+
+        /// Find or claim the entry of \p key.
+        /// \return The index of the entry, or \p log_message::no_entry if there is no room
+        [[nodiscard]] std::uint32_t find(const std::uint64_t key) noexcept {
+            for (std::size_t n = 0; n < probe_limit && n <= entry_mask_; ++n) {
+                const std::size_t index = (key + n) & entry_mask_;
+                std::uint64_t current = entries_[index].key.load(std::memory_order_relaxed);
+                if (current == 0) {
+                    entries_[index].key.compare_exchange_strong(current, key, std::memory_order_relaxed);
+                    if (current == 0) {
+                        return static_cast<std::uint32_t>(index);
+                    }
+                }
+                if (current == key) {
+                    return static_cast<std::uint32_t>(index);
+                }
+            }
+            return detail::log_message::no_entry;
+        }
+
+        [[nodiscard]] static std::string describe(const detail::log_message &message) {
+            return std::format("{}:{}: {}:{} {}", message.file, message.line, message.category->name(),
+                               message.value, std::string_view{message.context.data(), message.length});
+        }
+
+        void write(const detail::log_message &message, std::string &line) {
+            if (message.entry != detail::log_message::no_entry) {
+                auto &description = descriptions_[message.entry];
+                description = describe(message);
+                if (message.repeated != 0) {
+                    line.clear();
+                    std::format_to(std::back_inserter(line), "{}: repeated {} times\n", description, message.repeated);
+                    writer_(line);
+                }
+            }
+            const Error error{detail::unobserved, std::error_code{message.value, *message.category},
+                              std::string_view{message.context.data(), message.length}};
+            line.clear();
+            std::format_to(std::back_inserter(line), "{}:{}: {}\n", message.file, message.line, error);
+            writer_(line);
+        }
+
+        /// Write the counts of the windows that ended, and free the entries idle for long enough.
+        void summarize(const std::int64_t now, std::string &line) {
+            for (std::size_t index = 0; index <= entry_mask_; ++index) {
+                auto &entry = entries_[index];
+                std::uint64_t key = entry.key.load(std::memory_order_relaxed);
+                const std::int64_t end = entry.window_end.load(std::memory_order_relaxed);
+                if (key == 0 || now < end) {
+                    continue;
+                }
+                if (const std::uint64_t repeated = entry.suppressed.exchange(0, std::memory_order_relaxed)) {
+                    if (descriptions_[index].empty()) {
+                        // Its first message was dropped: leave the count to the next message
+                        entry.suppressed.fetch_add(repeated, std::memory_order_relaxed);
+                        continue;
+                    }
+                    line.clear();
+                    std::format_to(std::back_inserter(line), "{}: repeated {} times\n", descriptions_[index], repeated);
+                    writer_(line);
+                } else if (now - end >= idle_windows * window_ &&
+                           entry.key.compare_exchange_strong(key, 0, std::memory_order_relaxed)) {
+                    descriptions_[index].clear();
+                }
+            }
+        }
+
+        void run(const std::stop_token &stop) {
+            std::string line;
+            detail::log_message message;
+            const auto period = std::min(std::chrono::nanoseconds{window_}, std::chrono::nanoseconds{100'000'000});
+            while (!stop.stop_requested()) {
+                while (queue_.pop(message)) {
+                    write(message, line);
+                }
+                summarize(detail::steady_nanoseconds(), line);
+
+                // Announce the sleep before checking the queue one last time: a producer pushing
+                // after the check sees the flag and signals, and one pushing before it is seen here
+                sleeping_.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (queue_.empty() && !stop.stop_requested()) {
+                    wakeup_.wait(period);
+                }
+                sleeping_.store(false, std::memory_order_relaxed);
+            }
+            while (queue_.pop(message)) {
+                write(message, line);
+            }
+            summarize(std::numeric_limits<std::int64_t>::max(), line);
+        }
+
+    public:
+        /// Start the background thread of the log.
+        /// \param writer Receives each line to write, from the background thread
+        /// \param window How long repeats of an error are collapsed
+        /// \param distinct The number of distinct errors tracked at once
+        /// \param queue The number of errors that can wait to be written
+        explicit RateLimitedLog(Writer writer, const std::chrono::nanoseconds window = std::chrono::seconds{1},
+                                const std::size_t distinct = 1024, const std::size_t queue = 1024)
+            : writer_{std::move(writer)}, window_{std::max<std::int64_t>(window.count(), 1)},
+              entry_mask_{std::bit_ceil(std::max<std::size_t>(distinct, 1)) - 1},
+              entries_{std::make_unique<detail::log_entry[]>(entry_mask_ + 1)}, queue_{queue},
+              descriptions_(entry_mask_ + 1),
+              thread_{[this](const std::stop_token &stop) { run(stop); }} {}
+
+        /// Start the background thread of the log, writing to a file descriptor.
+        /// \param fd The file descriptor to write to, which must outlive the log
+        /// \param window How long repeats of an error are collapsed
+        explicit RateLimitedLog(const int fd, const std::chrono::nanoseconds window = std::chrono::seconds{1})
+            : RateLimitedLog{[fd](const std::string_view line) { (void) detail::write_all(fd, line); }, window} {}
+
+        RateLimitedLog(const RateLimitedLog &) = delete;
+        RateLimitedLog &operator=(const RateLimitedLog &) = delete;
+
+        /// Write the pending errors and the pending repeat counts, then stop the background thread.
+        ~RateLimitedLog() override {
+            thread_.request_stop();
+            wakeup_.signal();
+            thread_.join();
+        }
+
+        /// \return The number of errors passed to the background thread to be written
+        [[nodiscard]] std::uint64_t written() const noexcept { return written_.load(std::memory_order_relaxed); }
+
+        /// \return The number of errors not written because the queue was full
+        [[nodiscard]] std::uint64_t dropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+
+        /// Log an error, unless the same error was already logged in the current window.
+        /// Success codes are ignored.
+        /// \param code The error code
+        /// \param context The context of the error, truncated to 128 characters
+        /// \param location Where the error was created
+        void log(const std::error_code &code, const std::string_view context = {},
+                 const std::source_location &location = std::source_location::current()) noexcept {
+            if (!code) {
+                return;
+            }
+            const std::uint32_t index = find(key_of(code, context));
+            std::uint64_t repeated = 0;
+            if (index != detail::log_message::no_entry) {
+                auto &entry = entries_[index];
+                const std::int64_t now = detail::steady_nanoseconds();
+                std::int64_t end = entry.window_end.load(std::memory_order_relaxed);
+                if (now < end ||
+                    !entry.window_end.compare_exchange_strong(end, now + window_, std::memory_order_relaxed)) {
+                    entry.suppressed.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                repeated = entry.suppressed.exchange(0, std::memory_order_relaxed);
+            }
+
+            detail::log_message message{};
+            message.category = &code.category();
+            message.file = location.file_name();
+            message.value = code.value();
+            message.line = location.line();
+            message.entry = index;
+            message.length = static_cast<std::uint32_t>(std::min(context.size(), message.context.size()));
+            message.repeated = repeated;
+            std::memcpy(message.context.data(), context.data(), message.length);
+
+            if (!queue_.push(message)) [[unlikely]] {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                if (index != detail::log_message::no_entry) {
+                    // Counted as repeats instead, and written with the next message or summary
+                    entries_[index].suppressed.fetch_add(repeated + 1, std::memory_order_relaxed);
+                }
+                return;
+            }
+            written_.fetch_add(1, std::memory_order_relaxed);
+
+            // Only a sleeping background thread needs a signal, from a single producer
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleeping_.load(std::memory_order_relaxed) && sleeping_.exchange(false, std::memory_order_relaxed)) {
+                wakeup_.signal();
+            }
+        }
+
+        /// Log an \p Error, unless the same error was already logged in the current window.
+        void log(const Error &error, const std::source_location &location = std::source_location::current()) noexcept {
+            log(error.error_code(), error.context(), location);
+        }
+
+        void on_error(const std::error_code &code, const std::string_view context,
+                      const std::source_location &location) noexcept override {
+            log(code, context, location);
+        }
+    };
+} // namespace error_utils
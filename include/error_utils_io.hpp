@@ -0,0 +1,634 @@
+// MIT License
+//
+// Copyright (c) 2025 Ian Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+/// \file
+/// \brief POSIX I/O utilities built on top of \p Result<T>.
+///
+/// \details This module wraps common file and descriptor operations so that every
+/// failure is reported as an \p error_utils::Error carrying the \p errno value and
+/// a description of the operation that failed.
+
+#pragma once
+
+/// \cond
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#endif
+/// \endcond
+
+#include "error_utils.hpp"
+
+
+namespace error_utils {
+    namespace detail {
+        /// Check that an error context fits in the small-string buffer of \p std::string, so that
+        /// creating an \p Error with it cannot throw \p std::bad_alloc in a \p noexcept function.
+        consteval bool fits_small_string(const std::string_view context) {
+            return context.size() <= std::string{}.capacity();
+        }
+    } // namespace detail
+
+    /// An owning, move-only handle to a file descriptor.
+    ///
+    /// The descriptor is closed when the handle is destroyed. Errors from that implicit
+    /// \p close() are ignored; call \p close() explicitly to observe them.
+    ///
+    /// \note A \p UniqueFd has the size of an \p int and never allocates.
+    class CPP_ERROR_UTILS_TRIVIAL_ABI UniqueFd {
+        int fd_{-1}; ///< The owned descriptor, or -1 if none is owned
+
+    public:
+        constexpr UniqueFd() noexcept = default;
+
+        /// Take ownership of a file descriptor.
+        /// \param fd The descriptor to own, or -1 for an empty handle
+        constexpr explicit UniqueFd(const int fd) noexcept : fd_{fd} {}
+
+        UniqueFd(const UniqueFd &) = delete;
+
+        UniqueFd &operator=(const UniqueFd &) = delete;
+
+        constexpr UniqueFd(UniqueFd &&other) noexcept : fd_{std::exchange(other.fd_, -1)} {}
+
+        UniqueFd &operator=(UniqueFd &&other) noexcept {
+            if (this == &other)
+                return *this;
+            reset(other.release());
+            return *this;
+        }
+
+        ~UniqueFd() noexcept {
+            if (fd_ >= 0) {
+                ::close(fd_);
+            }
+        }
+
+        /// Implicit conversion to bool, indicating whether a descriptor is owned.
+        [[nodiscard]] constexpr explicit operator bool() const noexcept { return fd_ >= 0; }
+
+        /// Returns the owned descriptor without giving up ownership, or -1 if none is owned.
+        [[nodiscard]] constexpr int get() const noexcept { return fd_; }
+
+        /// Give up ownership of the descriptor without closing it.
+        /// \return The descriptor, or -1 if none was owned.
+        [[nodiscard]] constexpr int release() noexcept { return std::exchange(fd_, -1); }
+
+        /// Close the owned descriptor, if any, and take ownership of another one.
+        /// \param fd The descriptor to own, or -1 for an empty handle
+        void reset(const int fd = -1) noexcept {
+            if (const int old = std::exchange(fd_, fd); old >= 0) {
+                ::close(old);
+            }
+        }
+
+        /// Close the owned descriptor, reporting any error from \p close().
+        ///
+        /// The handle is empty afterwards, even on failure: the descriptor must not be
+        /// closed again, since POSIX leaves its state unspecified and Linux always releases it.
+        ///
+        /// \return An error if \p close() failed.
+        VoidResult close() noexcept {
+            constexpr std::string_view context = "Closing fd";
+            static_assert(detail::fits_small_string(context));
+            const int fd = std::exchange(fd_, -1);
+            if (fd < 0) {
+                return {};
+            }
+            if (const auto result = invoke_with_syscall_api([fd] noexcept { return ::close(fd); }, context);
+                !result) {
+                return std::unexpected(result.error());
+            }
+            return {};
+        }
+
+        /// Swap the contents of two UniqueFd objects.
+        constexpr friend void swap(UniqueFd &lhs, UniqueFd &rhs) noexcept {
+            std::swap(lhs.fd_, rhs.fd_);
+        }
+    };
+
+    static_assert(sizeof(UniqueFd) == sizeof(int));
+
+    /// Open a file, wrapping the descriptor in a \p UniqueFd.
+    /// \param path Path of the file to open
+    /// \param flags Flags passed to \p open(), e.g. \p O_RDONLY | \p O_CLOEXEC
+    /// \param mode Permission bits for a newly created file
+    /// \return The opened descriptor, or an error naming the path.
+    [[nodiscard]] inline Result<UniqueFd> open_fd(const std::string &path, const int flags,
+                                                  const ::mode_t mode = 0) {
+        const auto fd = invoke_with_syscall_api([&] noexcept { return ::open(path.c_str(), flags, mode); },
+                                                std::format("Opening '{}'", path));
+        if (!fd) {
+            return std::unexpected(fd.error());
+        }
+        return UniqueFd{*fd};
+    }
+
+    /// Create a pipe.
+    /// \param flags Flags for \p pipe2() (Linux). Elsewhere, only \p O_CLOEXEC is honored.
+    /// \return The read end and the write end of the pipe, in that order.
+    [[nodiscard]] inline Result<std::pair<UniqueFd, UniqueFd>> pipe_fds(const int flags = O_CLOEXEC) {
+        int fds[2]{-1, -1};
+#ifdef __linux__
+        const auto result = invoke_with_syscall_api([&] noexcept { return ::pipe2(fds, flags); }, "Creating pipe");
+#else
+        const auto result = invoke_with_syscall_api([&] noexcept {
+            if (::pipe(fds) == -1) return -1;
+            if ((flags & O_CLOEXEC) != 0 &&
+                (::fcntl(fds[0], F_SETFD, FD_CLOEXEC) == -1 || ::fcntl(fds[1], F_SETFD, FD_CLOEXEC) == -1)) {
+                const int err = errno;
+                ::close(fds[0]);
+                ::close(fds[1]);
+                errno = err;
+                return -1;
+            }
+            return 0;
+        }, "Creating pipe");
+#endif
+        if (!result) {
+            return std::unexpected(result.error());
+        }
+        return std::pair{UniqueFd{fds[0]}, UniqueFd{fds[1]}};
+    }
+
+#ifdef __linux__
+    /// Create an event notification descriptor (Linux only).
+    /// \param initial_value The initial value of the counter
+    /// \param flags Flags for \p eventfd(), e.g. \p EFD_NONBLOCK
+    /// \return The event descriptor.
+    [[nodiscard]] inline Result<UniqueFd> eventfd_fd(const unsigned initial_value = 0,
+                                                     const int flags = EFD_CLOEXEC) {
+        const auto fd = invoke_with_syscall_api([&] noexcept { return ::eventfd(initial_value, flags); },
+                                                "Creating eventfd");
+        if (!fd) {
+            return std::unexpected(fd.error());
+        }
+        return UniqueFd{*fd};
+    }
+
+    /// Create an anonymous memory-backed file (Linux only).
+    /// \param name Name of the file, shown in \p /proc/self/fd for debugging
+    /// \param flags Flags for \p memfd_create(), e.g. \p MFD_ALLOW_SEALING
+    /// \return The descriptor of the anonymous file.
+    [[nodiscard]] inline Result<UniqueFd> memfd_fd(const std::string &name, const unsigned flags = MFD_CLOEXEC) {
+        const auto fd = invoke_with_syscall_api([&] noexcept { return ::memfd_create(name.c_str(), flags); },
+                                                std::format("Creating memfd '{}'", name));
+        if (!fd) {
+            return std::unexpected(fd.error());
+        }
+        return UniqueFd{*fd};
+    }
+#endif
+
+    // clang-format off
+    // @formatter:off
+
+    /// Access pattern hints for memory-mapped files, forwarded to \p madvise().
+    ///
+    /// The hints can be combined with \p operator|. They are advisory: the kernel is free
+    /// to ignore them, and hints unsupported by the platform are silently skipped.
+    enum class MapAdvice : unsigned {
+        normal     = 0,        ///< No special treatment.
+        sequential = 1u << 0,  ///< Expect sequential access (aggressive read-ahead).
+        random     = 1u << 1,  ///< Expect random access (minimal read-ahead).
+        will_need  = 1u << 2,  ///< Start reading the pages in ahead of time.
+        huge_page  = 1u << 3,  ///< Back the mapping with transparent huge pages where possible (Linux only).
+    };
+
+    // clang-format on
+    // @formatter:on
+
+    /// Combine two sets of mapping hints.
+    constexpr MapAdvice operator|(const MapAdvice lhs, const MapAdvice rhs) noexcept {
+        return static_cast<MapAdvice>(std::to_underlying(lhs) | std::to_underlying(rhs));
+    }
+
+    /// Intersect two sets of mapping hints.
+    constexpr MapAdvice operator&(const MapAdvice lhs, const MapAdvice rhs) noexcept {
+        return static_cast<MapAdvice>(std::to_underlying(lhs) & std::to_underlying(rhs));
+    }
+
+    namespace detail {
+        /// Apply the \p madvise() hints in \p advice to a mapped region.
+        /// \return 0 on success, or -1 with \p errno set by the first failing call.
+        inline int apply_map_advice(void *addr, const std::size_t length, const MapAdvice advice) noexcept {
+            auto has = [advice](const MapAdvice flag) { return (advice & flag) == flag; };
+
+            if (has(MapAdvice::sequential) && ::madvise(addr, length, MADV_SEQUENTIAL) == -1) return -1;
+            if (has(MapAdvice::random) && ::madvise(addr, length, MADV_RANDOM) == -1) return -1;
+            if (has(MapAdvice::will_need) && ::madvise(addr, length, MADV_WILLNEED) == -1) return -1;
+#ifdef MADV_HUGEPAGE
+            if (has(MapAdvice::huge_page) && ::madvise(addr, length, MADV_HUGEPAGE) == -1) return -1;
+#endif
+            return 0;
+        }
+    } // namespace detail
+
+    /// A read-only memory mapping of a whole file.
+    ///
+    /// The mapping is released when the object is destroyed. The underlying file descriptor
+    /// is closed as soon as the mapping is established, so a \p MappedFile holds no descriptor.
+    ///
+    /// \note Empty files are represented by an empty mapping with no pages behind it.
+    class MappedFile {
+        // clang-format off
+        // @formatter:off
+
+        std::byte *data_{};  ///< Start of the mapping, or \p nullptr if nothing is mapped
+        std::size_t size_{}; ///< Length of the mapping in bytes
+
+        // clang-format on
+        // @formatter:on
+
+        MappedFile(std::byte *data, const std::size_t size) noexcept : data_{data}, size_{size} {}
+
+    public:
+        constexpr MappedFile() noexcept = default;
+
+        MappedFile(const MappedFile &) = delete;
+
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        MappedFile(MappedFile &&other) noexcept
+            : data_{std::exchange(other.data_, nullptr)},
+              size_{std::exchange(other.size_, 0)} {}
+
+        MappedFile &operator=(MappedFile &&other) noexcept {
+            if (this == &other)
+                return *this;
+            static_cast<void>(close());
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            return *this;
+        }
+
+        ~MappedFile() noexcept {
+            if (data_ != nullptr) {
+                ::munmap(data_, size_);
+            }
+        }
+
+        /// Map a file into memory for reading.
+        ///
+        /// Failures of \p open(), \p fstat() and \p mmap() are reported with the \p errno
+        /// value and the path. Failures to apply \p advice are ignored, since the hints
+        /// are advisory; use \p advise() to observe them.
+        ///
+        /// Only regular files are mapped. Directories give \p std::errc::is_a_directory, and
+        /// other files \p std::errc::invalid_argument: FIFOs and devices cannot be mapped
+        /// reliably. So do procfs or sysfs files, which report a size of zero whatever their
+        /// contents.
+        ///
+        /// \param path Path of the file to map
+        /// \param advice Access pattern hints for the mapping
+        /// \return The mapped file, or an error describing the failing step.
+        [[nodiscard]] static Result<MappedFile> open(const std::string &path,
+                                                     const MapAdvice advice = MapAdvice::normal) {
+            // Non-blocking, so that opening a FIFO does not wait for a writer before it is rejected
+            const auto fd = open_fd(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+            if (!fd) {
+                return std::unexpected(fd.error());
+            }
+
+            struct stat st{};
+            if (const auto stat_result = invoke_with_syscall_api(
+                [&] noexcept { return ::fstat(fd->get(), &st); }, std::format("Querying the size of '{}'", path));
+                !stat_result) {
+                return std::unexpected(stat_result.error());
+            }
+
+            if (S_ISDIR(st.st_mode)) {
+                return make_error<MappedFile>(std::errc::is_a_directory, std::format("Mapping '{}'", path));
+            }
+            if (!S_ISREG(st.st_mode)) {
+                return make_error<MappedFile>(std::errc::invalid_argument,
+                                              std::format("Mapping '{}': not a regular file", path));
+            }
+
+            const auto size = static_cast<std::size_t>(st.st_size);
+            if (size == 0) {
+                // procfs and sysfs files report no size, but can be read
+                char byte;
+                if (::read(fd->get(), &byte, 1) > 0) {
+                    return make_error<MappedFile>(std::errc::invalid_argument,
+                                                  std::format("Mapping '{}': size unknown", path));
+                }
+                return MappedFile{};
+            }
+
+            void *addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd->get(), 0);
+            if (addr == MAP_FAILED) {
+                return make_error_from_errno<MappedFile>(std::format("Mapping '{}'", path));
+            }
+
+            static_cast<void>(detail::apply_map_advice(addr, size, advice));
+            return MappedFile{static_cast<std::byte *>(addr), size};
+        }
+
+        /// Apply additional access pattern hints to the mapping.
+        /// \param advice The hints to apply
+        /// \return An error if the kernel rejected any of the hints.
+        [[nodiscard]] VoidResult advise(const MapAdvice advice) const noexcept {
+            constexpr std::string_view context = "Mapping advice";
+            static_assert(detail::fits_small_string(context));
+            if (data_ == nullptr) {
+                return {};
+            }
+            if (const auto result = invoke_with_syscall_api(
+                [&] noexcept { return detail::apply_map_advice(data_, size_, advice); }, context); !result) {
+                return std::unexpected(result.error());
+            }
+            return {};
+        }
+
+        /// Release the mapping, reporting any error from \p munmap().
+        /// \return An error if the mapping could not be released.
+        VoidResult close() noexcept {
+            if (data_ == nullptr) {
+                return {};
+            }
+            auto *data = std::exchange(data_, nullptr);
+            const auto size = std::exchange(size_, 0);
+            constexpr std::string_view context = "Unmapping file";
+            static_assert(detail::fits_small_string(context));
+            if (const auto result = invoke_with_syscall_api([&] noexcept { return ::munmap(data, size); }, context);
+                !result) {
+                return std::unexpected(result.error());
+            }
+            return {};
+        }
+
+        /// Returns the mapped bytes.
+        [[nodiscard]] std::span<const std::byte> bytes() const noexcept { return {data_, size_}; }
+
+        /// Returns the mapped bytes as characters.
+        [[nodiscard]] std::string_view view() const noexcept {
+            return {reinterpret_cast<const char *>(data_), size_};
+        }
+
+        /// Returns a pointer to the first mapped byte, or \p nullptr if nothing is mapped.
+        [[nodiscard]] const std::byte *data() const noexcept { return data_; }
+
+        /// Returns the size of the mapping in bytes.
+        [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+        /// Check whether the mapping is empty.
+        [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+        /// Swap the contents of two MappedFile objects.
+        friend void swap(MappedFile &lhs, MappedFile &rhs) noexcept {
+            using std::swap;
+            swap(lhs.data_, rhs.data_);
+            swap(lhs.size_, rhs.size_);
+        }
+    };
+
+    // clang-format off
+    // @formatter:off
+
+    /// The kernel mechanism used to move data between two file descriptors.
+    enum class CopyMethod {
+        copy_file_range,  ///< In-kernel copy between files (\p copy_file_range(2)).
+        sendfile,         ///< In-kernel copy from a file to any descriptor (\p sendfile(2)).
+        splice,           ///< In-kernel move to or from a pipe (\p splice(2)).
+        read_write,       ///< User-space \p read() and \p write() loop.
+    };
+
+    // clang-format on
+    // @formatter:on
+
+    namespace detail {
+        /// Upper bound on the bytes moved by a single call, matching the Linux per-call limit.
+        /// It also keeps every result within the range of \p int.
+        inline constexpr std::size_t max_transfer_chunk = 0x7ffff000;
+
+        /// Check whether a transfer error means the mechanism cannot handle the descriptors,
+        /// as opposed to a genuine I/O failure.
+        [[nodiscard]] inline bool is_unsupported_transfer(const Error &error) noexcept {
+            return error.is_any_of(std::errc::function_not_supported, std::errc::invalid_argument,
+                                   std::errc::cross_device_link, std::errc::operation_not_supported,
+                                   std::errc::bad_file_descriptor);
+        }
+
+        /// Call \p step repeatedly until \p count bytes are moved or it reports end of input.
+        ///
+        /// \param step Callable taking the maximum number of bytes to move and returning the
+        /// number of bytes moved as an \p IntResult
+        /// \param count The maximum number of bytes to move
+        /// \param total Incremented by the number of bytes moved, including on failure
+        /// \return An error if \p step fails with anything other than \p EINTR.
+        template <typename Step>
+        [[nodiscard]] VoidResult pump(Step &&step, const std::size_t count, std::size_t &total) {
+            while (total < count) {
+                const auto moved = step(std::min(count - total, max_transfer_chunk));
+                if (!moved) {
+                    if (moved.error().is(std::errc::interrupted)) {
+                        continue;
+                    }
+                    return std::unexpected(moved.error());
+                }
+                if (*moved == 0) {
+                    break; // End of input
+                }
+                total += static_cast<std::size_t>(*moved);
+            }
+            return {};
+        }
+
+        /// Move up to \p length bytes from \p in to \p out through a user-space buffer.
+        /// \param total Incremented by the bytes written before a failed \p write(), which the
+        /// error does not count
+        /// \return The number of bytes moved, or an error from \p read() or \p write().
+        [[nodiscard]] inline IntResult read_write_step(const int in, const int out, const std::size_t length,
+                                                       std::size_t &total) {
+            char buffer[64 * 1024];
+            const auto read = invoke_with_syscall_api<ErrnoMode::on_failure>([&] noexcept {
+                return ::read(in, buffer, std::min(length, sizeof(buffer)));
+            }, "Copying with read");
+            if (!read || *read == 0) {
+                return read;
+            }
+
+            // A failed write loses the bytes read but not written; those written are counted.
+            for (int written = 0; written < *read;) {
+                const auto result = invoke_with_syscall_api<ErrnoMode::on_failure>([&] noexcept {
+                    return ::write(out, buffer + written, static_cast<std::size_t>(*read - written));
+                }, "Copying with write");
+                if (!result) {
+                    if (result.error().is(std::errc::interrupted)) {
+                        continue;
+                    }
+                    total += static_cast<std::size_t>(written);
+                    return result;
+                }
+                written += *result;
+            }
+            return read;
+        }
+    } // namespace detail
+
+    /// Move up to \p count bytes from one file descriptor to another without staging
+    /// the data in user space where possible.
+    ///
+    /// The mechanisms are tried in the order \p copy_file_range, \p sendfile, \p splice,
+    /// falling back to the next one when the kernel reports that the current one cannot
+    /// handle the pair of descriptors. A \p read() / \p write() loop is the last resort, and
+    /// the only mechanism available outside Linux. The descriptors' file offsets are advanced.
+    ///
+    /// \param in Descriptor to read from
+    /// \param out Descriptor to write to
+    /// \param count Maximum number of bytes to move. The transfer also stops at end of input.
+    /// \param method If not \p nullptr, receives the mechanism that moved the data
+    /// \return The number of bytes moved, or the \p errno of the failing call, with the number of
+    /// bytes moved before the failure in its context.
+    [[nodiscard]] inline Result<std::size_t> splice_fd(const int in, const int out, const std::size_t count,
+                                                       CopyMethod *method = nullptr) {
+        std::size_t total = 0;
+        VoidResult status{};
+
+        // Returns true if the mechanism handled the transfer, successfully or not.
+        auto attempt = [&](const CopyMethod used, auto &&step) {
+            status = detail::pump(step, count, total);
+            if (status || total != 0 || !detail::is_unsupported_transfer(status.error())) {
+                if (method != nullptr) {
+                    *method = used;
+                }
+                return true;
+            }
+            return false;
+        };
+
+#ifdef __linux__
+        const bool done = attempt(CopyMethod::copy_file_range, [&](const std::size_t length) {
+            return invoke_with_syscall_api<ErrnoMode::on_failure>([&] noexcept {
+                return ::copy_file_range(in, nullptr, out, nullptr, length, 0);
+            }, "Copying with copy_file_range");
+        }) || attempt(CopyMethod::sendfile, [&](const std::size_t length) {
+            return invoke_with_syscall_api<ErrnoMode::on_failure>([&] noexcept {
+                return ::sendfile(out, in, nullptr, length);
+            }, "Copying with sendfile");
+        }) || attempt(CopyMethod::splice, [&](const std::size_t length) {
+            return invoke_with_syscall_api<ErrnoMode::on_failure>([&] noexcept {
+                return ::splice(in, nullptr, out, nullptr, length, SPLICE_F_MOVE);
+            }, "Copying with splice");
+        });
+#else
+        constexpr bool done = false;
+#endif
+
+        if (!done) {
+            attempt(CopyMethod::read_write, [&](const std::size_t length) {
+                return detail::read_write_step(in, out, length, total);
+            });
+            if (method != nullptr) {
+                *method = CopyMethod::read_write;
+            }
+        }
+
+        if (!status) {
+            if (total == 0) {
+                return std::unexpected(std::move(status).error());
+            }
+            // The destination is valid up to the bytes already moved
+            return std::unexpected(Error{detail::unobserved, status.error().error_code(),
+                                         std::format("{} after {} bytes", status.error().context(), total)});
+        }
+        return total;
+    }
+
+    /// Copy the contents of a file into another, creating or truncating the destination.
+    ///
+    /// The destination is created with the permission bits of the source (subject to the
+    /// process umask). The data is moved with \p splice_fd(). A destination that is the source
+    /// itself, through the same path, a hard link or a symbolic link, is rejected before it is
+    /// truncated.
+    ///
+    /// \param src Path of the file to copy
+    /// \param dst Path of the destination file
+    /// \param method If not \p nullptr, receives the mechanism that moved the data
+    /// \return The number of bytes copied, or an error naming the failing step and paths;
+    /// \p std::errc::invalid_argument if \p dst is the same file as \p src.
+    [[nodiscard]] inline Result<std::size_t> copy_file(const std::string &src, const std::string &dst,
+                                                       CopyMethod *method = nullptr) {
+        const auto in = open_fd(src, O_RDONLY | O_CLOEXEC);
+        if (!in) {
+            return std::unexpected(in.error());
+        }
+
+        struct stat st{};
+        if (const auto stat_result = invoke_with_syscall_api(
+            [&] noexcept { return ::fstat(in->get(), &st); }, std::format("Querying the attributes of '{}'", src));
+            !stat_result) {
+            return std::unexpected(stat_result.error());
+        }
+
+        // Truncated only once it is known not to be the source
+        auto out = open_fd(dst, O_WRONLY | O_CREAT | O_CLOEXEC, st.st_mode & 07777);
+        // The errors below were already reported when created, so they are rewrapped unobserved
+        if (!out) {
+            return std::unexpected(Error{detail::unobserved, out.error().error_code(),
+                                         std::format("Creating '{}'", dst)});
+        }
+
+        struct stat dst_st{};
+        if (const auto stat_result = invoke_with_syscall_api(
+            [&] noexcept { return ::fstat(out->get(), &dst_st); }, std::format("Querying the attributes of '{}'", dst));
+            !stat_result) {
+            return std::unexpected(stat_result.error());
+        }
+        if (dst_st.st_dev == st.st_dev && dst_st.st_ino == st.st_ino) {
+            return make_error<std::size_t>(std::errc::invalid_argument,
+                                           std::format("Copying '{}' to '{}': same file", src, dst));
+        }
+        if (const auto truncated = invoke_with_syscall_api(
+            [&] noexcept { return ::ftruncate(out->get(), 0); }, std::format("Truncating '{}'", dst));
+            !truncated) {
+            return std::unexpected(truncated.error());
+        }
+
+        auto copied = splice_fd(in->get(), out->get(), std::numeric_limits<std::size_t>::max(), method);
+        if (!copied) {
+            return std::unexpected(Error{detail::unobserved, copied.error().error_code(),
+                                         std::format("Copying '{}' to '{}': {}", src, dst, copied.error().context())});
+        }
+        if (auto closed = out->close(); !closed) {
+            return std::unexpected(Error{detail::unobserved, closed.error().error_code(),
+                                         std::format("Closing '{}'", dst)});
+        }
+        return copied;
+    }
+} // namespace error_utils
@@ -0,0 +1,660 @@
+// MIT License
+//
+// Copyright (c) 2025 Ian Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+/// \file
+/// \brief Error metrics: counts of errors by category and value.
+///
+/// \details \p ErrorCounters counts errors in per-thread shards, so that recording an error is
+/// one relaxed increment on a cache line owned by the calling thread, without locks or
+/// read-modify-write operations. The shards are only aggregated when a snapshot is taken,
+/// and a snapshot groups the counts by \p ExtraErrorCondition or by any \p std::error_condition.
+/// \p CountingObserver feeds the counters with every \p Error created.
+///
+/// \p ErrorTable aggregates distinct errors, telling apart the contexts, with their count, the
+/// first and last times they were seen and a sample of their context, in a bounded table.
+
+#pragma once
+
+/// \cond
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+/// \endcond
+
+#include "error_utils.hpp"
+
+
+namespace error_utils {
+    namespace detail {
+        /// A counter of one \p (category, value) pair.
+        ///
+        /// The key is written once by the owner of the shard, the category last with release
+        /// semantics, so a reader that sees the category also sees the value.
+        struct counter_slot {
+            std::atomic<const std::error_category *> category{};
+            std::atomic<int> value{};
+            std::atomic<std::uint64_t> count{};
+        };
+
+        /// The counters of one thread: an open-addressing table written by that thread only.
+        struct alignas(64) counter_shard {
+            static constexpr std::size_t capacity = 256;
+
+            std::array<counter_slot, capacity> slots{};
+            std::atomic<std::uint64_t> overflow{};  ///< Counts that found no free slot
+
+            [[nodiscard]] static std::size_t hash(const std::error_category &category, const int value) noexcept {
+                const auto bits = reinterpret_cast<std::uintptr_t>(&category) >> 4 ^
+                                  static_cast<std::uintptr_t>(static_cast<unsigned>(value));
+                return static_cast<std::size_t>(bits * 0x9e37'79b9'7f4a'7c15ULL >> 32);
+            }
+
+            /// Add \p n to the counter of \p (category, value). Only called by the owning thread.
+            void add(const std::error_category &category, const int value, const std::uint64_t n) noexcept {
+                std::size_t index = hash(category, value);
+                for (std::size_t probe = 0; probe < capacity; ++probe, ++index) {
+                    counter_slot &slot = slots[index % capacity];
+                    const std::error_category *owner = slot.category.load(std::memory_order_relaxed);
+                    if (owner == nullptr) [[unlikely]] {
+                        slot.value.store(value, std::memory_order_relaxed);
+                        slot.category.store(&category, std::memory_order_release);
+                        owner = &category;
+                    }
+                    if (owner == &category && slot.value.load(std::memory_order_relaxed) == value) {
+                        // Single writer: a load and a store, without a locked instruction
+                        slot.count.store(slot.count.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+                        return;
+                    }
+                }
+                overflow.store(overflow.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+            }
+        };
+
+        /// The shards of an \p ErrorCounters, shared with the threads that use them.
+        ///
+        /// A thread takes a shard on its first error and gives it back when it exits, so that
+        /// another thread may reuse it. The counts of a shard are kept when its thread exits.
+        struct counter_registry {
+            std::mutex mutex{};
+            std::vector<std::unique_ptr<counter_shard>> shards{};
+            std::vector<counter_shard *> idle{};
+
+            [[nodiscard]] counter_shard *acquire() {
+                std::scoped_lock lock{mutex};
+                if (!idle.empty()) {
+                    counter_shard *shard = idle.back();
+                    idle.pop_back();
+                    return shard;
+                }
+                shards.push_back(std::make_unique<counter_shard>());
+                idle.reserve(shards.size());  // So that release() never allocates
+                return shards.back().get();
+            }
+
+            void release(counter_shard *shard) noexcept {
+                std::scoped_lock lock{mutex};
+                idle.push_back(shard);
+            }
+        };
+
+        /// The shards bound to the current thread, given back to their registries at thread exit.
+        struct counter_bindings {
+            struct Binding {
+                std::uint64_t id;
+                counter_shard *shard;
+                std::weak_ptr<counter_registry> registry;
+            };
+
+            std::vector<Binding> bindings{};
+
+            counter_bindings() = default;
+            counter_bindings(const counter_bindings &) = delete;
+            counter_bindings &operator=(const counter_bindings &) = delete;
+
+            ~counter_bindings();
+        };
+
+        inline thread_local counter_bindings thread_counter_bindings{};
+
+        // The last shard used by this thread. Trivial, so reading them needs no TLS guard.
+        inline thread_local std::uint64_t cached_counters_id{};
+        inline thread_local counter_shard *cached_counter_shard{};
+
+        inline counter_bindings::~counter_bindings() {
+            // Errors recorded later on this thread must not touch the shards given back
+            cached_counters_id = 0;
+            cached_counter_shard = nullptr;
+            for (auto &binding : bindings) {
+                if (const auto registry = binding.registry.lock()) {
+                    registry->release(binding.shard);
+                }
+            }
+        }
+    } // namespace detail
+
+    /// The number of errors recorded with one error code.
+    struct ErrorCount {
+        std::error_code code;
+        std::uint64_t count;
+    };
+
+    /// The counts of an \p ErrorCounters at one point in time, aggregated over all threads.
+    class ErrorCountSnapshot {
+        // clang-format off
+        // @formatter:off
+
+        std::vector<ErrorCount> counts_{};  ///< One entry per error code, by category name and value
+        std::uint64_t overflow_{};          ///< Errors that could not be counted by code
+
+        // clang-format on
+        // @formatter:on
+
+        friend class ErrorCounters;
+
+    public:
+        ErrorCountSnapshot() = default;
+
+        ErrorCountSnapshot(std::vector<ErrorCount> counts, const std::uint64_t overflow)
+            : counts_{std::move(counts)}, overflow_{overflow} {}
+
+        /// \return The count of each error code seen, sorted by category name and value
+        [[nodiscard]] std::span<const ErrorCount> counts() const noexcept { return counts_; }
+
+        /// \return The number of errors that were counted without their code, because a thread
+        /// saw more distinct codes than its shard holds. They are included in \p total().
+        [[nodiscard]] std::uint64_t overflow() const noexcept { return overflow_; }
+
+        /// \return The total number of errors recorded
+        [[nodiscard]] std::uint64_t total() const noexcept {
+            std::uint64_t sum = overflow_;
+            for (const auto &entry : counts_) {
+                sum += entry.count;
+            }
+            return sum;
+        }
+
+        /// Count the errors matching a code or a condition, with the same rules as \p Error::is().
+        /// \param code An error code, an error condition, or an enum convertible to either
+        /// \return The number of recorded errors that match \p code
+        template <typename T>
+            requires detail::comparable_to_error_code<T>
+        [[nodiscard]] std::uint64_t count(const T &code) const {
+            std::uint64_t sum = 0;
+            for (const auto &entry : counts_) {
+                if (Error{detail::unobserved, entry.code}.is(T{code})) {
+                    sum += entry.count;
+                }
+            }
+            return sum;
+        }
+
+        /// Group the counts by error condition.
+        ///
+        /// An error is counted under every condition it matches, and under none if it matches none.
+        /// \param conditions The conditions to group by
+        /// \return The count for each of \p conditions, in the same order
+        [[nodiscard]] std::vector<std::uint64_t>
+        by_condition(const std::span<const std::error_condition> conditions) const {
+            std::vector<std::uint64_t> sums(conditions.size());
+            for (const auto &entry : counts_) {
+                for (std::size_t i = 0; i < conditions.size(); ++i) {
+                    if (entry.code == conditions[i]) {
+                        sums[i] += entry.count;
+                    }
+                }
+            }
+            return sums;
+        }
+
+        /// Group the counts by \p ExtraErrorCondition.
+        /// \return The count for each condition, from \p logic_error to \p other_error
+        [[nodiscard]] std::array<std::pair<ExtraErrorCondition, std::uint64_t>, 5> by_extra_condition() const {
+            std::array<std::pair<ExtraErrorCondition, std::uint64_t>, 5> sums{{
+                {ExtraErrorCondition::logic_error, 0},
+                {ExtraErrorCondition::runtime_error, 0},
+                {ExtraErrorCondition::resource_error, 0},
+                {ExtraErrorCondition::access_error, 0},
+                {ExtraErrorCondition::other_error, 0},
+            }};
+            for (const auto &entry : counts_) {
+                for (auto &[condition, sum] : sums) {
+                    if (entry.code == make_error_condition(condition)) {
+                        sum += entry.count;
+                    }
+                }
+            }
+            return sums;
+        }
+    };
+
+    /// Counters of errors by \p (category, value), sharded per thread.
+    ///
+    /// \p record() increments a counter in a table owned by the calling thread, with a relaxed
+    /// load and store; the first error of a thread takes a shard from the registry, under a
+    /// lock. \p snapshot() adds up the shards of all the threads. Counts survive the threads
+    /// that made them.
+    ///
+    /// \code
+    /// error_utils::ErrorCounters counters;
+    /// counters.record(error);
+    /// auto snapshot = counters.snapshot();
+    /// std::uint64_t resource_errors = snapshot.count(ExtraErrorCondition::resource_error);
+    /// \endcode
+    class ErrorCounters {
+        // clang-format off
+        // @formatter:off
+
+        std::shared_ptr<detail::counter_registry> registry_{std::make_shared<detail::counter_registry>()};
+        std::uint64_t id_{next_id()};       ///< Never reused, unlike the address of the object
+
+        // clang-format on
+        // @formatter:on
+
+        [[nodiscard]] static std::uint64_t next_id() noexcept {
+            static std::atomic<std::uint64_t> last{};
+            return last.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+
+        /// Find or take the shard of the calling thread.
+        /// \return The shard, or null if it could not be allocated
+        [[nodiscard]] detail::counter_shard *bind() noexcept {
+            auto &bindings = detail::thread_counter_bindings.bindings;
+            detail::counter_shard *shard = nullptr;
+            for (const auto &binding : bindings) {
+                if (binding.id == id_) {
+                    shard = binding.shard;
+                }
+            }
+            if (shard == nullptr) {
+                try {
+                    std::erase_if(bindings, [](const auto &binding) { return binding.registry.expired(); });
+                    bindings.reserve(bindings.size() + 1);
+                    shard = registry_->acquire();
+                    bindings.push_back({id_, shard, registry_});
+                } catch (...) {
+                    return nullptr;
+                }
+            }
+            detail::cached_counters_id = id_;
+            detail::cached_counter_shard = shard;
+            return shard;
+        }
+
+    public:
+        ErrorCounters() = default;
+        ErrorCounters(const ErrorCounters &) = delete;
+        ErrorCounters &operator=(const ErrorCounters &) = delete;
+
+        /// Count an error code. Success codes are ignored.
+        /// \param code The code of the error
+        /// \param n The number of errors to count
+        void record(const std::error_code &code, const std::uint64_t n = 1) noexcept {
+            if (!code) {
+                return;
+            }
+            detail::counter_shard *shard = detail::cached_counter_shard;
+            if (detail::cached_counters_id != id_) [[unlikely]] {
+                shard = bind();
+                if (shard == nullptr) {
+                    return;
+                }
+            }
+            shard->add(code.category(), code.value(), n);
+        }
+
+        /// Count an error by its code.
+        void record(const Error &error, const std::uint64_t n = 1) noexcept { record(error.error_code(), n); }
+
+        /// Add up the counts of all the threads into \p into, reusing its storage, so that periodic
+        /// snapshots stop allocating once it is large enough.
+        ///
+        /// Counts recorded concurrently may or may not be included.
+        void snapshot(ErrorCountSnapshot &into) const {
+            auto &counts = into.counts_;
+            counts.clear();
+            into.overflow_ = 0;
+            {
+                std::scoped_lock lock{registry_->mutex};
+                for (const auto &shard : registry_->shards) {
+                    for (const auto &slot : shard->slots) {
+                        const std::error_category *category = slot.category.load(std::memory_order_acquire);
+                        if (category != nullptr) {
+                            const std::error_code code{slot.value.load(std::memory_order_relaxed), *category};
+                            counts.push_back({code, slot.count.load(std::memory_order_relaxed)});
+                        }
+                    }
+                    into.overflow_ += shard->overflow.load(std::memory_order_relaxed);
+                }
+            }
+
+            // Sort by category name, value and category, then merge the counts of the same code
+            std::ranges::sort(counts, [](const ErrorCount &a, const ErrorCount &b) {
+                if (const int order = std::strcmp(a.code.category().name(), b.code.category().name()); order != 0) {
+                    return order < 0;
+                }
+                if (a.code.value() != b.code.value()) {
+                    return a.code.value() < b.code.value();
+                }
+                return std::less{}(&a.code.category(), &b.code.category());
+            });
+            std::size_t merged = 0;
+            for (std::size_t i = 0; i < counts.size(); ++i) {
+                if (merged != 0 && counts[merged - 1].code == counts[i].code) {
+                    counts[merged - 1].count += counts[i].count;
+                } else {
+                    counts[merged++] = counts[i];
+                }
+            }
+            counts.resize(merged);
+        }
+
+        /// Add up the counts of all the threads.
+        ///
+        /// Counts recorded concurrently may or may not be included.
+        /// \return The counts by error code
+        [[nodiscard]] ErrorCountSnapshot snapshot() const {
+            ErrorCountSnapshot snapshot;
+            this->snapshot(snapshot);
+            return snapshot;
+        }
+    };
+
+    /// An \p ErrorObserver counting every error created into an \p ErrorCounters.
+    ///
+    /// \code
+    /// static error_utils::ErrorCounters counters;
+    /// static error_utils::CountingObserver observer{counters};
+    /// error_utils::set_error_observer(&observer);
+    /// \endcode
+    class CountingObserver final : public ErrorObserver {
+        ErrorCounters &counters_;
+
+    public:
+        explicit CountingObserver(ErrorCounters &counters) noexcept : counters_{counters} {}
+
+        void on_error(const std::error_code &code, std::string_view, const std::source_location &) noexcept override {
+            counters_.record(code);
+        }
+    };
+
+    namespace detail {
+        /// An entry of an \p ErrorTable.
+        ///
+        /// The key is the sequence of the entry: zero while free, \p claiming while its fields are
+        /// written, and the odd hash of the error once published with release semantics.
+        struct alignas(64) aggregate_slot {
+            static constexpr std::uint64_t claiming = 2;
+            static constexpr std::size_t context_capacity = 64;
+            static constexpr std::size_t context_words = context_capacity / sizeof(std::uint64_t);
+
+            std::atomic<std::uint64_t> key{};
+            std::atomic<std::uint64_t> count{};
+            std::atomic<std::int64_t> last_seen{};      ///< In nanoseconds since the epoch of \p system_clock
+            std::atomic<std::int64_t> first_seen{};
+            std::atomic<const std::error_category *> category{};
+            std::atomic<int> value{};
+            std::atomic<std::uint32_t> length{};
+            std::array<std::atomic<std::uint64_t>, context_words> context{};
+
+            /// Write the fields of a newly claimed entry, before publishing its key.
+            void fill(const std::error_code &code, const std::string_view sample, const std::int64_t now) noexcept {
+                count.store(1, std::memory_order_relaxed);
+                first_seen.store(now, std::memory_order_relaxed);
+                last_seen.store(now, std::memory_order_relaxed);
+                category.store(&code.category(), std::memory_order_relaxed);
+                value.store(code.value(), std::memory_order_relaxed);
+                const auto size = static_cast<std::uint32_t>(std::min(sample.size(), context_capacity));
+                length.store(size, std::memory_order_relaxed);
+                std::array<std::uint64_t, context_words> words{};
+                std::memcpy(words.data(), sample.data(), size);
+                for (std::size_t i = 0; i < context_words; ++i) {
+                    context[i].store(words[i], std::memory_order_relaxed);
+                }
+            }
+        };
+
+        /// \return The time since the epoch of \p system_clock, from the coarse clock where there is one:
+        /// a few milliseconds of resolution, for a fraction of the cost of \p system_clock::now()
+        [[nodiscard]] inline std::int64_t coarse_system_nanoseconds() noexcept {
+#ifdef CLOCK_REALTIME_COARSE
+            timespec now{};
+            ::clock_gettime(CLOCK_REALTIME_COARSE, &now);
+            return std::int64_t{now.tv_sec} * 1'000'000'000 + now.tv_nsec;
+#else
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+#endif
+        }
+    } // namespace detail
+
+    /// A distinct error of an \p ErrorTable.
+    struct ErrorStat {
+        std::error_code code;                               ///< The error code
+        std::string context;                                ///< The context of the first occurrence, truncated
+        std::uint64_t count{};                              ///< The number of occurrences
+        std::chrono::system_clock::time_point first_seen;   ///< When the error was first seen
+        std::chrono::system_clock::time_point last_seen;    ///< When the error was last seen
+    };
+
+    /// Aggregates distinct errors, telling apart their contexts, in a concurrent bounded table.
+    ///
+    /// Errors are keyed by the hash of their error code and of their context, as with
+    /// \p ErrorContextHash; errors whose hashes collide on their low 63 bits are merged. Each
+    /// distinct error keeps its count, the first and last times it was seen, and the first 64
+    /// characters of its context.
+    ///
+    /// The table is open-addressing with double hashing, with one cache line per entry, and is
+    /// allocated once: adding an error is lock-free and does not allocate. A repeated error
+    /// costs a hash, an atomic increment and a read of the coarse clock, so the times have a
+    /// resolution of a few milliseconds on Linux. When the entries probed for a new error are
+    /// all taken, the least recently seen one is evicted, and its count is added to
+    /// \p evicted(). An occurrence racing with the eviction of its entry may be counted in the
+    /// error that replaces it.
+    /// \code
+    /// error_utils::ErrorTable table{4096};  // 4096 distinct errors, 512 KiB
+    /// table.record(error);
+    /// for (const auto &stat : table.snapshot()) {
+    ///     std::println("{} x {}: {}", stat.count, stat.code.message(), stat.context);
+    /// }
+    /// \endcode
+    class ErrorTable final : public ErrorObserver {
+        /// The number of entries probed for an error before evicting one of them
+        static constexpr std::size_t probe_limit = 16;
+
+        // clang-format off
+        // @formatter:off
+
+        std::size_t mask_;
+        std::unique_ptr<detail::aggregate_slot[]> slots_;
+        std::atomic<std::uint64_t> evicted_{};
+
+        // clang-format on
+        // @formatter:on
+
+        /// \return The key of an error: its hash above a set low bit, which tells a published
+        /// key from the free and claimed entries
+        [[nodiscard]] static std::uint64_t key_of(const std::error_code &code,
+                                                  const std::string_view context) noexcept {
+            return static_cast<std::uint64_t>(detail::hash_error(code, context)) << 1 | 1;
+        }
+
+        static void touch(detail::aggregate_slot &slot, const std::int64_t now) noexcept {
+            slot.count.fetch_add(1, std::memory_order_relaxed);
+            if (slot.last_seen.load(std::memory_order_relaxed) < now) {
+                slot.last_seen.store(now, std::memory_order_relaxed);
+            }
+        }
+
+        /// Claim \p slot from \p expected, fill it and publish it.
+        /// \return False if another thread changed the slot first
+        [[nodiscard]] static bool claim(detail::aggregate_slot &slot, std::uint64_t expected, const std::uint64_t key,
+                                        const std::error_code &code, const std::string_view context,
+                                        const std::int64_t now) noexcept {
+            if (!slot.key.compare_exchange_strong(expected, detail::aggregate_slot::claiming,
+                                                  std::memory_order_acquire, std::memory_order_relaxed)) {
+                return false;
+            }
+            slot.fill(code, context, now);
+            slot.key.store(key, std::memory_order_release);
+            return true;
+        }
+
+    public:
+        /// Allocate the table.
+        /// \param capacity The maximum number of distinct errors, rounded up to a power of two;
+        /// each takes 128 bytes
+        explicit ErrorTable(const std::size_t capacity = 4096)
+            : mask_{std::bit_ceil(std::max<std::size_t>(capacity, probe_limit)) - 1},
+              slots_{std::make_unique<detail::aggregate_slot[]>(mask_ + 1)} {}
+
+        ErrorTable(const ErrorTable &) = delete;
+        ErrorTable &operator=(const ErrorTable &) = delete;
+
+        /// \return The maximum number of distinct errors
+        [[nodiscard]] std::size_t capacity() const noexcept { return mask_ + 1; }
+
+        /// \return The number of occurrences counted in entries that were evicted
+        [[nodiscard]] std::uint64_t evicted() const noexcept { return evicted_.load(std::memory_order_relaxed); }
+
+        /// Count an occurrence of an error. Success codes are ignored.
+        /// \param code The error code
+        /// \param context The context of the error
+        void record(const std::error_code &code, const std::string_view context = {}) noexcept {
+            if (!code) {
+                return;
+            }
+            const std::uint64_t key = key_of(code, context);
+            // Double hashing: each entry is a cache line of its own, so probing the next ones
+            // would only cluster the errors. An odd step visits every entry.
+            const std::size_t home = static_cast<std::size_t>(key >> 1);
+            const std::size_t step = static_cast<std::size_t>(key >> 33) | 1;
+            const std::int64_t now = detail::coarse_system_nanoseconds();
+            while (true) {
+                detail::aggregate_slot *victim = nullptr;
+                std::uint64_t victim_key = 0;
+                for (std::size_t probe = 0; probe < probe_limit; ++probe) {
+                    auto &slot = slots_[(home + probe * step) & mask_];
+                    const std::uint64_t current = slot.key.load(std::memory_order_acquire);
+                    if (current == key) {
+                        touch(slot, now);
+                        return;
+                    }
+                    if (current == 0) {
+                        if (claim(slot, 0, key, code, context, now)) {
+                            return;
+                        }
+                        --probe;  // Claimed by another thread, maybe for the same error: look again
+                        continue;
+                    }
+                    if (current != detail::aggregate_slot::claiming &&
+                        (victim == nullptr || slot.last_seen.load(std::memory_order_relaxed) <
+                                              victim->last_seen.load(std::memory_order_relaxed))) {
+                        victim = &slot;
+                        victim_key = current;
+                    }
+                }
+                if (victim == nullptr) {
+                    // Every probed entry is being claimed: count the error as evicted
+                    evicted_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                const std::uint64_t lost = victim->count.load(std::memory_order_relaxed);
+                if (claim(*victim, victim_key, key, code, context, now)) {
+                    evicted_.fetch_add(lost, std::memory_order_relaxed);
+                    return;
+                }
+            }
+        }
+
+        /// Count an occurrence of an \p Error.
+        void record(const Error &error) noexcept { record(error.error_code(), error.context()); }
+
+        void on_error(const std::error_code &code, const std::string_view context,
+                      const std::source_location &) noexcept override {
+            record(code, context);
+        }
+
+        /// Copy the distinct errors, most frequent first. Entries being written are skipped.
+        [[nodiscard]] std::vector<ErrorStat> snapshot() const {
+            const auto time_point = [](const std::int64_t nanoseconds) {
+                return std::chrono::system_clock::time_point{std::chrono::duration_cast<
+                    std::chrono::system_clock::duration>(std::chrono::nanoseconds{nanoseconds})};
+            };
+            std::vector<ErrorStat> stats;
+            // Two threads adding a new error at once may each claim an entry for it: merge them
+            std::unordered_map<std::uint64_t, std::size_t> positions;
+            std::array<std::uint64_t, detail::aggregate_slot::context_words> words{};
+            for (std::size_t index = 0; index <= mask_; ++index) {
+                const auto &slot = slots_[index];
+                const std::uint64_t key = slot.key.load(std::memory_order_acquire);
+                if (key % 2 == 0) {
+                    continue;
+                }
+                const auto *category = slot.category.load(std::memory_order_relaxed);
+                const int value = slot.value.load(std::memory_order_relaxed);
+                const auto length = std::min<std::size_t>(slot.length.load(std::memory_order_relaxed),
+                                                          detail::aggregate_slot::context_capacity);
+                for (std::size_t i = 0; i < words.size(); ++i) {
+                    words[i] = slot.context[i].load(std::memory_order_relaxed);
+                }
+                const std::int64_t first_seen = slot.first_seen.load(std::memory_order_relaxed);
+                const std::int64_t last_seen = slot.last_seen.load(std::memory_order_relaxed);
+                const std::uint64_t count = slot.count.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.key.load(std::memory_order_relaxed) != key) {
+                    continue;  // Evicted while reading
+                }
+                if (const auto [position, added] = positions.try_emplace(key, stats.size()); !added) {
+                    ErrorStat &stat = stats[position->second];
+                    stat.count += count;
+                    stat.first_seen = std::min(stat.first_seen, time_point(first_seen));
+                    stat.last_seen = std::max(stat.last_seen, time_point(last_seen));
+                    continue;
+                }
+                std::string context(length, '\0');
+                std::memcpy(context.data(), words.data(), length);
+                stats.push_back({std::error_code{value, *category}, std::move(context), count,
+                                 time_point(first_seen), time_point(last_seen)});
+            }
+            std::ranges::sort(stats, std::ranges::greater{}, &ErrorStat::count);
+            return stats;
+        }
+    };
+} // namespace error_utils
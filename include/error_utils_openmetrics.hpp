@@ -0,0 +1,365 @@
+// MIT License
+//
+// Copyright (c) 2025 Ian Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+/// \file
+/// \brief Export of error counts in the OpenMetrics text format, read by Prometheus.
+///
+/// \details \p OpenMetricsExporter renders the counts of an \p ErrorCounters as a counter
+/// family labelled by category name, value and condition. The exposition is rendered a few
+/// whole lines at a time into a caller buffer, or written to a file descriptor, and does not
+/// allocate once the snapshot storage has grown to the number of distinct codes. A file or a
+/// Unix socket serves as a local scrape endpoint.
+
+#pragma once
+
+/// \cond
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+/// \endcond
+
+#include "error_utils.hpp"
+#include "error_utils_io.hpp"
+#include "error_utils_metrics.hpp"
+
+
+namespace error_utils {
+    namespace detail {
+        /// Appends text to a caller buffer, remembering whether it ran out of space.
+        class metrics_appender {
+            std::span<char> buffer_;
+            std::size_t size_{};
+            bool overflow_{};
+
+        public:
+            explicit metrics_appender(const std::span<char> buffer) noexcept : buffer_{buffer} {}
+
+            [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+            [[nodiscard]] bool overflow() const noexcept { return overflow_; }
+
+            /// Forget the text appended after \p size.
+            void truncate(const std::size_t size) noexcept {
+                size_ = size;
+                overflow_ = false;
+            }
+
+            void append(const std::string_view text) noexcept {
+                if (overflow_ || text.size() > buffer_.size() - size_) {
+                    overflow_ = true;
+                    return;
+                }
+                std::memcpy(buffer_.data() + size_, text.data(), text.size());
+                size_ += text.size();
+            }
+
+            void append(const std::integral auto number) noexcept {
+                std::array<char, 24> digits{};
+                const auto end = std::to_chars(digits.data(), digits.data() + digits.size(), number).ptr;
+                append(std::string_view{digits.data(), end});
+            }
+
+            /// Append a label value, escaping backslashes, double quotes and line feeds.
+            void append_label(const std::string_view text) noexcept {
+                for (const char c : text) {
+                    switch (c) {
+                        case '\\': append("\\\\"); break;
+                        case '"': append("\\\""); break;
+                        case '\n': append("\\n"); break;
+                        default: append(std::string_view{&c, 1});
+                    }
+                }
+            }
+        };
+
+        /// The label of each \p ExtraErrorCondition, by value minus one.
+        inline constexpr std::array<std::string_view, 5> extra_condition_labels{
+            "logic_error", "runtime_error", "resource_error", "access_error", "other_error",
+        };
+
+        /// Append the condition label of \p code: the first \p ExtraErrorCondition it matches,
+        /// or else its default error condition, as in \p generic:104.
+        inline void append_condition(metrics_appender &out, const std::error_code &code) noexcept {
+            for (std::size_t i = 0; i < extra_condition_labels.size(); ++i) {
+                if (code == make_error_condition(static_cast<ExtraErrorCondition>(i + 1))) {
+                    out.append(extra_condition_labels[i]);
+                    return;
+                }
+            }
+            const std::error_condition condition = code.default_error_condition();
+            out.append_label(condition.category().name());
+            out.append(":");
+            out.append(condition.value());
+        }
+    } // namespace detail
+
+    /// Renders the counts of an \p ErrorCounters in the OpenMetrics text format.
+    ///
+    /// Each scrape starts with \p begin(), which takes a snapshot of the counters; \p render()
+    /// then fills caller buffers with whole lines until \p done(). The exposition holds one
+    /// counter family, \p <name>_total, with a sample per error code, and a family
+    /// \p <name>_uncounted for the errors counted without their code:
+    /// \code
+    /// # TYPE errors counter
+    /// # HELP errors Errors recorded, by error code.
+    /// errors_total{category="generic",value="104",condition="generic:104"} 12
+    /// ...
+    /// # EOF
+    /// \endcode
+    ///
+    /// The exporter reuses its snapshot and its buffer from one scrape to the next, so that
+    /// scrapes do not allocate once warmed up. It must not be used by two threads at once.
+    class OpenMetricsExporter {
+        /// The lines that are not samples: TYPE and HELP of both families, their sample, and EOF
+        static constexpr std::size_t fixed_lines = 6;
+
+        // clang-format off
+        // @formatter:off
+
+        const ErrorCounters &counters_;
+        std::string name_;
+        ErrorCountSnapshot snapshot_{};
+        std::size_t line_{fixed_lines};         ///< The next line of the exposition to render
+        std::array<char, 4096> buffer_{};       ///< Used by write_to()
+
+        // clang-format on
+        // @formatter:on
+
+        [[nodiscard]] std::size_t line_count() const noexcept { return snapshot_.counts().size() + fixed_lines; }
+
+        void render_line(const std::size_t line, detail::metrics_appender &out) const noexcept {
+            const std::size_t samples = snapshot_.counts().size();
+            if (line == 0) {
+                out.append("# TYPE ");
+                out.append(name_);
+                out.append(" counter\n");
+            } else if (line == 1) {
+                out.append("# HELP ");
+                out.append(name_);
+                out.append(" Errors recorded, by error code.\n");
+            } else if (line < samples + 2) {
+                const ErrorCount &entry = snapshot_.counts()[line - 2];
+                out.append(name_);
+                out.append("_total{category=\"");
+                out.append_label(entry.code.category().name());
+                out.append("\",value=\"");
+                out.append(entry.code.value());
+                out.append("\",condition=\"");
+                detail::append_condition(out, entry.code);
+                out.append("\"} ");
+                out.append(entry.count);
+                out.append("\n");
+            } else if (line == samples + 2) {
+                out.append("# TYPE ");
+                out.append(name_);
+                out.append("_uncounted counter\n");
+            } else if (line == samples + 3) {
+                out.append("# HELP ");
+                out.append(name_);
+                out.append("_uncounted Errors recorded without their code, past the distinct codes of a thread.\n");
+            } else if (line == samples + 4) {
+                out.append(name_);
+                out.append("_uncounted_total ");
+                out.append(snapshot_.overflow());
+                out.append("\n");
+            } else {
+                out.append("# EOF\n");
+            }
+        }
+
+        /// Write all of \p text to \p fd.
+        [[nodiscard]] static VoidResult write_all(const int fd, std::string_view text) noexcept {
+            while (!text.empty()) {
+                const auto written = invoke_with_syscall_api([&] noexcept {
+                    return ::write(fd, text.data(), text.size());
+                }, "Writing OpenMetrics");
+                if (!written) {
+                    if (written.error().is(std::errc::interrupted)) {
+                        continue;
+                    }
+                    return std::unexpected(written.error());
+                }
+                text.remove_prefix(static_cast<std::size_t>(*written));
+            }
+            return {};
+        }
+
+    public:
+        /// Create an exporter for \p counters, which must outlive it.
+        /// \param counters The counters to export
+        /// \param name The name of the metric family, matching <tt>[a-zA-Z_:][a-zA-Z0-9_:]*</tt>
+        explicit OpenMetricsExporter(const ErrorCounters &counters, std::string name = "errors")
+            : counters_{counters}, name_{std::move(name)} {}
+
+        /// Start a scrape, with a snapshot of the counters.
+        void begin() {
+            counters_.snapshot(snapshot_);
+            line_ = 0;
+        }
+
+        /// \return True if the scrape started by \p begin() has been fully rendered
+        [[nodiscard]] bool done() const noexcept { return line_ >= line_count(); }
+
+        /// Render the next whole lines of the scrape into \p buffer.
+        /// \param buffer Where to render the lines
+        /// \return The number of characters rendered, zero once \p done(), or an error if
+        /// the next line does not fit in the whole buffer
+        [[nodiscard]] Result<std::size_t> render(const std::span<char> buffer) noexcept {
+            detail::metrics_appender out{buffer};
+            while (!done()) {
+                const std::size_t size = out.size();
+                render_line(line_, out);
+                if (out.overflow()) {
+                    out.truncate(size);
+                    if (size == 0) {
+                        return make_error<std::size_t>(std::errc::no_buffer_space,
+                                                       "OpenMetrics line larger than the buffer");
+                    }
+                    break;
+                }
+                ++line_;
+            }
+            return out.size();
+        }
+
+        /// Write a whole scrape to \p fd.
+        /// \param fd The file descriptor to write to
+        /// \return An error if a write failed
+        VoidResult write_to(const int fd) {
+            begin();
+            while (!done()) {
+                const auto size = render(buffer_);
+                if (!size) {
+                    return std::unexpected(size.error());
+                }
+                if (auto written = write_all(fd, {buffer_.data(), *size}); !written) {
+                    return written;
+                }
+            }
+            return {};
+        }
+
+        /// Write a whole scrape to a file, replaced atomically, such as the text file collector
+        /// of the node exporter reads.
+        /// \param path The path of the file; a temporary file is written next to it
+        /// \return An error if the file could not be written
+        VoidResult write_file(const std::string &path) {
+            const std::string temporary = path + ".tmp";
+            auto fd = open_fd(temporary, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (!fd) {
+                return std::unexpected(fd.error());
+            }
+            if (auto written = write_to(fd->get()); !written) {
+                return written;
+            }
+            if (auto closed = fd->close(); !closed) {
+                return closed;
+            }
+            if (const auto renamed = invoke_with_syscall_api([&] noexcept {
+                return ::rename(temporary.c_str(), path.c_str());
+            }, "Renaming OpenMetrics file"); !renamed) {
+                return std::unexpected(renamed.error());
+            }
+            return {};
+        }
+
+        /// Answer one scrape on a listening socket, such as one from \p listen_unix(), with a
+        /// minimal HTTP response. The request is read but not parsed.
+        /// \param listen_fd The listening socket
+        /// \return An error if the connection could not be accepted or written to
+        VoidResult serve_once(const int listen_fd) {
+            const auto accepted = invoke_with_syscall_api([listen_fd] noexcept {
+                return ::accept(listen_fd, nullptr, nullptr);
+            }, "Accepting scrape");
+            if (!accepted) {
+                return std::unexpected(accepted.error());
+            }
+            const UniqueFd connection{*accepted};
+            (void) ::read(connection.get(), buffer_.data(), buffer_.size());
+
+            constexpr std::string_view header = "HTTP/1.0 200 OK\r\n"
+                "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                "Connection: close\r\n\r\n";
+            if (auto written = write_all(connection.get(), header); !written) {
+                return written;
+            }
+            return write_to(connection.get());
+        }
+    };
+
+    /// Create a Unix stream socket listening at \p path, replacing any file there, to serve
+    /// scrapes with \p OpenMetricsExporter::serve_once().
+    /// \param path The path of the socket
+    /// \param backlog The maximum number of pending connections
+    /// \return The listening socket, or an error naming the path
+    [[nodiscard]] inline Result<UniqueFd> listen_unix(const std::string &path, const int backlog = 16) {
+        ::sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            return make_error<UniqueFd>(std::errc::filename_too_long, std::format("Listening on '{}'", path));
+        }
+        std::memcpy(address.sun_path, path.data(), path.size());
+
+#ifdef __linux__
+        constexpr int type = SOCK_STREAM | SOCK_CLOEXEC;
+#else
+        constexpr int type = SOCK_STREAM;
+#endif
+        const auto fd = invoke_with_syscall_api([] noexcept { return ::socket(AF_UNIX, type, 0); },
+                                                "Creating Unix socket");
+        if (!fd) {
+            return std::unexpected(fd.error());
+        }
+        UniqueFd socket{*fd};
+#ifndef __linux__
+        (void) ::fcntl(socket.get(), F_SETFD, FD_CLOEXEC);
+#endif
+        (void) ::unlink(path.c_str());
+        if (const auto bound = invoke_with_syscall_api([&] noexcept {
+            return ::bind(socket.get(), reinterpret_cast<const ::sockaddr *>(&address), sizeof(address));
+        }, std::format("Binding '{}'", path)); !bound) {
+            return std::unexpected(bound.error());
+        }
+        if (const auto listening = invoke_with_syscall_api([&] noexcept {
+            return ::listen(socket.get(), backlog);
+        }, std::format("Listening on '{}'", path)); !listening) {
+            return std::unexpected(listening.error());
+        }
+        return socket;
+    }
+} // namespace error_utils
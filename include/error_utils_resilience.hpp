@@ -0,0 +1,718 @@
+// MIT License
+//
+// Copyright (c) 2025 Ian Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+/// \file
+/// \brief Resilience utilities for \p Result-returning operations.
+///
+/// \details This module decides how to react to failures by classifying errors with the
+/// same rules as \p Error::is(): retrying with backoff when an error is transient, and
+/// failing fast with a circuit breaker when a dependency keeps failing.
+
+#pragma once
+
+/// \cond
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <random>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+/// \endcond
+
+#include "error_utils.hpp"
+
+
+// ///////////////////////// Error Codes and Categories ///////////////////////
+
+namespace error_utils {
+    // clang-format off
+    // @formatter:off
+
+    /// Error codes reported by the resilience utilities themselves.
+    enum class ResilienceError {
+        circuit_open = 1,  ///< A call was rejected because the circuit breaker is open.
+    };
+
+    // clang-format on
+    // @formatter:on
+
+    namespace detail {
+        /// Error category for \p ResilienceError.
+        ///
+        /// Every code maps to \p ExtraErrorCondition::resource_error: the resource behind
+        /// the call is unavailable for now.
+        class ResilienceErrorCategory final : public std::error_category {
+        public:
+            [[nodiscard]] const char *name() const noexcept override {
+                return "ResilienceError";
+            }
+
+            [[nodiscard]] std::string message(int ev) const override {
+                switch (static_cast<ResilienceError>(ev)) {
+                    case ResilienceError::circuit_open:
+                        return "Circuit breaker is open";
+                    default:
+                        return "Unrecognized ResilienceError";
+                }
+            }
+
+            [[nodiscard]] std::error_condition default_error_condition(int) const noexcept override {
+                return make_error_condition(ExtraErrorCondition::resource_error);
+            }
+        };
+
+        /// Returns a reference to the \p ResilienceError error category.
+        inline const std::error_category &resilience_error_category() {
+            static ResilienceErrorCategory instance;
+            return instance;
+        }
+    } // namespace detail
+
+    /// Create an error code from a \p ResilienceError enum value.
+    /// \param e The \p ResilienceError enum value
+    inline std::error_code make_error_code(ResilienceError e) {
+        return {static_cast<int>(e), detail::resilience_error_category()};
+    }
+} // namespace error_utils
+
+template <>
+struct std::is_error_code_enum<error_utils::ResilienceError> : std::true_type {};
+
+
+// ///////////////////////// Retries and Circuit Breakers ///////////////////////
+
+namespace error_utils {
+    namespace detail {
+        /// An error code or condition to match errors against, with the rules of \p Error::is().
+        ///
+        /// Enumerations convertible with \p make_error_code() match exact codes, and the others
+        /// match error conditions, which compare equal to every code that maps to them.
+        class error_matcher {
+            // clang-format off
+            // @formatter:off
+
+            std::error_code code_{};            ///< The code to match, unless matching a condition
+            std::error_condition condition_{};  ///< The condition to match
+            bool is_condition_{};               ///< Whether to match the condition
+
+            // clang-format on
+            // @formatter:on
+
+        public:
+            error_matcher() noexcept = default;
+
+            template <typename T>
+                requires comparable_to_error_code<std::remove_cvref_t<T>>
+            explicit error_matcher(T &&code) noexcept {
+                using U = std::remove_cvref_t<T>;
+                if constexpr (std::is_same_v<U, std::error_code>) {
+                    code_ = code;
+                } else if constexpr (std::is_same_v<U, std::error_condition>) {
+                    condition_ = code;
+                    is_condition_ = true;
+                } else if constexpr (convertible_to_error_code<U>) {
+                    using std::make_error_code;
+                    code_ = make_error_code(code);
+                } else {
+                    using std::make_error_condition;
+                    condition_ = make_error_condition(code);
+                    is_condition_ = true;
+                }
+            }
+
+            /// Check whether \p code matches.
+            [[nodiscard]] bool matches(const std::error_code &code) const noexcept {
+                return is_condition_ ? code == condition_ : code == code_;
+            }
+        };
+
+        /// A fixed-capacity set of \p error_matcher, stored inline.
+        class error_matcher_set {
+        public:
+            static constexpr std::size_t capacity = 8;
+
+        private:
+            std::array<error_matcher, capacity> matchers_{};
+            std::size_t size_{};
+
+        public:
+            error_matcher_set() noexcept = default;
+
+            template <typename... Codes>
+                requires (sizeof...(Codes) <= capacity) && (comparable_to_error_code<std::remove_cvref_t<Codes>> && ...)
+            explicit error_matcher_set(Codes &&... codes) noexcept
+                : matchers_{error_matcher{std::forward<Codes>(codes)}...}, size_{sizeof...(Codes)} {}
+
+            [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+            /// Check whether \p code matches any of the codes or conditions in the set.
+            [[nodiscard]] bool matches(const std::error_code &code) const noexcept {
+                return std::any_of(matchers_.begin(), matchers_.begin() + static_cast<std::ptrdiff_t>(size_),
+                                   [&code](const error_matcher &matcher) { return matcher.matches(code); });
+            }
+        };
+
+        /// Returns a fast pseudo-random generator owned by the calling thread.
+        [[nodiscard]] inline std::minstd_rand &thread_random() {
+            thread_local std::minstd_rand generator{std::random_device{}()};
+            return generator;
+        }
+    } // namespace detail
+
+    // clang-format off
+    // @formatter:off
+
+    /// Randomization applied to the delays between attempts.
+    enum class Jitter {
+        none,          ///< Plain exponential backoff.
+        full,          ///< A uniformly random delay between zero and the exponential backoff.
+        decorrelated,  ///< A random delay between the initial delay and three times the previous one.
+    };
+
+    /// The reason \p retry() stopped.
+    enum class RetryStop {
+        succeeded,           ///< An attempt succeeded.
+        not_retryable,       ///< The error was not classified as retryable.
+        attempts_exhausted,  ///< The maximum number of attempts was reached.
+        deadline_exceeded,   ///< The next attempt would have started after the deadline.
+    };
+
+    // clang-format on
+    // @formatter:on
+
+    /// Statistics of a call to \p retry().
+    struct RetryStats {
+        std::size_t attempts{};              ///< Number of attempts made
+        std::chrono::nanoseconds waited{};   ///< Total time spent waiting between attempts
+        RetryStop stop{RetryStop::succeeded}; ///< Why the retries stopped
+    };
+
+    /// The delays of the last retry of a call to \p retry().
+    struct RetryBackoff {
+        std::chrono::nanoseconds ceiling{};   ///< The delay before jitter, which grows exponentially
+        std::chrono::nanoseconds delay{};     ///< The delay actually waited
+    };
+
+    /// How \p retry() repeats a failing operation.
+    ///
+    /// The setters return the policy, so that it can be built in a single expression:
+    /// \code
+    /// const auto policy = RetryPolicy{}
+    ///     .max_attempts(5)
+    ///     .initial_delay(10ms)
+    ///     .timeout(2s)
+    ///     .retry_on(ExtraErrorCondition::resource_error, std::errc::resource_unavailable_try_again)
+    ///     .never_on(ExtraErrorCondition::logic_error);
+    /// \endcode
+    ///
+    /// An error is retried if it matches none of the \p never_on() codes and, when \p retry_on()
+    /// codes are set, one of them. Codes and conditions match with the rules of \p Error::is().
+    class RetryPolicy {
+        // clang-format off
+        // @formatter:off
+
+        std::size_t max_attempts_{3};                                     ///< Attempts, including the first
+        std::chrono::nanoseconds initial_delay_{std::chrono::milliseconds{10}}; ///< Delay before the first retry
+        std::chrono::nanoseconds max_delay_{std::chrono::seconds{1}};     ///< Upper bound of every delay
+        double multiplier_{2.0};                                          ///< Growth factor of the delay
+        Jitter jitter_{Jitter::decorrelated};                             ///< Randomization of the delays
+        std::optional<std::chrono::nanoseconds> timeout_{};               ///< Time budget of all attempts
+        std::optional<std::chrono::steady_clock::time_point> deadline_{}; ///< Absolute deadline
+        detail::error_matcher_set retry_on_{};                            ///< Errors to retry
+        detail::error_matcher_set never_on_{};                            ///< Errors never to retry
+
+        // clang-format on
+        // @formatter:on
+
+    public:
+        /// Set the maximum number of attempts, including the first one.
+        RetryPolicy &max_attempts(const std::size_t attempts) noexcept {
+            max_attempts_ = std::max<std::size_t>(attempts, 1);
+            return *this;
+        }
+
+        /// Set the delay before the first retry. It is also the lower bound of decorrelated jitter.
+        template <typename Rep, typename Period>
+        RetryPolicy &initial_delay(const std::chrono::duration<Rep, Period> delay) noexcept {
+            initial_delay_ = std::chrono::duration_cast<std::chrono::nanoseconds>(delay);
+            return *this;
+        }
+
+        /// Set the upper bound of the delay between attempts.
+        template <typename Rep, typename Period>
+        RetryPolicy &max_delay(const std::chrono::duration<Rep, Period> delay) noexcept {
+            max_delay_ = std::chrono::duration_cast<std::chrono::nanoseconds>(delay);
+            return *this;
+        }
+
+        /// Set the growth factor of the delay for \p Jitter::none and \p Jitter::full.
+        RetryPolicy &multiplier(const double factor) noexcept {
+            multiplier_ = std::max(factor, 1.0);
+            return *this;
+        }
+
+        /// Set the randomization of the delays.
+        RetryPolicy &jitter(const Jitter jitter) noexcept {
+            jitter_ = jitter;
+            return *this;
+        }
+
+        /// Limit the time of all the attempts, measured from the start of \p retry().
+        template <typename Rep, typename Period>
+        RetryPolicy &timeout(const std::chrono::duration<Rep, Period> budget) noexcept {
+            timeout_ = std::chrono::duration_cast<std::chrono::nanoseconds>(budget);
+            return *this;
+        }
+
+        /// Set an absolute deadline after which no attempt starts.
+        RetryPolicy &deadline(const std::chrono::steady_clock::time_point deadline) noexcept {
+            deadline_ = deadline;
+            return *this;
+        }
+
+        /// Retry only errors matching one of \p codes (at most eight).
+        template <typename... Codes>
+            requires (sizeof...(Codes) <= detail::error_matcher_set::capacity) &&
+                     (detail::comparable_to_error_code<std::remove_cvref_t<Codes>> && ...)
+        RetryPolicy &retry_on(Codes &&... codes) noexcept {
+            retry_on_ = detail::error_matcher_set{std::forward<Codes>(codes)...};
+            return *this;
+        }
+
+        /// Never retry errors matching one of \p codes (at most eight), even if \p retry_on() matches.
+        template <typename... Codes>
+            requires (sizeof...(Codes) <= detail::error_matcher_set::capacity) &&
+                     (detail::comparable_to_error_code<std::remove_cvref_t<Codes>> && ...)
+        RetryPolicy &never_on(Codes &&... codes) noexcept {
+            never_on_ = detail::error_matcher_set{std::forward<Codes>(codes)...};
+            return *this;
+        }
+
+        /// Returns the maximum number of attempts.
+        [[nodiscard]] std::size_t max_attempts() const noexcept { return max_attempts_; }
+
+        /// Check whether an error is worth retrying.
+        /// \param code The error code of the failed attempt
+        [[nodiscard]] bool should_retry(const std::error_code &code) const noexcept {
+            if (never_on_.matches(code)) {
+                return false;
+            }
+            return retry_on_.empty() || retry_on_.matches(code);
+        }
+
+        /// Returns the deadline of a call to \p retry() that started at \p start, if any.
+        [[nodiscard]] std::optional<std::chrono::steady_clock::time_point>
+        deadline_from(const std::chrono::steady_clock::time_point start) const noexcept {
+            if (timeout_ && deadline_) {
+                return std::min(start + *timeout_, *deadline_);
+            }
+            if (timeout_) {
+                return start + *timeout_;
+            }
+            return deadline_;
+        }
+
+        /// Compute the delay before the next attempt.
+        /// \param previous For \p Jitter::decorrelated, the previous delay; otherwise the previous
+        /// delay before jitter. Zero before the first retry.
+        /// \param generator The source of randomness for the jitter
+        [[nodiscard]] std::chrono::nanoseconds next_delay(const std::chrono::nanoseconds previous,
+                                                          std::minstd_rand &generator) const {
+            RetryBackoff backoff{previous, previous};
+            return next_delay(backoff, generator);
+        }
+
+        /// Compute the delay before the next attempt, and advance \p backoff.
+        ///
+        /// \p Jitter::none and \p Jitter::full grow the delay before jitter, so that the upper bound
+        /// of full jitter doubles (with the default multiplier) whatever the random draws were.
+        /// \param backoff The delays of the previous retry, value-initialized before the first one
+        /// \param generator The source of randomness for the jitter
+        [[nodiscard]] std::chrono::nanoseconds next_delay(RetryBackoff &backoff, std::minstd_rand &generator) const {
+            using rep = std::chrono::nanoseconds::rep;
+            const rep cap = max_delay_.count();
+            const rep base = std::min(initial_delay_.count(), cap);
+
+            if (jitter_ == Jitter::decorrelated) {
+                // delay = min(cap, random_between(base, previous * 3))
+                const rep last = std::max(base, backoff.delay.count());
+                const rep upper = last >= cap / 3 ? cap : last * 3;
+                backoff.delay = std::chrono::nanoseconds{
+                    std::uniform_int_distribution<rep>{base, std::max(base, upper)}(generator)
+                };
+                backoff.ceiling = backoff.delay;
+                return backoff.delay;
+            }
+
+            // Exponential backoff: base, base * multiplier, base * multiplier^2, ... up to cap
+            const rep previous = backoff.ceiling.count();
+            const rep grown = previous <= 0
+                                  ? base
+                                  : static_cast<rep>(std::min(static_cast<double>(cap),
+                                                              static_cast<double>(previous) * multiplier_));
+            backoff.ceiling = std::chrono::nanoseconds{grown};
+            backoff.delay = jitter_ == Jitter::full
+                                ? std::chrono::nanoseconds{std::uniform_int_distribution<rep>{0, grown}(generator)}
+                                : backoff.ceiling;
+            return backoff.delay;
+        }
+    };
+
+    /// Call a function until it succeeds, with backoff between the attempts.
+    ///
+    /// Stops at the first success, at an error the policy does not retry, after the maximum
+    /// number of attempts, or when the next attempt would start after the deadline. The last
+    /// result is returned in every case. Nothing is allocated between the attempts.
+    ///
+    /// \param policy The retry policy
+    /// \param func The function to call. It must return a \p Result.
+    /// \param stats Where to store the number of attempts, the time spent waiting and the
+    /// reason for stopping. Optional.
+    /// \return The result of the last attempt
+    template <typename Func>
+        requires std::invocable<Func &> && detail::is_expected_v<std::remove_cvref_t<std::invoke_result_t<Func &>>>
+    [[nodiscard]] auto retry(const RetryPolicy &policy, Func &&func, RetryStats *stats = nullptr)
+        -> std::remove_cvref_t<std::invoke_result_t<Func &>> {
+        using clock = std::chrono::steady_clock;
+
+        const auto deadline = policy.deadline_from(clock::now());
+        RetryStats local{};
+        RetryStats &out = stats != nullptr ? *stats : local;
+        out = RetryStats{};
+
+        RetryBackoff backoff{};
+        while (true) {
+            auto result = std::invoke(func);
+            ++out.attempts;
+            if (result) {
+                out.stop = RetryStop::succeeded;
+                return result;
+            }
+            if (!policy.should_retry(result.error().error_code())) {
+                out.stop = RetryStop::not_retryable;
+                return result;
+            }
+            if (out.attempts >= policy.max_attempts()) {
+                out.stop = RetryStop::attempts_exhausted;
+                return result;
+            }
+
+            const auto delay = policy.next_delay(backoff, detail::thread_random());
+            if (deadline && clock::now() + delay >= *deadline) {
+                out.stop = RetryStop::deadline_exceeded;
+                return result;
+            }
+            std::this_thread::sleep_for(delay);
+            out.waited += delay;
+        }
+    }
+
+    // clang-format off
+    // @formatter:off
+
+    /// The state of a \p CircuitBreaker.
+    enum class CircuitState {
+        closed,     ///< Calls go through, and their outcomes are counted.
+        open,       ///< Calls are rejected without being made.
+        half_open,  ///< A single probe call goes through to test the dependency.
+    };
+
+    // clang-format on
+    // @formatter:on
+
+    /// When a \p CircuitBreaker opens, and for how long.
+    ///
+    /// \code
+    /// CircuitBreaker breaker{CircuitPolicy{}
+    ///     .window(10s, 10)
+    ///     .failure_ratio(0.5)
+    ///     .minimum_calls(20)
+    ///     .open_for(5s)
+    ///     .trip_on(ExtraErrorCondition::resource_error, std::errc::timed_out)};
+    /// \endcode
+    ///
+    /// Only errors matching one of the \p trip_on() codes count as failures, with the rules
+    /// of \p Error::is(); every error does if none is set. Other errors count as successful
+    /// calls, since the dependency did respond.
+    class CircuitPolicy {
+        // clang-format off
+        // @formatter:off
+
+        std::chrono::nanoseconds window_{std::chrono::seconds{10}};    ///< Length of the sliding window
+        std::size_t buckets_{10};                                      ///< Number of buckets in the window
+        double failure_ratio_{0.5};                                    ///< Failure ratio that opens the circuit
+        std::size_t minimum_calls_{20};                                ///< Calls needed before the ratio counts
+        std::chrono::nanoseconds open_for_{std::chrono::seconds{5}};   ///< Time spent open before a probe
+        detail::error_matcher_set trip_on_{};                          ///< Errors counted as failures
+
+        // clang-format on
+        // @formatter:on
+
+        friend class CircuitBreaker;
+
+    public:
+        /// Set the length of the sliding window, and the number of buckets it is split into.
+        template <typename Rep, typename Period>
+        CircuitPolicy &window(const std::chrono::duration<Rep, Period> length, const std::size_t buckets) noexcept {
+            buckets_ = std::max<std::size_t>(buckets, 1);
+            window_ = std::max(std::chrono::duration_cast<std::chrono::nanoseconds>(length),
+                               std::chrono::nanoseconds{static_cast<std::int64_t>(buckets_)});
+            return *this;
+        }
+
+        /// Set the ratio of failed calls in the window that opens the circuit.
+        CircuitPolicy &failure_ratio(const double ratio) noexcept {
+            failure_ratio_ = std::clamp(ratio, 0.0, 1.0);
+            return *this;
+        }
+
+        /// Set the number of calls the window must hold before the ratio is considered.
+        CircuitPolicy &minimum_calls(const std::size_t calls) noexcept {
+            minimum_calls_ = std::max<std::size_t>(calls, 1);
+            return *this;
+        }
+
+        /// Set how long the circuit stays open before a probe call is let through.
+        template <typename Rep, typename Period>
+        CircuitPolicy &open_for(const std::chrono::duration<Rep, Period> duration) noexcept {
+            open_for_ = std::chrono::duration_cast<std::chrono::nanoseconds>(duration);
+            return *this;
+        }
+
+        /// Count only errors matching one of \p codes (at most eight) as failures.
+        template <typename... Codes>
+            requires (sizeof...(Codes) <= detail::error_matcher_set::capacity) &&
+                     (detail::comparable_to_error_code<std::remove_cvref_t<Codes>> && ...)
+        CircuitPolicy &trip_on(Codes &&... codes) noexcept {
+            trip_on_ = detail::error_matcher_set{std::forward<Codes>(codes)...};
+            return *this;
+        }
+
+        /// Check whether an error counts as a failure.
+        [[nodiscard]] bool trips(const std::error_code &code) const noexcept {
+            return trip_on_.empty() || trip_on_.matches(code);
+        }
+    };
+
+    /// Counts of the calls in the sliding window of a \p CircuitBreaker.
+    struct CircuitCounts {
+        std::uint64_t successes{};  ///< Calls that succeeded, or failed without tripping
+        std::uint64_t failures{};   ///< Calls that failed with a tripping error
+    };
+
+    /// A lock-free circuit breaker for calls returning \p Result.
+    ///
+    /// The outcomes of the calls are counted in a sliding window of time buckets. When the
+    /// ratio of failures crosses the threshold, the circuit opens: calls fail fast with
+    /// \p ResilienceError::circuit_open instead of adding load and latency to a dependency that
+    /// is already failing. After a while, a single probe call is let through; its success
+    /// closes the circuit, and its failure opens it again.
+    ///
+    /// Every operation is a handful of atomic loads and read-modify-writes, so the breaker can
+    /// be shared by many threads, and its state read without contention.
+    class CircuitBreaker {
+        /// A counter tagged with the index of the bucket period it belongs to.
+        /// The upper 32 bits hold the period, and the lower 32 bits the count.
+        using tagged_count = std::atomic<std::uint64_t>;
+
+        struct alignas(64) Bucket {
+            tagged_count successes{};
+            tagged_count failures{};
+        };
+
+        /// The state is a single word, so that opening the circuit and setting the end of its
+        /// delay is one atomic step: \p closed_word, \p half_open_word, or for an open circuit
+        /// the time when it lets a probe through, which is never negative.
+        static constexpr std::int64_t closed_word = -1;
+        static constexpr std::int64_t half_open_word = -2;
+
+        // clang-format off
+        // @formatter:off
+
+        CircuitPolicy policy_;                          ///< The configuration
+        std::int64_t bucket_width_;                     ///< Length of a bucket, in nanoseconds
+        std::unique_ptr<Bucket[]> buckets_;             ///< The sliding window
+        std::atomic<std::int64_t> state_{closed_word};  ///< The state word
+
+        // clang-format on
+        // @formatter:on
+
+        [[nodiscard]] static std::int64_t now() noexcept {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        [[nodiscard]] std::uint32_t period(const std::int64_t time) const noexcept {
+            return static_cast<std::uint32_t>(time / bucket_width_);
+        }
+
+        static void add(tagged_count &counter, const std::uint32_t period) noexcept {
+            const std::uint64_t tag = static_cast<std::uint64_t>(period) << 32;
+            std::uint64_t current = counter.load(std::memory_order_relaxed);
+            while (true) {
+                if ((current & ~0xffffffffULL) == tag) {
+                    counter.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                // The bucket holds an older period: start it over
+                if (counter.compare_exchange_weak(current, tag | 1, std::memory_order_relaxed)) {
+                    return;
+                }
+            }
+        }
+
+        [[nodiscard]] std::uint64_t sum(const tagged_count Bucket::*counter, const std::uint32_t current) const noexcept {
+            std::uint64_t total = 0;
+            for (std::size_t i = 0; i < policy_.buckets_; ++i) {
+                const std::uint64_t value = (buckets_[i].*counter).load(std::memory_order_relaxed);
+                const auto tag = static_cast<std::uint32_t>(value >> 32);
+                if (current - tag < policy_.buckets_) {
+                    total += value & 0xffffffffULL;
+                }
+            }
+            return total;
+        }
+
+        /// \return The state word of a circuit opening at \p time
+        [[nodiscard]] std::int64_t open_word(const std::int64_t time) const noexcept {
+            return std::max<std::int64_t>(time + policy_.open_for_.count(), 0);
+        }
+
+        /// Decide whether a call may go through.
+        /// \return Whether the call is allowed, and whether it is the probe of a half-open circuit
+        [[nodiscard]] std::pair<bool, bool> acquire(const std::int64_t time) noexcept {
+            std::int64_t word = state_.load(std::memory_order_acquire);
+            if (word == closed_word) {
+                return {true, false};
+            }
+            if (word >= 0 && time >= word &&
+                state_.compare_exchange_strong(word, half_open_word, std::memory_order_acq_rel)) {
+                return {true, true};
+            }
+            return {false, false};
+        }
+
+        void record(const bool failed, const bool probe, const std::int64_t time) noexcept {
+            const std::uint32_t current = period(time);
+            Bucket &bucket = buckets_[current % policy_.buckets_];
+
+            if (probe) {
+                if (failed) {
+                    state_.store(open_word(time), std::memory_order_release);
+                } else {
+                    // Forget the failures that opened the circuit
+                    for (std::size_t i = 0; i < policy_.buckets_; ++i) {
+                        buckets_[i].successes.store(0, std::memory_order_relaxed);
+                        buckets_[i].failures.store(0, std::memory_order_relaxed);
+                    }
+                    add(bucket.successes, current);
+                    state_.store(closed_word, std::memory_order_release);
+                }
+                return;
+            }
+
+            if (!failed) {
+                add(bucket.successes, current);
+                return;
+            }
+            add(bucket.failures, current);
+
+            const std::uint64_t failures = sum(&Bucket::failures, current);
+            const std::uint64_t calls = failures + sum(&Bucket::successes, current);
+            if (calls >= policy_.minimum_calls_ &&
+                static_cast<double>(failures) >= policy_.failure_ratio_ * static_cast<double>(calls)) {
+                // Only the call opening the circuit sets the delay: failures of the calls still in
+                // flight once it is open do not push the probe back
+                std::int64_t expected = closed_word;
+                state_.compare_exchange_strong(expected, open_word(time), std::memory_order_acq_rel);
+            }
+        }
+
+    public:
+        /// Create a closed circuit breaker.
+        /// \param policy When the circuit opens, and for how long
+        explicit CircuitBreaker(const CircuitPolicy &policy = {})
+            : policy_{policy},
+              bucket_width_{std::max<std::int64_t>(policy.window_.count() / static_cast<std::int64_t>(policy.buckets_), 1)},
+              buckets_{std::make_unique<Bucket[]>(policy.buckets_)} {}
+
+        CircuitBreaker(const CircuitBreaker &) = delete;
+
+        CircuitBreaker &operator=(const CircuitBreaker &) = delete;
+
+        /// Make a call through the circuit breaker.
+        ///
+        /// \param func The function to call. It must return a \p Result. An exception it throws
+        /// is recorded as a failure, then propagated.
+        /// \return The result of \p func, or a \p ResilienceError::circuit_open error
+        /// if the circuit is open
+        template <typename Func>
+            requires std::invocable<Func &> &&
+                     std::same_as<typename std::remove_cvref_t<std::invoke_result_t<Func &>>::error_type, Error>
+        [[nodiscard]] auto call(Func &&func) -> std::remove_cvref_t<std::invoke_result_t<Func &>> {
+            const auto [allowed, probe] = acquire(now());
+            if (!allowed) {
+                return std::unexpected(Error{ResilienceError::circuit_open, "Call rejected"});
+            }
+
+            // An exception counts as a tripping failure, so that a throwing probe reopens the circuit
+            // instead of leaving it half-open for good
+            auto result = [&] {
+                try {
+                    return std::invoke(func);
+                } catch (...) {
+                    record(true, probe, now());
+                    throw;
+                }
+            }();
+            record(!result && policy_.trips(result.error().error_code()), probe, now());
+            return result;
+        }
+
+        /// Returns the current state. An open circuit whose delay has elapsed reports
+        /// \p CircuitState::open until the next call probes it.
+        [[nodiscard]] CircuitState state() const noexcept {
+            const std::int64_t word = state_.load(std::memory_order_acquire);
+            if (word == closed_word) {
+                return CircuitState::closed;
+            }
+            return word == half_open_word ? CircuitState::half_open : CircuitState::open;
+        }
+
+        /// Returns the counts of the calls in the current window.
+        [[nodiscard]] CircuitCounts counts() const noexcept {
+            const std::uint32_t current = period(now());
+            return {sum(&Bucket::successes, current), sum(&Bucket::failures, current)};
+        }
+
+        /// Returns the policy of the circuit breaker.
+        [[nodiscard]] const CircuitPolicy &policy() const noexcept { return policy_; }
+    };
+} // namespace error_utils
@@ -2,6 +2,13 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <source_location>
+#include <sstream>
+#include <unordered_set>
+
 using namespace error_utils;
 
 // ///////////////// Tests on utils::Error class /////////////////////////
@@ -535,6 +542,96 @@ TEST(InvokeWithSyscallApiTest, NegativeOneNoError) {
     EXPECT_EQ(result.value(), 0);
 }
 
+TEST(WithErrnoTest, PreserveRestoresCallerErrno) {
+    errno = ERANGE;
+    const auto result = with_errno<ErrnoMode::preserve>([] { return 42; });
+    EXPECT_TRUE(result);
+    EXPECT_EQ(errno, ERANGE);
+}
+
+TEST(WithErrnoTest, PreserveReportsError) {
+    errno = ERANGE;
+    auto result = with_errno<ErrnoMode::preserve>([]() -> int {
+        errno = EINVAL;
+        return -1;
+    }, "System call failed");
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error().value(), EINVAL);
+    EXPECT_EQ(result.error().message(), "System call failed: Invalid argument");
+    EXPECT_EQ(errno, ERANGE);
+}
+
+TEST(WithErrnoTest, PreserveVoidReturnType) {
+    errno = ERANGE;
+    auto result = with_errno<ErrnoMode::preserve>([] { errno = EACCES; });
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error().value(), EACCES);
+    EXPECT_EQ(errno, ERANGE);
+}
+
+TEST(WithErrnoIfTest, SuccessLeavesErrnoUntouched) {
+    errno = ERANGE;
+    const auto result = with_errno_if([] { return 42; }, [](const int r) { return r == -1; });
+    EXPECT_TRUE(result);
+    EXPECT_EQ(result.value(), 42);
+    EXPECT_EQ(errno, ERANGE);
+}
+
+TEST(WithErrnoIfTest, StaleErrnoIgnoredOnSuccess) {
+    const auto result = with_errno_if([] {
+        errno = EINVAL; // Successful calls may leave errno modified
+        return 0;
+    }, [](const int r) { return r == -1; });
+    EXPECT_TRUE(result);
+}
+
+TEST(WithErrnoIfTest, FailureReadsErrno) {
+    auto result = with_errno_if([] {
+        errno = ENOENT;
+        return static_cast<void *>(nullptr);
+    }, [](const void *p) { return p == nullptr; }, "Lookup failed");
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error().value(), ENOENT);
+    EXPECT_EQ(result.error().message(), "Lookup failed: No such file or directory");
+    EXPECT_EQ(errno, ENOENT);
+}
+
+TEST(WithErrnoIfTest, FailureWithoutErrno) {
+    errno = 0;
+    auto result = with_errno_if([] { return -1; }, [](const int r) { return r == -1; });
+    EXPECT_FALSE(result);
+    EXPECT_TRUE(result.error().is(ExtraError::unknown_error));
+}
+
+TEST(InvokeWithSyscallApiTest, PreserveRestoresCallerErrno) {
+    errno = ERANGE;
+    auto result = invoke_with_syscall_api<ErrnoMode::preserve>([]() noexcept -> int {
+        errno = EINVAL;
+        return -1;
+    }, "Syscall failed");
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error().value(), EINVAL);
+    EXPECT_EQ(errno, ERANGE);
+}
+
+TEST(InvokeWithSyscallApiTest, OnFailureDoesNotTouchErrnoOnSuccess) {
+    errno = ERANGE;
+    const auto result = invoke_with_syscall_api<ErrnoMode::on_failure>([]() noexcept { return 7; });
+    EXPECT_TRUE(result);
+    EXPECT_EQ(result.value(), 7);
+    EXPECT_EQ(errno, ERANGE);
+}
+
+TEST(InvokeWithSyscallApiTest, OnFailureReadsErrno) {
+    auto result = invoke_with_syscall_api<ErrnoMode::on_failure>([]() noexcept -> int {
+        errno = EBADF;
+        return -1;
+    }, "Syscall failed");
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error().value(), EBADF);
+    EXPECT_EQ(errno, EBADF); // Not reset
+}
+
 TEST(FirstOfTest, FirstSuccess) {
     auto result1 = make_error<int>(std::errc::invalid_argument, "First error");
     auto result2 = Result<int>(42);
@@ -587,6 +684,614 @@ TEST(FirstOfTest, SingleSuccess) {
     EXPECT_EQ(result.value(), 42);
 }
 
+TEST(FirstOfLazyTest, StopsAtFirstSuccess) {
+    int calls = 0;
+    const auto result = first_of(
+        [&] { ++calls; return make_error<int>(std::errc::invalid_argument, "First error"); },
+        [&] { ++calls; return Result<int>(42); },
+        [&] { ++calls; return Result<int>(7); });
+    EXPECT_TRUE(result);
+    EXPECT_EQ(result.value(), 42);
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(FirstOfLazyTest, AllErrors) {
+    auto combined = first_of(
+        [] { return make_error<int>(std::errc::invalid_argument, "First error"); },
+        [] { return make_error<int>(std::errc::permission_denied, "Second error"); },
+        [] { return make_error<int>(std::errc::operation_canceled, "Third error"); });
+    EXPECT_FALSE(combined);
+    EXPECT_EQ(combined.error().message(),
+              "First error: Invalid argument; Second error: Permission denied; Third error: "
+              "Operation canceled: Unknown error");
+    EXPECT_TRUE(combined.error().is(ExtraError::unknown_error));
+}
+
+TEST(FirstOfLazyTest, SingleAlternative) {
+    const auto result = first_of([] { return Result<std::string>("only"); });
+    EXPECT_TRUE(result);
+    EXPECT_EQ(result.value(), "only");
+}
+
+TEST(FirstOfLazyTest, MovesWinnerOut) {
+    const auto result = first_of(
+        [] { return make_error<std::unique_ptr<int>>(std::errc::invalid_argument); },
+        [] { return Result<std::unique_ptr<int>>(std::make_unique<int>(5)); });
+    ASSERT_TRUE(result);
+    EXPECT_EQ(**result, 5);
+}
+
+TEST(FirstOfLazyTest, RangeOfCallables) {
+    int calls = 0;
+    const std::vector<std::function<Result<int>()>> alternatives{
+        [&] { ++calls; return make_error<int>(std::errc::invalid_argument); },
+        [&] { ++calls; return Result<int>(1); },
+        [&] { ++calls; return Result<int>(2); },
+    };
+    const auto result = first_of(alternatives);
+    EXPECT_TRUE(result);
+    EXPECT_EQ(result.value(), 1);
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(FirstOfLazyTest, RangeAllErrors) {
+    const std::vector<std::function<Result<int>()>> alternatives{
+        [] { return make_error<int>(std::errc::invalid_argument, "First error"); },
+        [] { return make_error<int>(std::errc::permission_denied, "Second error"); },
+    };
+    const auto result = first_of(alternatives);
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error().message(),
+              "First error: Invalid argument; Second error: Permission denied: Unknown error");
+}
+
+TEST(FirstOfLazyTest, EmptyRange) {
+    const std::vector<std::function<Result<int>()>> alternatives{};
+    const auto result = first_of(alternatives);
+    EXPECT_FALSE(result);
+    EXPECT_EQ(result.error().message(), "No alternatives provided: Invalid argument");
+}
+
+TEST(AggregateErrorTest, DefaultConstruction) {
+    const AggregateError error;
+    EXPECT_TRUE(error.empty());
+    EXPECT_EQ(error.size(), 0);
+    EXPECT_TRUE(error.error_code() == ExtraError::unknown_error);
+}
+
+TEST(AggregateErrorTest, KeepsIndividualErrors) {
+    AggregateError error;
+    error.push_back(Error{std::errc::invalid_argument, "First"});
+    error.push_back(Error{ExtraError::bad_alloc, "Second"});
+    ASSERT_EQ(error.size(), 2);
+    EXPECT_EQ(error.errors()[0].context(), "First");
+    EXPECT_EQ(error.errors()[1].value(), static_cast<int>(ExtraError::bad_alloc));
+    EXPECT_EQ(error.message(), "First: Invalid argument; Second: Bad allocation exception: Unknown error");
+}
+
+TEST(AggregateErrorTest, IsOverMembers) {
+    AggregateError error;
+    error.push_back(Error{std::errc::invalid_argument});
+    error.push_back(Error{ExtraError::bad_alloc});
+    EXPECT_TRUE(error.is(std::errc::invalid_argument));
+    EXPECT_TRUE(error.is(ExtraError::bad_alloc));
+    EXPECT_TRUE(error.is(ExtraErrorCondition::resource_error));
+    EXPECT_FALSE(error.is(std::errc::permission_denied));
+    EXPECT_TRUE(error.is_any_of(std::errc::permission_denied, ExtraError::bad_alloc));
+    EXPECT_FALSE(error.is_any_of(std::errc::permission_denied, ExtraErrorCondition::logic_error));
+}
+
+TEST(AggregateErrorTest, CodePolicies) {
+    auto fill = [](AggregateError error) {
+        error.push_back(Error{ExtraError::invalid_argument});
+        error.push_back(Error{ExtraError::bad_alloc});
+        error.push_back(Error{ExtraError::runtime_error});
+        return error;
+    };
+    EXPECT_TRUE(fill(AggregateError{AggregateCode::unknown_error}).error_code() == ExtraError::unknown_error);
+    EXPECT_TRUE(fill(AggregateError{AggregateCode::first}).error_code() == ExtraError::invalid_argument);
+    EXPECT_TRUE(fill(AggregateError{AggregateCode::last}).error_code() == ExtraError::runtime_error);
+    EXPECT_TRUE(fill(AggregateError{AggregateCode::most_severe}).error_code() == ExtraError::bad_alloc);
+
+    auto overridden = fill(AggregateError{AggregateCode::last});
+    overridden.set_error_code(std::make_error_code(std::errc::timed_out));
+    EXPECT_TRUE(overridden.error_code() == std::errc::timed_out);
+}
+
+TEST(AggregateErrorTest, SpillsToHeap) {
+    AggregateError error{AggregateCode::last};
+    for (int i = 1; i <= 10; ++i) {
+        error.push_back(Error{std::error_code(i, std::generic_category()), std::to_string(i)});
+    }
+    ASSERT_EQ(error.size(), 10);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(error.errors()[i].context(), std::to_string(i + 1));
+    }
+
+    const AggregateError copy = error;
+    EXPECT_EQ(copy.size(), 10);
+    AggregateError moved = std::move(error);
+    EXPECT_EQ(moved.size(), 10);
+    EXPECT_EQ(moved.value(), 10);
+    EXPECT_EQ(copy.message(), moved.message());
+}
+
+TEST(AggregateErrorTest, ToError) {
+    AggregateError aggregate{AggregateCode::first};
+    aggregate.push_back(Error{std::errc::invalid_argument, "First"});
+    aggregate.push_back(Error{std::errc::permission_denied, "Second"});
+    const Error error = aggregate;
+    EXPECT_TRUE(error.is(std::errc::invalid_argument));
+    EXPECT_EQ(error.context(), "First: Invalid argument; Second: Permission denied");
+}
+
+TEST(FirstOfAggregateTest, FirstSuccess) {
+    int calls = 0;
+    const auto result = first_of_aggregate(
+        [&] { ++calls; return make_error<int>(std::errc::invalid_argument); },
+        [&] { ++calls; return Result<int>(42); },
+        [&] { ++calls; return Result<int>(7); });
+    ASSERT_TRUE(result);
+    EXPECT_EQ(*result, 42);
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(FirstOfAggregateTest, AllErrors) {
+    const auto result = first_of_aggregate(
+        [] { return make_error<int>(std::errc::invalid_argument, "First error"); },
+        [] { return make_error<int>(std::errc::permission_denied, "Second error"); });
+    ASSERT_FALSE(result);
+    EXPECT_EQ(result.error().size(), 2);
+    EXPECT_TRUE(result.error().error_code() == std::errc::permission_denied); // AggregateCode::last
+    EXPECT_TRUE(result.error().is(std::errc::invalid_argument));
+    EXPECT_EQ(result.error().message(),
+              "First error: Invalid argument; Second error: Permission denied: Permission denied");
+}
+
+TEST(FirstOfAggregateTest, ChosenCode) {
+    const auto result = first_of_aggregate<AggregateCode::most_severe>(
+        [] { return make_error<void>(ExtraError::invalid_argument); },
+        [] { return make_error<void>(ExtraError::bad_alloc); },
+        [] { return make_error<void>(ExtraError::runtime_error); });
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().error_code() == ExtraError::bad_alloc);
+}
+
+TEST(FirstOfAggregateTest, ConvertsToResult) {
+    const Result<int> result = first_of_aggregate<AggregateCode::first>(
+        [] { return make_error<int>(std::errc::invalid_argument, "First error"); });
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::invalid_argument));
+    EXPECT_EQ(result.error().context(), "First error: Invalid argument");
+}
+
+TEST(FirstOfAggregateTest, Range) {
+    const std::vector<std::function<Result<int>()>> alternatives{
+        [] { return make_error<int>(std::errc::invalid_argument); },
+        [] { return make_error<int>(std::errc::permission_denied); },
+    };
+    const auto result = first_of_aggregate(alternatives);
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is_any_of(std::errc::invalid_argument));
+    EXPECT_EQ(result.error().size(), 2);
+
+    const auto empty = first_of_aggregate(std::vector<std::function<Result<int>()>>{});
+    ASSERT_FALSE(empty);
+    EXPECT_TRUE(empty.error().empty());
+    EXPECT_TRUE(empty.error().error_code() == std::errc::invalid_argument);
+}
+
+// ///////////////////////// Tests on collect //////////////////////////////
+
+namespace {
+    Result<std::string> parse_word(const std::string_view text) {
+        if (text.empty()) {
+            return make_error<std::string>(std::errc::invalid_argument, "Empty word");
+        }
+        return std::string{text};
+    }
+} // namespace
+
+TEST(CollectTest, AllSuccess) {
+    const std::vector<std::string_view> words{"a", "b", "c"};
+    const auto result = collect(words | std::views::transform(parse_word));
+    ASSERT_TRUE(result);
+    EXPECT_THAT(*result, ::testing::ElementsAre("a", "b", "c"));
+    EXPECT_GE(result->capacity(), 3);
+}
+
+TEST(CollectTest, StopsAtFirstError) {
+    int calls = 0;
+    const std::vector<std::string_view> words{"a", "", "c", ""};
+    const auto result = words | std::views::transform([&calls](const std::string_view word) {
+        ++calls;
+        return parse_word(word);
+    }) | collect;
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::invalid_argument));
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(CollectTest, EmptyRange) {
+    const auto result = collect(std::vector<IntResult>{});
+    ASSERT_TRUE(result);
+    EXPECT_TRUE(result->empty());
+}
+
+TEST(CollectTest, LvalueRangeIsCopied) {
+    const std::vector<Result<std::string>> results{std::string{"x"}, std::string{"y"}};
+    const auto result = results | collect();
+    ASSERT_TRUE(result);
+    EXPECT_THAT(*result, ::testing::ElementsAre("x", "y"));
+    EXPECT_EQ(*results[0], "x");
+}
+
+TEST(CollectTest, MovesFromRvalueContainer) {
+    std::vector<Result<std::unique_ptr<int>>> results;
+    results.emplace_back(std::make_unique<int>(1));
+    results.emplace_back(std::make_unique<int>(2));
+    const auto result = collect(std::move(results));
+    ASSERT_TRUE(result);
+    ASSERT_EQ(result->size(), 2);
+    EXPECT_EQ(*(*result)[1], 2);
+}
+
+TEST(CollectTest, InputRange) {
+    std::istringstream stream{"1 2 3"};
+    const auto result = std::views::istream<int>(stream) | std::views::transform([](const int n) -> IntResult {
+        return n * 2;
+    }) | collect;
+    ASSERT_TRUE(result);
+    EXPECT_THAT(*result, ::testing::ElementsAre(2, 4, 6));
+}
+
+TEST(CollectAllTest, GathersEveryError) {
+    const std::vector<IntResult> results{
+        1,
+        make_error<int>(std::errc::invalid_argument, "First"),
+        3,
+        make_error<int>(std::errc::permission_denied, "Second"),
+    };
+    const auto result = collect_all(results);
+    ASSERT_FALSE(result);
+    ASSERT_EQ(result.error().size(), 2);
+    EXPECT_TRUE(result.error().error_code() == std::errc::invalid_argument);
+    EXPECT_TRUE(result.error().is(std::errc::permission_denied));
+}
+
+TEST(CollectAllTest, AllSuccess) {
+    const auto result = std::vector<IntResult>{1, 2} | collect_all;
+    ASSERT_TRUE(result);
+    EXPECT_THAT(*result, ::testing::ElementsAre(1, 2));
+}
+
+// ///////////////////////// Tests on SmallResult //////////////////////////////
+
+namespace {
+    SmallResult<int> small_digit(const char c) {
+        if (c < '0' || c > '9') {
+            return std::unexpected(std::errc::invalid_argument);
+        }
+        return c - '0';
+    }
+} // namespace
+
+TEST(SmallResultTest, Layout) {
+    static_assert(sizeof(SmallResult<int>) == 2 * sizeof(void *));
+    static_assert(sizeof(SmallResult<bool>) == 2 * sizeof(void *));
+    static_assert(sizeof(SmallResult<std::uint64_t>) == 2 * sizeof(void *));
+    static_assert(sizeof(SmallResult<int>) < sizeof(IntResult));
+    static_assert(std::is_trivially_copyable_v<SmallResult<double>>);
+    static_assert(std::is_trivially_destructible_v<SmallResult<int *>>);
+    static_assert(!detail::small_result_value<std::string>);
+    static_assert(!detail::small_result_value<std::array<int, 4>>);
+}
+
+TEST(SmallResultTest, Value) {
+    const SmallResult<int> result = small_digit('7');
+    ASSERT_TRUE(result);
+    EXPECT_TRUE(result.has_value());
+    EXPECT_EQ(*result, 7);
+    EXPECT_EQ(result.value(), 7);
+    EXPECT_EQ(result.value_or(0), 7);
+    EXPECT_EQ(result, 7);
+
+    EXPECT_EQ(*SmallResult<int>{}, 0);
+}
+
+TEST(SmallResultTest, Error) {
+    const auto result = small_digit('x');
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::invalid_argument));
+    EXPECT_TRUE(result.error_code() == std::errc::invalid_argument);
+    EXPECT_EQ(result.value_or(-1), -1);
+    EXPECT_THROW((void) result.value(), std::bad_expected_access<Error>);
+
+    const SmallResult<bool> from_code = std::unexpected(std::make_error_code(std::errc::io_error));
+    EXPECT_TRUE(from_code.error().is(std::errc::io_error));
+
+    const SmallResult<bool> from_extra = std::unexpected(ExtraError::bad_alloc);
+    EXPECT_TRUE(from_extra.error().is(ExtraErrorCondition::resource_error));
+
+    // Only the code of an Error is kept
+    const SmallResult<int> from_error = std::unexpected(Error{std::errc::timed_out, "Too slow"});
+    EXPECT_TRUE(from_error.error().is(std::errc::timed_out));
+    EXPECT_TRUE(from_error.error().context().empty());
+}
+
+TEST(SmallResultTest, ConvertsToAndFromResult) {
+    const IntResult error = small_digit('x');
+    ASSERT_FALSE(error);
+    EXPECT_TRUE(error.error().is(std::errc::invalid_argument));
+
+    const IntResult value = small_digit('3');
+    EXPECT_EQ(value, 3);
+
+    const SmallResult<int> back{make_error<int>(std::errc::permission_denied, "Dropped")};
+    EXPECT_TRUE(back.error().is(std::errc::permission_denied));
+    EXPECT_EQ(SmallResult<int>{IntResult{5}}, 5);
+}
+
+TEST(SmallResultTest, Comparison) {
+    EXPECT_EQ(small_digit('x'), small_digit('y'));
+    EXPECT_NE(small_digit('x'), small_digit('1'));
+    EXPECT_EQ(small_digit('1'), small_digit('1'));
+    EXPECT_NE(small_digit('1'), small_digit('2'));
+}
+
+TEST(SmallResultTest, MonadicOperations) {
+    const auto doubled = small_digit('4').transform([](const int n) { return n * 2; });
+    static_assert(std::is_same_v<decltype(doubled), const SmallResult<int>>);
+    EXPECT_EQ(doubled, 8);
+
+    // Large values fall back to Result
+    const auto text = small_digit('4').transform([](const int n) { return std::to_string(n); });
+    static_assert(std::is_same_v<decltype(text), const StringResult>);
+    EXPECT_EQ(*text, "4");
+
+    const auto chained = small_digit('4').and_then([](const int n) { return small_digit(static_cast<char>('1' + n)); });
+    EXPECT_EQ(chained, 5);
+
+    const auto failed = small_digit('x').and_then([](const int) -> IntResult { return 1; });
+    ASSERT_FALSE(failed);
+    EXPECT_TRUE(failed.error().is(std::errc::invalid_argument));
+
+    const auto recovered = small_digit('x').or_else([](const Error &) { return SmallResult<int>{0}; });
+    EXPECT_EQ(recovered, 0);
+
+    const auto message = small_digit('x').transform_error([](const Error &error) { return error.message(); });
+    static_assert(std::is_same_v<decltype(message), const std::expected<int, std::string>>);
+    EXPECT_FALSE(message.error().empty());
+}
+
+TEST(SmallResultTest, WorksWithTryMacros) {
+    const auto sum = [](const char a, const char b) -> SmallResult<int> {
+        CEU_TRY_ASSIGN(const int x, small_digit(a));
+        CEU_TRY_ASSIGN(const int y, small_digit(b));
+        return x + y;
+    };
+    EXPECT_EQ(sum('1', '2'), 3);
+    EXPECT_TRUE(sum('1', 'x').error().is(std::errc::invalid_argument));
+}
+
+// ///////////////////////// Tests on Status //////////////////////////////
+
+namespace {
+    Status check_positive(const int value) {
+        if (value == 0) {
+            return Status{std::errc::invalid_argument};
+        }
+        if (value < 0) {
+            return Status{std::errc::result_out_of_range, std::format("Negative value {}", value)};
+        }
+        return {};
+    }
+} // namespace
+
+TEST(StatusTest, Layout) {
+    static_assert(sizeof(Status) == 2 * sizeof(void *));
+    static_assert(sizeof(Status) < sizeof(VoidResult));
+    static_assert(std::is_nothrow_move_constructible_v<Status>);
+}
+
+TEST(StatusTest, Success) {
+    const Status status = check_positive(1);
+    EXPECT_TRUE(status);
+    EXPECT_TRUE(status.ok());
+    EXPECT_FALSE(status.error_code());
+    EXPECT_TRUE(status.context().empty());
+    EXPECT_FALSE(status.is(std::errc::invalid_argument));
+    EXPECT_EQ(status, Status{});
+}
+
+TEST(StatusTest, CodeWithoutContext) {
+    const Status status = check_positive(0);
+    ASSERT_FALSE(status);
+    EXPECT_TRUE(status.is(std::errc::invalid_argument));
+    EXPECT_TRUE(status.is(ExtraErrorCondition::logic_error) == status.error().is(ExtraErrorCondition::logic_error));
+    EXPECT_EQ(status.value(), static_cast<int>(std::errc::invalid_argument));
+    EXPECT_EQ(&status.category(), &std::generic_category());
+    EXPECT_TRUE(status.context().empty());
+    EXPECT_EQ(status.message(), std::make_error_code(std::errc::invalid_argument).message());
+}
+
+TEST(StatusTest, CodeWithContext) {
+    const Status status = check_positive(-2);
+    ASSERT_FALSE(status);
+    EXPECT_TRUE(status.is(std::errc::result_out_of_range));
+    EXPECT_EQ(status.context(), "Negative value -2");
+    EXPECT_EQ(status.message(), status.error().message());
+}
+
+TEST(StatusTest, ConvertsToAndFromVoidResult) {
+    const VoidResult result = check_positive(-2);
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::result_out_of_range));
+    EXPECT_EQ(result.error().context(), "Negative value -2");
+
+    const Status back = result;
+    EXPECT_EQ(back.context(), "Negative value -2");
+
+    EXPECT_TRUE(static_cast<VoidResult>(check_positive(1)));
+    EXPECT_TRUE(Status{VoidResult{}});
+
+    const Status from_make_error = make_error<void>(std::errc::io_error, "Writing page");
+    EXPECT_TRUE(from_make_error.is(std::errc::io_error));
+    EXPECT_EQ(from_make_error.context(), "Writing page");
+
+    const Status from_error = Error{ExtraError::bad_alloc, "Allocating page"};
+    EXPECT_TRUE(from_error.is(ExtraErrorCondition::resource_error));
+    EXPECT_EQ(from_error.error().context(), "Allocating page");
+}
+
+TEST(StatusTest, CopyAndMove) {
+    Status status = check_positive(-1);
+    const Status copy = status;
+    EXPECT_EQ(copy.context(), "Negative value -1");
+    EXPECT_EQ(status.context(), "Negative value -1");
+
+    // The moved-from status keeps its code, like a moved-from Error
+    const Status moved = std::move(status);
+    EXPECT_EQ(moved.context(), "Negative value -1");
+    EXPECT_TRUE(status.is(std::errc::result_out_of_range)); // NOLINT(*-use-after-move)
+
+    Status target;
+    target = copy;
+    EXPECT_EQ(target.context(), "Negative value -1");
+    target = check_positive(0);
+    EXPECT_TRUE(target.context().empty());
+    target = Status{};
+    EXPECT_TRUE(target);
+
+    EXPECT_EQ(copy, moved);
+    EXPECT_NE(copy, check_positive(0));
+}
+
+TEST(StatusTest, WorksWithTryMacros) {
+    const auto both = [](const int a, const int b) -> Status {
+        CEU_TRY(check_positive(a));
+        CEU_TRY(check_positive(b));
+        return {};
+    };
+    EXPECT_TRUE(both(1, 2));
+    EXPECT_EQ(both(1, -3).context(), "Negative value -3");
+
+    const auto from_result = []() -> VoidResult {
+        CEU_TRY(check_positive(-4));
+        return {};
+    }();
+    EXPECT_EQ(from_result.error().context(), "Negative value -4");
+}
+
+// ///////////////////////// Tests on CEU_TRY and CEU_TRY_ASSIGN //////////////////////////////
+
+namespace {
+    // An error type that counts its copies and moves.
+    struct CountingError {
+        inline static int copies = 0;
+        inline static int moves = 0;
+
+        CountingError() = default;
+
+        CountingError(const CountingError &) { ++copies; }
+
+        CountingError(CountingError &&) noexcept { ++moves; }
+
+        CountingError &operator=(const CountingError &) = default;
+
+        CountingError &operator=(CountingError &&) noexcept = default;
+    };
+
+    std::expected<int, CountingError> counted(const bool fail) {
+        if (fail) {
+            return std::unexpected(CountingError{});
+        }
+        return 1;
+    }
+
+    std::expected<int, CountingError> forward_with_macro(const bool fail) {
+        CEU_TRY_ASSIGN(const int value, counted(fail));
+        return value + 1;
+    }
+
+    std::expected<int, CountingError> forward_by_hand(const bool fail) {
+        auto result = counted(fail);
+        if (!result) {
+            return std::unexpected(std::move(result).error());
+        }
+        return *result + 1;
+    }
+
+    IntResult add_words(const std::string_view a, const std::string_view b) {
+        return static_cast<int>(CEU_TRY(parse_word(a)).size() + CEU_TRY(parse_word(b)).size());
+    }
+
+    VoidResult check_words(const std::string_view a, const std::string_view b) {
+        CEU_TRY(parse_word(a));
+        CEU_TRY(parse_word(b));
+        return {};
+    }
+} // namespace
+
+TEST(TryMacroTest, AssignsValue) {
+    const auto result = [] -> Result<std::unique_ptr<int>> {
+        CEU_TRY_ASSIGN(auto ptr, Result<std::unique_ptr<int>>{std::make_unique<int>(7)});
+        ++*ptr;
+        return ptr;
+    }();
+    ASSERT_TRUE(result);
+    EXPECT_EQ(**result, 8);
+}
+
+TEST(TryMacroTest, AssignsToExistingVariable) {
+    const auto result = [] -> IntResult {
+        int value = 0;
+        CEU_TRY_ASSIGN(value, IntResult{3});
+        CEU_TRY_ASSIGN(value, make_error<int>(std::errc::io_error, "Failed"));
+        return value;
+    }();
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::io_error));
+}
+
+TEST(TryMacroTest, ExpressionForm) {
+    const auto result = add_words("abc", "de");
+    ASSERT_TRUE(result);
+    EXPECT_EQ(*result, 5);
+
+    const auto error = add_words("abc", "");
+    ASSERT_FALSE(error);
+    EXPECT_EQ(error.error().context(), "Empty word");
+}
+
+TEST(TryMacroTest, VoidExpression) {
+    EXPECT_TRUE(check_words("a", "b"));
+    EXPECT_FALSE(check_words("", "b"));
+}
+
+TEST(TryMacroTest, LvalueIsNotMovedFrom) {
+    const Result<std::string> word{"word"};
+    const auto result = [&word] -> StringResult {
+        CEU_TRY_ASSIGN(std::string copy, word);
+        return copy + "s";
+    }();
+    ASSERT_TRUE(result);
+    EXPECT_EQ(*result, "words");
+    EXPECT_EQ(*word, "word");
+}
+
+TEST(TryMacroTest, NoExtraErrorCopies) {
+    CountingError::copies = CountingError::moves = 0;
+    EXPECT_FALSE(forward_by_hand(true));
+    const int hand_moves = CountingError::moves;
+    EXPECT_EQ(CountingError::copies, 0);
+
+    CountingError::copies = CountingError::moves = 0;
+    EXPECT_FALSE(forward_with_macro(true));
+    EXPECT_EQ(CountingError::copies, 0);
+    EXPECT_EQ(CountingError::moves, hand_moves);
+}
+
 TEST(StdFormatTest, ErrorFormat) {
     Error err(std::make_error_code(std::errc::invalid_argument), "test error");
     const std::string formatted = std::format("Error: {}", err);
@@ -604,3 +1309,166 @@ TEST(StdHashTest, ErrorHash) {
     EXPECT_EQ(hasher(err1), hasher(err2));
     EXPECT_NE(hasher(err1), hasher(err3));
 }
+
+TEST(StdHashTest, ErrorContextHash) {
+    const Error err1(std::make_error_code(std::errc::invalid_argument), "test error 1");
+    const Error err2(std::make_error_code(std::errc::invalid_argument), "test error 2");
+    const Error err3(std::make_error_code(std::errc::invalid_argument), "test error 1");
+
+    constexpr ErrorContextHash hasher;
+    EXPECT_NE(hasher(err1), hasher(err2));
+    EXPECT_EQ(hasher(err1), hasher(err3));
+
+    std::unordered_set<Error, ErrorContextHash, ErrorContextEqual> distinct{err1, err2, err3};
+    EXPECT_EQ(distinct.size(), 2);
+}
+
+// ///////////////////////// Tests on ErrorObserver //////////////////////////////
+
+namespace {
+    struct RecordingObserver final : ErrorObserver {
+        struct Record {
+            std::error_code code;
+            std::string context;
+            std::uint_least32_t line;
+        };
+
+        std::vector<Record> records;
+
+        void on_error(const std::error_code &code, const std::string_view context,
+                      const std::source_location &location) noexcept override {
+            records.push_back({code, std::string{context}, location.line()});
+        }
+    };
+
+    // Installs an observer for the duration of a test
+    struct ScopedObserver {
+        explicit ScopedObserver(ErrorObserver &observer) { EXPECT_EQ(set_error_observer(&observer), nullptr); }
+        ~ScopedObserver() { set_error_observer(nullptr); }
+    };
+} // namespace
+
+TEST(ErrorObserverTest, SeesDirectConstruction) {
+    RecordingObserver observer;
+    ScopedObserver scope{observer};
+
+    const Error error{std::errc::io_error, "Read failed"};
+    const auto line = std::source_location::current().line() - 1;
+    ASSERT_EQ(observer.records.size(), 1);
+    EXPECT_TRUE(observer.records[0].code == std::errc::io_error);
+    EXPECT_EQ(observer.records[0].context, "Read failed");
+    EXPECT_EQ(observer.records[0].line, line);
+}
+
+TEST(ErrorObserverTest, SeesHelpersAtTheirCallSite) {
+    RecordingObserver observer;
+    ScopedObserver scope{observer};
+
+    (void) make_error<int>(std::errc::timed_out, "Too slow");
+    const auto make_error_line = std::source_location::current().line() - 1;
+    (void) make_error<void>(std::make_error_code(std::errc::io_error));
+    (void) try_catch([]() -> int { throw std::length_error("Too long"); }, "Parsing");
+    const auto try_catch_line = std::source_location::current().line() - 1;
+    errno = EACCES;
+    (void) make_error_from_errno<int>("open");
+    const auto errno_line = std::source_location::current().line() - 1;
+
+    ASSERT_EQ(observer.records.size(), 4);
+    EXPECT_EQ(observer.records[0].line, make_error_line);
+    EXPECT_TRUE(observer.records[1].code == std::errc::io_error);
+    EXPECT_TRUE(observer.records[2].code == ExtraError::length_error);
+    EXPECT_EQ(observer.records[2].context, "Parsing: Too long");
+    EXPECT_EQ(observer.records[2].line, try_catch_line);
+    EXPECT_TRUE(observer.records[3].code == std::errc::permission_denied);
+    EXPECT_EQ(observer.records[3].line, errno_line);
+}
+
+TEST(ErrorObserverTest, SeesErrnoWrappersAtTheirCallSite) {
+    RecordingObserver observer;
+    ScopedObserver scope{observer};
+
+    (void) invoke_with_syscall_api([] noexcept { errno = EBADF; return -1; }, "Closing");
+    const auto reset_line = std::source_location::current().line() - 1;
+    (void) invoke_with_syscall_api<ErrnoMode::on_failure>([] noexcept { errno = EBADF; return -1; });
+    const auto on_failure_line = std::source_location::current().line() - 1;
+    (void) with_errno([] { errno = EINVAL; });
+    const auto with_errno_line = std::source_location::current().line() - 1;
+    (void) with_errno<ErrnoMode::preserve>([] { errno = EINVAL; });
+    const auto preserve_line = std::source_location::current().line() - 1;
+    (void) with_errno_if([] { errno = EINVAL; return -1; }, [](const int result) { return result < 0; });
+    const auto with_errno_if_line = std::source_location::current().line() - 1;
+
+    ASSERT_EQ(observer.records.size(), 5);
+    EXPECT_TRUE(observer.records[0].code == std::errc::bad_file_descriptor);
+    EXPECT_EQ(observer.records[0].line, reset_line);
+    EXPECT_EQ(observer.records[1].line, on_failure_line);
+    EXPECT_EQ(observer.records[2].line, with_errno_line);
+    EXPECT_EQ(observer.records[3].line, preserve_line);
+    EXPECT_EQ(observer.records[4].line, with_errno_if_line);
+}
+
+TEST(ErrorObserverTest, IgnoresCopiesAndRecreatedErrors) {
+    RecordingObserver observer;
+    ScopedObserver scope{observer};
+
+    const Error error{std::errc::io_error};
+    const Error copy = error;
+    Error moved = Error{error};
+    moved = copy;
+    (void) Error{std::error_code{}};
+    (void) Error{};
+
+    const SmallResult<int> small{std::unexpect, std::errc::io_error};
+    (void) small.error();
+    const Status status{std::errc::io_error, "Status"};
+    (void) status.error();
+    (void) status.is(std::errc::io_error);
+    AggregateError aggregate{};
+    aggregate.push_back(error);
+    (void) aggregate.to_error();
+
+    EXPECT_EQ(observer.records.size(), 1);
+}
+
+TEST(ErrorObserverTest, Removal) {
+    RecordingObserver observer;
+    {
+        ScopedObserver scope{observer};
+        (void) Error{std::errc::io_error};
+    }
+    (void) Error{std::errc::io_error};
+    EXPECT_EQ(observer.records.size(), 1);
+}
+
+TEST(CompositeObserverTest, ForwardsToEveryObserver) {
+    RecordingObserver first;
+    RecordingObserver second;
+    CompositeObserver composite{&first, &second};
+    ScopedObserver scope{composite};
+
+    (void) Error{std::errc::io_error, "Read failed"};
+    EXPECT_TRUE(composite.remove(&first));
+    EXPECT_FALSE(composite.remove(&first));
+    (void) Error{std::errc::timed_out};
+
+    ASSERT_EQ(first.records.size(), 1);
+    EXPECT_EQ(first.records[0].context, "Read failed");
+    ASSERT_EQ(second.records.size(), 2);
+    EXPECT_TRUE(second.records[1].code == std::errc::timed_out);
+}
+
+TEST(CompositeObserverTest, Capacity) {
+    std::array<RecordingObserver, CompositeObserver::capacity + 1> observers;
+    CompositeObserver composite;
+    for (std::size_t i = 0; i < CompositeObserver::capacity; ++i) {
+        EXPECT_TRUE(composite.add(&observers[i]));
+    }
+    EXPECT_FALSE(composite.add(&observers.back()));
+
+    // A slot freed by a removal is reused
+    EXPECT_TRUE(composite.remove(&observers[3]));
+    EXPECT_TRUE(composite.add(&observers.back()));
+    composite.on_error(std::make_error_code(std::errc::io_error), {}, std::source_location::current());
+    EXPECT_TRUE(observers[3].records.empty());
+    EXPECT_EQ(observers.back().records.size(), 1);
+}
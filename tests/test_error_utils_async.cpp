@@ -0,0 +1,787 @@
+#include <error_utils_async.hpp>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <future>
+#include <mutex>
+#include <ranges>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+using namespace error_utils;
+using namespace std::chrono_literals;
+
+namespace {
+    // Sleeps for up to `duration`, returning early if a stop is requested.
+    bool sleep_for(const std::stop_token &token, const std::chrono::milliseconds duration) {
+        const auto deadline = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (token.stop_requested()) {
+                return false;
+            }
+            std::this_thread::sleep_for(1ms);
+        }
+        return true;
+    }
+
+    auto slow_value(const int value, const std::chrono::milliseconds duration) {
+        return [=](const std::stop_token &token) -> IntResult {
+            if (!sleep_for(token, duration)) {
+                return make_error<int>(std::errc::operation_canceled, "Cancelled");
+            }
+            return value;
+        };
+    }
+
+    auto slow_error(const std::errc errc, const std::chrono::milliseconds duration) {
+        return [code = std::make_error_code(errc), duration](const std::stop_token &token) -> IntResult {
+            sleep_for(token, duration);
+            return make_error<int>(code, "Failed");
+        };
+    }
+} // namespace
+
+// ///////////////////////// Tests on first_of_parallel //////////////////////////////
+
+TEST(FirstOfParallelTest, FastestSuccessWins) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = first_of_parallel(slow_value(1, 2s), slow_value(2, 10ms), slow_value(3, 2s));
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, 2);
+    // The slow alternatives observe the stop token instead of running to completion
+    EXPECT_LT(elapsed, 1s);
+}
+
+TEST(FirstOfParallelTest, SuccessBeatsEarlierErrors) {
+    const auto result = first_of_parallel(slow_error(std::errc::io_error, 0ms), slow_value(42, 20ms));
+
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, 42);
+}
+
+TEST(FirstOfParallelTest, AllErrorsAggregatedInOrder) {
+    const auto result = first_of_parallel(slow_error(std::errc::io_error, 30ms),
+                                          slow_error(std::errc::permission_denied, 0ms),
+                                          slow_error(std::errc::timed_out, 10ms));
+
+    ASSERT_FALSE(result.has_value());
+    const auto &errors = result.error();
+    ASSERT_EQ(errors.size(), 3);
+    EXPECT_EQ(errors.errors()[0].error_code(), std::errc::io_error);
+    EXPECT_EQ(errors.errors()[1].error_code(), std::errc::permission_denied);
+    EXPECT_EQ(errors.errors()[2].error_code(), std::errc::timed_out);
+    EXPECT_EQ(errors.error_code(), std::errc::timed_out);
+}
+
+TEST(FirstOfParallelTest, ChosenCode) {
+    const auto result = first_of_parallel<AggregateCode::first>(slow_error(std::errc::io_error, 0ms),
+                                                                slow_error(std::errc::timed_out, 0ms));
+
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(result.error().error_code(), std::errc::io_error);
+}
+
+TEST(FirstOfParallelTest, AlternativesWithoutStopToken) {
+    const auto result = first_of_parallel([] { return make_error<int>(std::errc::io_error, "Failed"); },
+                                          []() -> IntResult { return 7; });
+
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, 7);
+}
+
+TEST(FirstOfParallelTest, ExceptionsBecomeErrors) {
+    const auto result = first_of_parallel([]() -> IntResult { throw std::invalid_argument("bad"); });
+
+    ASSERT_FALSE(result.has_value());
+    EXPECT_EQ(result.error().size(), 1);
+    EXPECT_EQ(result.error().error_code(), ExtraError::invalid_argument);
+}
+
+TEST(FirstOfParallelTest, HedgeSkipsBackupWhenPrimaryIsFast) {
+    std::atomic<int> backups{};
+    const auto result = first_of_parallel(500ms, slow_value(1, 5ms), [&]() -> IntResult {
+        ++backups;
+        return 2;
+    });
+
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, 1);
+    EXPECT_EQ(backups.load(), 0);
+}
+
+TEST(FirstOfParallelTest, HedgeStartsBackupWhenPrimaryIsSlow) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = first_of_parallel(20ms, slow_value(1, 2s), slow_value(2, 0ms));
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, 2);
+    EXPECT_GE(elapsed, 20ms);
+    EXPECT_LT(elapsed, 1s);
+}
+
+TEST(FirstOfParallelTest, HedgeStartsBackupEarlyOnFailure) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = first_of_parallel(2s, slow_error(std::errc::io_error, 0ms), slow_value(2, 0ms));
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, 2);
+    EXPECT_LT(elapsed, 1s);
+}
+
+TEST(FirstOfParallelTest, VoidResult) {
+    const auto result = first_of_parallel(
+        []() -> VoidResult { return make_error<void>(std::errc::io_error, "Failed"); },
+        []() -> VoidResult { return {}; });
+
+    EXPECT_TRUE(result.has_value());
+}
+
+// ///////////////////////// Tests on task and ThreadPool //////////////////////////////
+
+namespace {
+    task<IntResult> square_on(ThreadPool &pool, const int value, std::thread::id &worker) {
+        co_await pool.schedule();
+        worker = std::this_thread::get_id();
+        co_return value * value;
+    }
+
+    task<IntResult> value_after(ThreadPool &pool, const int value, const std::chrono::milliseconds delay) {
+        co_await pool.schedule();
+        std::this_thread::sleep_for(delay);
+        if (value < 0) {
+            co_return make_error<int>(std::errc::invalid_argument, "Negative value");
+        }
+        co_return value;
+    }
+
+    task<IntResult> add_squares(ThreadPool &pool, const int a, const int b) {
+        std::thread::id worker;
+        const IntResult x = co_await square_on(pool, a, worker);
+        if (!x) co_return x;
+        const IntResult y = co_await square_on(pool, b, worker);
+        if (!y) co_return y;
+        co_return *x + *y;
+    }
+} // namespace
+
+TEST(TaskTest, IsLazy) {
+    bool started = false;
+    // Coroutine lambdas take their state as parameters: captures die with the closure
+    auto work = [](bool &flag) -> task<IntResult> {
+        flag = true;
+        co_return 1;
+    }(started);
+    EXPECT_FALSE(started);
+    EXPECT_EQ(sync_wait(std::move(work)), 1);
+    EXPECT_TRUE(started);
+}
+
+TEST(TaskTest, RunsOnPool) {
+    ThreadPool pool{2};
+    std::thread::id worker;
+    const auto result = sync_wait(square_on(pool, 7, worker));
+    ASSERT_TRUE(result);
+    EXPECT_EQ(*result, 49);
+    EXPECT_NE(worker, std::this_thread::get_id());
+}
+
+TEST(TaskTest, AwaitsOtherTasks) {
+    ThreadPool pool{2};
+    const auto result = sync_wait(add_squares(pool, 3, 4));
+    ASSERT_TRUE(result);
+    EXPECT_EQ(*result, 25);
+}
+
+TEST(TaskTest, ExceptionsBecomeErrors) {
+    const auto result = sync_wait([]() -> task<IntResult> {
+        throw std::length_error("Too long");
+        co_return 1;
+    }());
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(ExtraError::length_error));
+}
+
+TEST(TaskTest, VoidResult) {
+    ThreadPool pool{1};
+    const auto result = sync_wait([](ThreadPool &p) -> task<VoidResult> {
+        co_await p.schedule();
+        co_return {};
+    }(pool));
+    EXPECT_TRUE(result);
+}
+
+TEST(ThreadPoolTest, ManyTasks) {
+    ThreadPool pool{4};
+    std::vector<task<IntResult>> tasks;
+    for (int i = 0; i < 1000; ++i) {
+        tasks.push_back(value_after(pool, i, 0ms));
+    }
+    const auto result = sync_wait(when_all(std::move(tasks)));
+    ASSERT_TRUE(result);
+    ASSERT_EQ(result->size(), 1000);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ((*result)[i], i);
+    }
+}
+
+TEST(WhenAllTest, RunsConcurrently) {
+    ThreadPool pool{4};
+    std::vector<task<IntResult>> tasks;
+    for (int i = 0; i < 4; ++i) {
+        tasks.push_back(value_after(pool, i, 100ms));
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = sync_wait(when_all(std::move(tasks)));
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_TRUE(result);
+    EXPECT_THAT(*result, ::testing::ElementsAre(0, 1, 2, 3));
+    EXPECT_LT(elapsed, 350ms);
+}
+
+TEST(WhenAllTest, AggregatesErrors) {
+    ThreadPool pool{2};
+    std::vector<task<IntResult>> tasks;
+    tasks.push_back(value_after(pool, 1, 0ms));
+    tasks.push_back(value_after(pool, -1, 10ms));
+    tasks.push_back(value_after(pool, -2, 0ms));
+    const auto result = sync_wait(when_all(std::move(tasks)));
+
+    ASSERT_FALSE(result);
+    EXPECT_EQ(result.error().size(), 2);
+    EXPECT_TRUE(result.error().error_code() == std::errc::invalid_argument);
+}
+
+TEST(WhenAllTest, Empty) {
+    const auto result = sync_wait(when_all(std::vector<task<IntResult>>{}));
+    ASSERT_TRUE(result);
+    EXPECT_TRUE(result->empty());
+}
+
+TEST(WhenAnyTest, FirstSuccessWins) {
+    ThreadPool pool{3};
+    std::vector<task<IntResult>> tasks;
+    tasks.push_back(value_after(pool, 1, 300ms));
+    tasks.push_back(value_after(pool, -1, 0ms));
+    tasks.push_back(value_after(pool, 3, 10ms));
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = sync_wait(when_any(std::move(tasks)));
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_TRUE(result);
+    EXPECT_EQ(*result, 3);
+    EXPECT_LT(elapsed, 250ms);
+}
+
+TEST(WhenAnyTest, AllFail) {
+    ThreadPool pool{2};
+    std::vector<task<IntResult>> tasks;
+    tasks.push_back(value_after(pool, -1, 10ms));
+    tasks.push_back(value_after(pool, -2, 0ms));
+    const auto result = sync_wait(when_any(std::move(tasks)));
+
+    ASSERT_FALSE(result);
+    EXPECT_EQ(result.error().size(), 2);
+}
+
+TEST(WhenAnyTest, Empty) {
+    const auto result = sync_wait(when_any(std::vector<task<IntResult>>{}));
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().error_code() == std::errc::invalid_argument);
+}
+
+// ///////////////////////// Tests on when_all and when_any over futures //////////////////////////////
+
+namespace {
+    std::future<IntResult> async_value(const int value, const std::chrono::milliseconds delay) {
+        return std::async(std::launch::async, [=] {
+            std::this_thread::sleep_for(delay);
+            return IntResult{value};
+        });
+    }
+
+    std::future<IntResult> async_error(const std::errc errc, const std::chrono::milliseconds delay) {
+        return std::async(std::launch::async, [=] {
+            std::this_thread::sleep_for(delay);
+            return make_error<int>(std::make_error_code(errc), "Failed");
+        });
+    }
+} // namespace
+
+TEST(WhenAllFuturesTest, GathersInOrder) {
+    std::vector<std::future<IntResult>> futures;
+    futures.push_back(async_value(1, 30ms));
+    futures.push_back(async_value(2, 0ms));
+    futures.push_back(async_value(3, 10ms));
+
+    const auto result = when_all(std::move(futures));
+    ASSERT_TRUE(result);
+    EXPECT_THAT(*result, ::testing::ElementsAre(1, 2, 3));
+}
+
+TEST(WhenAllFuturesTest, TranslatesErrors) {
+    std::promise<IntResult> broken;
+    std::vector<std::future<IntResult>> futures;
+    futures.push_back(async_value(1, 0ms));
+    futures.push_back(async_error(std::errc::io_error, 10ms));
+    futures.push_back(broken.get_future());
+    futures.push_back(std::async(std::launch::deferred, []() -> IntResult { throw std::length_error("Too long"); }));
+    futures.emplace_back();
+    broken = std::promise<IntResult>{};
+
+    const auto result = when_all(std::move(futures));
+    ASSERT_FALSE(result);
+    ASSERT_EQ(result.error().size(), 4);
+    EXPECT_TRUE(result.error().error_code() == std::errc::io_error);
+    const auto errors = result.error().errors();
+    EXPECT_TRUE(errors[1].error_code() == std::future_errc::broken_promise);
+    EXPECT_TRUE(errors[2].is(ExtraError::length_error));
+    EXPECT_TRUE(errors[3].error_code() == std::future_errc::no_state);
+}
+
+TEST(WhenAllFuturesTest, VoidResult) {
+    std::vector<std::future<VoidResult>> futures;
+    futures.push_back(std::async(std::launch::async, [] { return VoidResult{}; }));
+    futures.push_back(std::async(std::launch::async, [] { return VoidResult{}; }));
+    EXPECT_TRUE(when_all(std::move(futures)));
+    EXPECT_TRUE(when_all(std::vector<std::future<VoidResult>>{}));
+}
+
+namespace {
+    /// Fulfil \p promise with \p result on a detached thread after \p delay.
+    void fulfil_later(GroupPromise<int> promise, IntResult result, const std::chrono::milliseconds delay) {
+        std::thread{[promise = std::move(promise), result = std::move(result), delay]() mutable {
+            std::this_thread::sleep_for(delay);
+            promise.set_value(std::move(result));
+        }}.detach();
+    }
+} // namespace
+
+TEST(FutureGroupTest, WhenAllGathersInOrder) {
+    FutureGroup<int> group{3};
+    fulfil_later(group.promise(0), 1, 30ms);
+    fulfil_later(group.promise(1), 2, 0ms);
+    fulfil_later(group.promise(2), 3, 10ms);
+
+    const auto result = when_all(std::move(group));
+    ASSERT_TRUE(result);
+    EXPECT_THAT(*result, ::testing::ElementsAre(1, 2, 3));
+}
+
+TEST(FutureGroupTest, WhenAllTranslatesErrors) {
+    FutureGroup<int> group{4};
+    fulfil_later(group.promise(0), make_error<int>(std::errc::io_error, "Failed"), 10ms);
+    group.promise(1).set_exception(std::make_exception_ptr(std::length_error("Too long")));
+    (void) group.promise(2); // Broken when discarded
+    // Promise 3 is never taken, and broken by when_all()
+
+    const auto result = when_all(std::move(group));
+    ASSERT_FALSE(result);
+    ASSERT_EQ(result.error().size(), 4);
+    const auto errors = result.error().errors();
+    EXPECT_TRUE(errors[0].is(std::errc::io_error));
+    EXPECT_TRUE(errors[1].is(ExtraError::length_error));
+    EXPECT_TRUE(errors[2].error_code() == std::future_errc::broken_promise);
+    EXPECT_TRUE(errors[3].error_code() == std::future_errc::broken_promise);
+}
+
+TEST(FutureGroupTest, PromiseIsFulfilledOnce) {
+    FutureGroup<int> group{1};
+    auto promise = group.promise(0);
+    promise.set_value(1);
+    EXPECT_THROW(promise.set_value(2), std::future_error);
+    EXPECT_THROW(group.promise(0).set_value(3), std::future_error);
+
+    const auto result = when_all(std::move(group));
+    ASSERT_TRUE(result);
+    EXPECT_THAT(*result, ::testing::ElementsAre(1));
+}
+
+TEST(FutureGroupTest, WhenAnyFirstSuccessWins) {
+    FutureGroup<int> group{3};
+    fulfil_later(group.promise(0), 1, 500ms);
+    fulfil_later(group.promise(1), make_error<int>(std::errc::io_error, "Failed"), 0ms);
+    fulfil_later(group.promise(2), 3, 20ms);
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = when_any(std::move(group));
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    ASSERT_TRUE(result);
+    EXPECT_EQ(*result, 3);
+    EXPECT_LT(elapsed, 400ms);
+}
+
+TEST(FutureGroupTest, WhenAnyWithPendingPromise) {
+    FutureGroup<int> group{2};
+    auto never = group.promise(0);
+    group.promise(1).set_value(7);
+
+    const auto result = when_any(std::move(group));
+    ASSERT_TRUE(result);
+    EXPECT_EQ(*result, 7);
+    // The pending promise can still be fulfilled, and its result is discarded
+    never.set_value(8);
+}
+
+TEST(FutureGroupTest, WhenAnyAllFail) {
+    FutureGroup<int> group{3};
+    fulfil_later(group.promise(0), make_error<int>(std::errc::io_error, "Failed"), 10ms);
+    fulfil_later(group.promise(1), make_error<int>(std::errc::timed_out, "Failed"), 0ms);
+    group.promise(2).set_exception(std::make_exception_ptr(std::length_error("Too long")));
+
+    const auto result = when_any(std::move(group));
+    ASSERT_FALSE(result);
+    ASSERT_EQ(result.error().size(), 3);
+    const auto errors = result.error().errors();
+    EXPECT_TRUE(errors[0].is(std::errc::io_error));
+    EXPECT_TRUE(errors[1].is(std::errc::timed_out));
+    EXPECT_TRUE(errors[2].is(ExtraError::length_error));
+}
+
+TEST(FutureGroupTest, WhenAnyManyFutures) {
+    FutureGroup<int> group{200};
+    std::vector<GroupPromise<int>> promises;
+    for (std::size_t i = 0; i < group.size(); ++i) {
+        promises.push_back(group.promise(i));
+    }
+
+    std::jthread producer{[&promises] {
+        std::this_thread::sleep_for(10ms);
+        for (std::size_t i = 0; i < promises.size(); ++i) {
+            if (i == 150) {
+                promises[i].set_value(static_cast<int>(i));
+            } else {
+                promises[i].set_value(make_error<int>(std::errc::io_error, "Failed"));
+            }
+        }
+    }};
+
+    const auto result = when_any(std::move(group));
+    ASSERT_TRUE(result);
+    EXPECT_EQ(*result, 150);
+}
+
+TEST(FutureGroupTest, VoidAndEmpty) {
+    FutureGroup<void> group{2};
+    group.promise(0).set_value({});
+    group.promise(1).set_value({});
+    EXPECT_TRUE(when_all(std::move(group)));
+    EXPECT_TRUE(when_all(FutureGroup<void>{0}));
+
+    const auto result = when_any(FutureGroup<int>{0});
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().error_code() == std::errc::invalid_argument);
+}
+
+// ///////////////////////// Tests on with_deadline and with_timeout //////////////////////////////
+
+TEST(WithTimeoutTest, CooperativeSuccess) {
+    const auto result = with_timeout(1s, slow_value(5, 0ms));
+    ASSERT_TRUE(result);
+    EXPECT_EQ(*result, 5);
+}
+
+TEST(WithTimeoutTest, CooperativeTimeout) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = with_timeout(20ms, slow_value(5, 5s), "Lookup took too long");
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::timed_out));
+    EXPECT_EQ(result.error().context(), "Lookup took too long");
+    EXPECT_GE(elapsed, 20ms);
+    EXPECT_LT(elapsed, 1s);
+}
+
+TEST(WithTimeoutTest, ErrorBeforeDeadlineIsKept) {
+    const auto result = with_timeout(1s, slow_error(std::errc::io_error, 0ms));
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::io_error));
+}
+
+TEST(WithTimeoutTest, HelperThreadTimeout) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = with_timeout(20ms, []() -> IntResult {
+        std::this_thread::sleep_for(200ms);
+        return 1;
+    });
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::timed_out));
+    EXPECT_EQ(result.error().context(), "Deadline exceeded");
+    EXPECT_LT(elapsed, 150ms);
+}
+
+TEST(WithTimeoutTest, HelperThreadSuccess) {
+    const auto result = with_timeout(1s, []() -> IntResult { return 3; });
+    ASSERT_TRUE(result);
+    EXPECT_EQ(*result, 3);
+}
+
+TEST(WithTimeoutTest, HelperThreadsAreBounded) {
+    // Concurrent calls share the workers of the pool instead of starting a thread each
+    std::mutex mutex;
+    std::set<std::thread::id> helpers;
+    const auto record_helper = [&]() -> IntResult {
+        {
+            std::scoped_lock lock{mutex};
+            helpers.insert(std::this_thread::get_id());
+        }
+        std::this_thread::sleep_for(2ms);
+        return 1;
+    };
+
+    ThreadPool pool{2};
+    std::atomic<int> succeeded{};
+    {
+        std::vector<std::jthread> threads;
+        for (int i = 0; i < 16; ++i) {
+            threads.emplace_back([&] {
+                succeeded += with_timeout(pool, 5s, record_helper).has_value();
+                succeeded += with_timeout(5s, record_helper).has_value();
+            });
+        }
+    }
+    EXPECT_EQ(succeeded, 32);
+    EXPECT_LE(helpers.size(), pool.size() + detail::deadline_pool().size());
+}
+
+TEST(WithTimeoutTest, QueuedWorkTimesOut) {
+    ThreadPool pool{1};
+    const auto busy = with_timeout(pool, 10ms, []() -> IntResult {
+        std::this_thread::sleep_for(200ms);
+        return 1;
+    });
+    ASSERT_FALSE(busy);
+
+    // The only worker is still busy, so this call times out before it starts
+    const auto start = std::chrono::steady_clock::now();
+    const auto queued = with_timeout(pool, 20ms, []() -> IntResult { return 2; }, "Queued");
+    ASSERT_FALSE(queued);
+    EXPECT_TRUE(queued.error().is(std::errc::timed_out));
+    EXPECT_EQ(queued.error().context(), "Queued");
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 150ms);
+}
+
+TEST(WithDeadlineTest, ManyConcurrentDeadlines) {
+    // All the deadlines are served by the same timer thread
+    std::vector<std::jthread> threads;
+    std::atomic<int> timed_out{};
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([i, &timed_out] {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds{10 + i * 5};
+            if (const auto result = with_deadline(deadline, slow_value(i, 5s)); !result) {
+                timed_out += result.error().is(std::errc::timed_out);
+            }
+        });
+    }
+    threads.clear();
+    EXPECT_EQ(timed_out.load(), 8);
+}
+
+TEST(WithDeadlineTest, SystemClockDeadline) {
+    const auto result = with_deadline(std::chrono::system_clock::now() + 20ms, slow_value(1, 5s));
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::timed_out));
+}
+
+TEST(WithDeadlineTest, CancelledTimersDoNotAccumulate) {
+    detail::timer_service timers;
+    const auto far = std::chrono::steady_clock::now() + 1h;
+    std::vector<std::uint64_t> live;
+    for (int i = 0; i < 100; ++i) {
+        live.push_back(timers.schedule(far - std::chrono::seconds{i}, std::stop_source{}));
+    }
+    // Calls completing long before their deadline, which is behind the live ones in the heap
+    for (int i = 0; i < 10000; ++i) {
+        timers.cancel(timers.schedule(far + std::chrono::seconds{i % 50}, std::stop_source{}));
+    }
+    EXPECT_LE(timers.size(), 2 * live.size() + 1);
+
+    for (const auto id : live) {
+        timers.cancel(id);
+    }
+    EXPECT_LE(timers.size(), 1);
+}
+
+// ///////////////////////// Tests on parallel_transform //////////////////////////////
+
+namespace {
+    IntResult checked_square(const int value) {
+        if (value < 0) {
+            return make_error<int>(std::errc::invalid_argument, std::format("Negative value {}", value));
+        }
+        return value * value;
+    }
+} // namespace
+
+TEST(ParallelTransformTest, PreservesOrder) {
+    ThreadPool pool{4};
+    const auto result = parallel_transform(std::views::iota(0, 10000), checked_square, pool);
+    ASSERT_TRUE(result);
+    ASSERT_EQ(result->size(), 10000);
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_EQ((*result)[i], i * i);
+    }
+}
+
+TEST(ParallelTransformTest, EarliestErrorWins) {
+    ThreadPool pool{4};
+    std::vector<int> values(5000, 1);
+    values[4000] = -3;
+    values[1234] = -2;
+    values[2500] = -1;
+
+    for (int run = 0; run < 20; ++run) {
+        const auto result = parallel_transform(values, checked_square, pool, 16);
+        ASSERT_FALSE(result);
+        EXPECT_TRUE(result.error().is(std::errc::invalid_argument));
+        EXPECT_EQ(result.error().context(), "Negative value -2");
+    }
+}
+
+TEST(ParallelTransformTest, StopsAfterError) {
+    ThreadPool pool{4};
+    std::atomic<int> calls{};
+    const auto result = parallel_transform(std::views::iota(0, 100000), [&calls](const int value) -> IntResult {
+        ++calls;
+        if (value == 10) {
+            return make_error<int>(std::errc::io_error, "Failed");
+        }
+        std::this_thread::sleep_for(10us);
+        return value;
+    }, pool, 8);
+
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::io_error));
+    EXPECT_LT(calls.load(), 100000);
+}
+
+TEST(ParallelTransformTest, ElementInFlightSeesStop) {
+    ThreadPool pool{1};
+    std::atomic<bool> started{};
+    std::atomic<bool> stopped{};
+    const auto begin = std::chrono::steady_clock::now();
+    const auto element = [&](const int value, const std::stop_token &token) -> IntResult {
+        if (value == 0) {
+            // Fail while the other element is running
+            while (!started && std::chrono::steady_clock::now() - begin < 5s) {
+                std::this_thread::sleep_for(1ms);
+            }
+            return make_error<int>(std::errc::io_error, "Failed");
+        }
+        started = true;
+        while (!token.stop_requested() && std::chrono::steady_clock::now() - begin < 5s) {
+            std::this_thread::sleep_for(1ms);
+        }
+        stopped = token.stop_requested();
+        return make_error<int>(std::errc::operation_canceled, "Gave up");
+    };
+    const auto result = parallel_transform(std::views::iota(0, 2), element, pool, 1);
+
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::io_error));
+    EXPECT_TRUE(stopped);
+    EXPECT_LT(std::chrono::steady_clock::now() - begin, 5s);
+}
+
+TEST(ParallelTransformTest, ElementBeforeFailureIsNotStopped) {
+    ThreadPool pool{1};
+    std::atomic<bool> failed{};
+    std::atomic<bool> stopped{};
+    const auto begin = std::chrono::steady_clock::now();
+    const auto element = [&](const int value, const std::stop_token &token) -> IntResult {
+        if (value == 1) {
+            failed = true;
+            return make_error<int>(std::errc::io_error, "Failed");
+        }
+        // Still running when the next element fails, and long after
+        while (!failed && std::chrono::steady_clock::now() - begin < 5s) {
+            std::this_thread::sleep_for(1ms);
+        }
+        for (int i = 0; i < 20 && !token.stop_requested(); ++i) {
+            std::this_thread::sleep_for(1ms);
+        }
+        if (token.stop_requested()) {
+            stopped = true;
+            return make_error<int>(std::errc::operation_canceled, "Gave up");
+        }
+        return value;
+    };
+    const auto result = parallel_transform(std::views::iota(0, 2), element, pool, 1);
+
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::io_error));
+    EXPECT_FALSE(stopped);
+}
+
+TEST(ParallelTransformTest, VoidResult) {
+    ThreadPool pool{2};
+    std::atomic<int> sum{};
+    EXPECT_TRUE(parallel_transform(std::views::iota(1, 101), [&sum](const int value) -> VoidResult {
+        sum += value;
+        return {};
+    }, pool));
+    EXPECT_EQ(sum.load(), 5050);
+}
+
+TEST(ParallelTransformTest, ExceptionsBecomeErrors) {
+    ThreadPool pool{2};
+    const auto result = parallel_transform(std::views::iota(0, 100), [](const int value) -> IntResult {
+        if (value == 50) {
+            throw std::length_error("Too long");
+        }
+        return value;
+    }, pool);
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(ExtraError::length_error));
+}
+
+TEST(ParallelTransformTest, EmptyRange) {
+    ThreadPool pool{2};
+    const auto result = parallel_transform(std::vector<int>{}, checked_square, pool);
+    ASSERT_TRUE(result);
+    EXPECT_TRUE(result->empty());
+}
+
+TEST(ParallelTransformTest, BoolAndNonDefaultConstructibleValues) {
+    ThreadPool pool{4};
+    const auto flags = parallel_transform(std::views::iota(0, 1000),
+                                          [](const int value) -> BoolResult { return value % 2 == 0; }, pool);
+    ASSERT_TRUE(flags);
+    EXPECT_EQ(std::ranges::count(*flags, true), 500);
+
+    struct Wrapped {
+        explicit Wrapped(const int value) : value{value} {}
+
+        int value;
+    };
+    const auto wrapped = parallel_transform(std::views::iota(0, 1000),
+                                            [](const int value) -> Result<Wrapped> { return Wrapped{value}; }, pool);
+    ASSERT_TRUE(wrapped);
+    EXPECT_EQ((*wrapped)[999].value, 999);
+}
+
+TEST(ParallelTransformTest, CalledFromWorker) {
+    // The calling worker takes part, so a single-worker pool does not deadlock
+    ThreadPool pool{1};
+    const auto result = sync_wait([](ThreadPool &p) -> task<Result<std::size_t>> {
+        co_await p.schedule();
+        const auto squares = parallel_transform(std::views::iota(0, 1000), checked_square, p);
+        if (!squares) {
+            co_return std::unexpected(squares.error());
+        }
+        co_return squares->size();
+    }(pool));
+    ASSERT_TRUE(result);
+    EXPECT_EQ(*result, 1000);
+}
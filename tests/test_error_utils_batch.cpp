@@ -0,0 +1,140 @@
+#include <error_utils_batch.hpp>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <limits>
+#include <ranges>
+#include <vector>
+
+using namespace error_utils;
+
+// ///////////////////////// Tests on FailureMask //////////////////////////////
+
+TEST(FailureMaskTest, SetAndTest) {
+    FailureMask mask{130};
+    EXPECT_EQ(mask.size(), 130);
+    EXPECT_EQ(mask.words().size(), 3);
+    EXPECT_TRUE(mask.none());
+
+    mask.set(0);
+    mask.set(63);
+    mask.set(64);
+    mask.set(129);
+    EXPECT_FALSE(mask.none());
+    EXPECT_EQ(mask.count(), 4);
+    EXPECT_TRUE(mask.test(63));
+    EXPECT_FALSE(mask.test(62));
+    EXPECT_THAT(std::vector(mask.indices().begin(), mask.indices().end()), ::testing::ElementsAre(0, 63, 64, 129));
+}
+
+TEST(FailureMaskTest, EmptyMask) {
+    const FailureMask mask{};
+    EXPECT_TRUE(mask.none());
+    EXPECT_TRUE(mask.indices().empty());
+
+    FailureMask no_failures{200};
+    EXPECT_TRUE(no_failures.indices().empty());
+}
+
+TEST(FailureMaskTest, Merge) {
+    FailureMask first{100};
+    FailureMask second{100};
+    first.set(3);
+    second.set(3);
+    second.set(99);
+    first |= second;
+    EXPECT_EQ(first.count(), 2);
+    EXPECT_EQ(first, second);
+}
+
+// ///////////////////////// Tests on validate_batch //////////////////////////////
+
+TEST(ValidateBatchTest, EveryBitOfEveryWord) {
+    // Exercise each position of the packed words, including the tail
+    std::vector<int> values(200);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = static_cast<int>(i);
+    }
+    for (std::size_t bad = 0; bad < values.size(); ++bad) {
+        values[bad] = -1;
+        const auto check = validate_batch(values, in_range(0, 1000), std::errc::result_out_of_range);
+        ASSERT_EQ(check.failure_count(), 1);
+        ASSERT_TRUE(check.failures().test(bad));
+        values[bad] = static_cast<int>(bad);
+    }
+}
+
+TEST(ValidateBatchTest, Range) {
+    const std::vector values{1.0, -1.0, 5.0, std::numeric_limits<double>::quiet_NaN(), 10.0, 10.5};
+    const auto check = validate_batch(values, in_range(0.0, 10.0), std::errc::result_out_of_range, "Bad price");
+
+    EXPECT_FALSE(check);
+    EXPECT_EQ(check.failure_count(), 3);
+    EXPECT_THAT(std::vector(check.failures().indices().begin(), check.failures().indices().end()),
+                ::testing::ElementsAre(1, 3, 5));
+}
+
+TEST(ValidateBatchTest, Finite) {
+    std::vector<float> floats(100, 1.5F);
+    floats[10] = std::numeric_limits<float>::infinity();
+    floats[70] = std::numeric_limits<float>::quiet_NaN();
+    floats[80] = std::numeric_limits<float>::max();
+    floats[90] = -std::numeric_limits<float>::denorm_min();
+    const auto check = validate_batch(floats, is_finite, std::errc::argument_out_of_domain);
+    EXPECT_EQ(check.failure_count(), 2);
+    EXPECT_TRUE(check.failures().test(10));
+    EXPECT_TRUE(check.failures().test(70));
+
+    const std::array doubles{0.0, -std::numeric_limits<double>::infinity(), 1e308};
+    EXPECT_EQ(validate_batch(doubles, is_finite, std::errc::argument_out_of_domain).failure_count(), 1);
+
+    const std::array long_doubles{0.0L, std::numeric_limits<long double>::quiet_NaN()};
+    EXPECT_EQ(validate_batch(long_doubles, is_finite, std::errc::argument_out_of_domain).failure_count(), 1);
+}
+
+TEST(ValidateBatchTest, NonNull) {
+    const int value = 1;
+    const std::array<const int *, 3> pointers{&value, nullptr, &value};
+    const auto check = validate_batch(std::span{pointers}, is_non_null, std::errc::invalid_argument);
+    EXPECT_EQ(check.failure_count(), 1);
+    EXPECT_TRUE(check.failures().test(1));
+}
+
+TEST(ValidateBatchTest, CustomPredicate) {
+    const std::vector<int> values{2, 4, 5, 8};
+    const auto check = validate_batch(values, [](const int n) { return n % 2 == 0; }, ExtraError::invalid_argument);
+    EXPECT_EQ(check.failure_count(), 1);
+    EXPECT_TRUE(check.first_error().error().is(ExtraError::invalid_argument));
+}
+
+TEST(ValidateBatchTest, Success) {
+    const std::vector<int> values(1000, 5);
+    const auto check = validate_batch(values, in_range(0, 10), std::errc::result_out_of_range);
+    EXPECT_TRUE(check);
+    EXPECT_TRUE(check.first_error());
+    EXPECT_TRUE(std::ranges::empty(check.errors()));
+
+    EXPECT_TRUE(validate_batch(std::vector<int>{}, in_range(0, 10), std::errc::result_out_of_range));
+}
+
+TEST(ValidateBatchTest, ErrorsAreMaterializedOnDemand) {
+    std::vector<int> values(1000, 5);
+    values[3] = -1;
+    values[700] = 11;
+    const auto check = validate_batch(values, in_range(0, 10), std::errc::result_out_of_range, "Bad value");
+
+    std::vector<Error> errors;
+    for (const Error &error : check.errors()) {
+        errors.push_back(error);
+    }
+    ASSERT_EQ(errors.size(), 2);
+    EXPECT_TRUE(errors[0].is(std::errc::result_out_of_range));
+    EXPECT_EQ(errors[0].context(), "Bad value (at index 3)");
+    EXPECT_EQ(errors[1].context(), "Bad value (at index 700)");
+
+    const auto first = check.first_error();
+    ASSERT_FALSE(first);
+    EXPECT_EQ(first.error().context(), "Bad value (at index 3)");
+    EXPECT_EQ(check.error_at(5).context(), "Bad value (at index 5)");
+}
@@ -0,0 +1,137 @@
+#include <error_utils_coro.hpp>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+
+using namespace error_utils;
+
+namespace {
+    IntResult parse_digit(const char c) {
+        if (c < '0' || c > '9') {
+            return make_error<int>(std::errc::invalid_argument, "Not a digit");
+        }
+        return c - '0';
+    }
+
+    IntResult sum_digits(const std::string_view text, int &evaluated) {
+        int sum = 0;
+        for (const char c : text) {
+            sum += co_await parse_digit(c);
+            ++evaluated;
+        }
+        co_return sum;
+    }
+
+    VoidResult check_digits(const std::string_view text) {
+        for (const char c : text) {
+            co_await parse_digit(c);
+        }
+    }
+
+    // Tracks destruction of locals when the coroutine returns early.
+    struct Tracker {
+        int &destroyed;
+
+        ~Tracker() { ++destroyed; }
+    };
+
+    IntResult fail_with_local(int &destroyed) {
+        Tracker tracker{destroyed};
+        co_await make_error<void>(std::errc::io_error, "Failed");
+        co_return 1;
+    }
+} // namespace
+
+// ///////////////////////// Tests on Result coroutines //////////////////////////////
+
+TEST(ResultCoroutineTest, Success) {
+    int evaluated = 0;
+    const auto result = sum_digits("123", evaluated);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(*result, 6);
+    EXPECT_EQ(evaluated, 3);
+}
+
+TEST(ResultCoroutineTest, ShortCircuitsOnError) {
+    int evaluated = 0;
+    const auto result = sum_digits("12x4", evaluated);
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::invalid_argument));
+    EXPECT_EQ(result.error().context(), "Not a digit");
+    EXPECT_EQ(evaluated, 2);
+}
+
+TEST(ResultCoroutineTest, VoidResult) {
+    EXPECT_TRUE(check_digits("42"));
+
+    const auto result = check_digits("4x");
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::invalid_argument));
+}
+
+TEST(ResultCoroutineTest, LocalsDestroyedOnError) {
+    int destroyed = 0;
+    const auto result = fail_with_local(destroyed);
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::io_error));
+    EXPECT_EQ(destroyed, 1);
+}
+
+TEST(ResultCoroutineTest, CoReturnError) {
+    const auto result = []() -> IntResult {
+        co_await IntResult{1};
+        co_return make_error<int>(std::errc::timed_out, "Too slow");
+    }();
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::timed_out));
+}
+
+TEST(ResultCoroutineTest, MovesValueOutOfTemporary) {
+    const auto result = []() -> Result<std::unique_ptr<int>> {
+        std::unique_ptr<int> ptr = co_await Result<std::unique_ptr<int>>{std::make_unique<int>(7)};
+        co_return std::move(ptr);
+    }();
+    ASSERT_TRUE(result);
+    EXPECT_EQ(**result, 7);
+}
+
+TEST(ResultCoroutineTest, LvalueIsNotMovedFrom) {
+    const Result<std::string> text{"hello"};
+    const auto result = [&text]() -> Result<std::size_t> {
+        const std::string &value = co_await text;
+        co_return value.size();
+    }();
+    ASSERT_TRUE(result);
+    EXPECT_EQ(*result, 5);
+    EXPECT_EQ(*text, "hello");
+}
+
+TEST(ResultCoroutineTest, AwaitsAggregateResult) {
+    const auto result = []() -> IntResult {
+        co_return co_await first_of_aggregate([] { return make_error<int>(std::errc::io_error, "Failed"); });
+    }();
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::io_error));
+}
+
+TEST(ResultCoroutineTest, ExceptionsBecomeErrors) {
+    const auto result = []() -> IntResult {
+        co_await IntResult{1};
+        throw std::length_error("Too long");
+    }();
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(ExtraError::length_error));
+}
+
+TEST(ResultCoroutineTest, FramesAreReused) {
+    int evaluated = 0;
+    // Warm up the freelist of this thread
+    EXPECT_TRUE(sum_digits("1", evaluated));
+
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(sum_digits("99", evaluated));
+        EXPECT_FALSE(sum_digits("9x", evaluated));
+    }
+}
@@ -0,0 +1,304 @@
+#include <error_utils_diagnostics.hpp>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace error_utils;
+using namespace std::chrono_literals;
+
+// ///////////////////////// Tests on FlightRecorder //////////////////////////////
+
+namespace {
+    std::vector<ErrorRecord> records_of(const FlightRecorder &recorder) {
+        std::vector<ErrorRecord> records(recorder.capacity());
+        records.resize(recorder.snapshot(records));
+        return records;
+    }
+} // namespace
+
+TEST(FlightRecorderTest, RecordsInOrder) {
+    FlightRecorder recorder{8, 4};
+    recorder.record(std::make_error_code(std::errc::io_error), "First");
+    recorder.record(Error{ExtraError::bad_alloc, "Second"});
+    recorder.record(std::error_code{});
+
+    const auto records = records_of(recorder);
+    ASSERT_EQ(records.size(), 2);
+    EXPECT_EQ(records[0].code(), std::errc::io_error);
+    EXPECT_EQ(records[0].context_view(), "First");
+    EXPECT_EQ(records[1].code(), make_error_code(ExtraError::bad_alloc));
+    EXPECT_EQ(records[1].context_view(), "Second");
+    EXPECT_LE(records[0].timestamp, records[1].timestamp);
+    EXPECT_EQ(records[0].thread, records[1].thread);
+    EXPECT_THAT(records[0].file, ::testing::HasSubstr("test_error_utils_diagnostics.cpp"));
+    EXPECT_GT(records[0].line, 0);
+}
+
+TEST(FlightRecorderTest, KeepsLastRecordsOfEachThread) {
+    FlightRecorder recorder{4, 2};
+    for (int value = 1; value <= 10; ++value) {
+        recorder.record(std::error_code{value, std::generic_category()});
+    }
+    const auto records = records_of(recorder);
+    ASSERT_EQ(records.size(), 4);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(records[i].value, 7 + i);
+    }
+}
+
+TEST(FlightRecorderTest, TruncatesContext) {
+    FlightRecorder recorder;
+    const std::string context(200, 'x');
+    recorder.record(std::make_error_code(std::errc::io_error), context);
+    const auto records = records_of(recorder);
+    ASSERT_EQ(records.size(), 1);
+    EXPECT_EQ(records[0].context_view(), context.substr(0, ErrorRecord::context_capacity));
+}
+
+TEST(FlightRecorderTest, SmallSnapshotKeepsMostRecent) {
+    FlightRecorder recorder{8, 1};
+    for (int value = 1; value <= 6; ++value) {
+        recorder.record(std::error_code{value, std::generic_category()});
+    }
+    std::array<ErrorRecord, 2> records{};
+    ASSERT_EQ(recorder.snapshot(records), 2);
+    EXPECT_EQ(records[0].value, 5);
+    EXPECT_EQ(records[1].value, 6);
+}
+
+TEST(FlightRecorderTest, MergesThreads) {
+    FlightRecorder recorder{16, 8};
+    {
+        std::vector<std::jthread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&recorder, t] {
+                for (int i = 0; i < 1000; ++i) {
+                    recorder.record(std::error_code{1000 + t, std::generic_category()}, "Worker");
+                }
+            });
+        }
+        // Snapshots while the threads are recording
+        for (int i = 0; i < 10; ++i) {
+            for (const auto &record : records_of(recorder)) {
+                EXPECT_EQ(record.context_view(), "Worker");
+            }
+        }
+    }
+    const auto records = records_of(recorder);
+    ASSERT_EQ(records.size(), 64);
+    EXPECT_TRUE(std::ranges::is_sorted(records, {}, &ErrorRecord::timestamp));
+    for (int t = 0; t < 4; ++t) {
+        EXPECT_EQ(std::ranges::count(records, 1000 + t, &ErrorRecord::value), 16);
+    }
+    EXPECT_EQ(recorder.dropped(), 0);
+}
+
+TEST(FlightRecorderTest, RingsAreReusedAfterThreadsExit) {
+    FlightRecorder recorder{4, 2};
+    for (int t = 0; t < 10; ++t) {
+        std::jthread{[&recorder] { recorder.record(std::make_error_code(std::errc::io_error)); }}.join();
+    }
+    EXPECT_EQ(recorder.dropped(), 0);
+    EXPECT_EQ(records_of(recorder).size(), 8);
+}
+
+TEST(FlightRecorderTest, DropsWhenAllRingsAreOwned) {
+    FlightRecorder recorder{4, 1};
+    recorder.record(std::make_error_code(std::errc::io_error));
+    std::jthread{[&recorder] { recorder.record(std::make_error_code(std::errc::io_error)); }}.join();
+    EXPECT_EQ(recorder.dropped(), 1);
+}
+
+TEST(FlightRecorderTest, DumpsToFileDescriptor) {
+    FlightRecorder recorder;
+    recorder.record(std::make_error_code(std::errc::io_error), "Read failed");
+    recorder.record(std::make_error_code(std::errc::timed_out), "Too slow");
+
+    int pipe_fds[2];
+    ASSERT_EQ(::pipe(pipe_fds), 0);
+    EXPECT_TRUE(recorder.dump(pipe_fds[1]));
+    ::close(pipe_fds[1]);
+
+    std::string output(4096, '\0');
+    output.resize(static_cast<std::size_t>(::read(pipe_fds[0], output.data(), output.size())));
+    ::close(pipe_fds[0]);
+
+    const auto io_error = " generic:" + std::to_string(static_cast<int>(std::errc::io_error)) + " ";
+    EXPECT_THAT(output, ::testing::HasSubstr(io_error));
+    EXPECT_THAT(output, ::testing::HasSubstr("test_error_utils_diagnostics.cpp:"));
+    EXPECT_THAT(output, ::testing::EndsWith(" Too slow\n"));
+    EXPECT_LT(output.find("Read failed"), output.find("Too slow"));
+    EXPECT_EQ(std::ranges::count(output, '\n'), 2);
+}
+
+TEST(FlightRecorderTest, RecordsAsErrorObserver) {
+    FlightRecorder recorder;
+    set_error_observer(&recorder);
+    const auto line = std::source_location::current().line() + 1;
+    (void) make_error<int>(std::errc::io_error, "Failed");
+    set_error_observer(nullptr);
+    (void) Error{ExtraError::bad_alloc};
+
+    const auto records = records_of(recorder);
+    ASSERT_EQ(records.size(), 1);
+    EXPECT_EQ(records[0].code(), std::errc::io_error);
+    EXPECT_EQ(records[0].context_view(), "Failed");
+    EXPECT_EQ(records[0].line, line);
+}
+
+// ///////////////////////// Tests on RateLimitedLog //////////////////////////////
+
+namespace {
+    // Collects the lines written by a RateLimitedLog.
+    struct Lines {
+        std::mutex mutex;
+        std::vector<std::string> lines;
+
+        RateLimitedLog::Writer writer() {
+            return [this](const std::string_view line) {
+                std::scoped_lock lock{mutex};
+                lines.emplace_back(line);
+            };
+        }
+
+        std::size_t count(const std::string_view text) {
+            std::scoped_lock lock{mutex};
+            return std::ranges::count_if(lines, [text](const auto &line) { return line.contains(text); });
+        }
+    };
+} // namespace
+
+TEST(RateLimitedLogTest, CollapsesRepeats) {
+    Lines lines;
+    {
+        RateLimitedLog log{lines.writer(), 1h};
+        for (int i = 0; i < 1000; ++i) {
+            log.log(std::make_error_code(std::errc::connection_reset), "Peer");
+        }
+        log.log(Error{std::errc::connection_reset, "Other peer"});
+        log.log(std::error_code{});
+        EXPECT_EQ(log.written(), 2);
+    }
+    ASSERT_EQ(lines.lines.size(), 3);
+    EXPECT_THAT(lines.lines[0], ::testing::HasSubstr("Peer: "));
+    EXPECT_THAT(lines.lines[0], ::testing::HasSubstr("test_error_utils_diagnostics.cpp:"));
+    EXPECT_EQ(lines.count("Other peer"), 1);
+    EXPECT_EQ(lines.count("repeated 999 times"), 1);
+}
+
+TEST(RateLimitedLogTest, WritesAgainInNextWindow) {
+    Lines lines;
+    {
+        RateLimitedLog log{lines.writer(), 20ms};
+        for (int i = 0; i < 3; ++i) {
+            log.log(std::make_error_code(std::errc::timed_out), "Slow");
+        }
+        std::this_thread::sleep_for(30ms);
+        log.log(std::make_error_code(std::errc::timed_out), "Slow");
+    }
+    // Written twice, with the two repeats of the first window in between
+    EXPECT_EQ(lines.count("(error_code: "), 2);
+    EXPECT_EQ(lines.count("repeated 2 times"), 1);
+    EXPECT_EQ(lines.count("repeated"), 1);
+}
+
+TEST(RateLimitedLogTest, SummarizesWhenWindowEnds) {
+    Lines lines;
+    RateLimitedLog log{lines.writer(), 10ms};
+    log.log(std::make_error_code(std::errc::io_error), "Disk");
+    log.log(std::make_error_code(std::errc::io_error), "Disk");
+    for (int i = 0; i < 100 && lines.count("repeated 1 times") == 0; ++i) {
+        std::this_thread::sleep_for(5ms);
+    }
+    EXPECT_EQ(lines.count("repeated 1 times"), 1);
+}
+
+TEST(RateLimitedLogTest, KeepsCloseValuesApart) {
+    Lines lines;
+    {
+        RateLimitedLog log{lines.writer(), 1h, 64};
+        for (int value = 1; value <= 32; ++value) {
+            log.log(std::error_code{value, std::generic_category()});
+            log.log(std::error_code{value, std::generic_category()});
+        }
+        EXPECT_EQ(log.written(), 32);
+    }
+    EXPECT_EQ(lines.count("(error_code: "), 32);
+    EXPECT_EQ(lines.count("repeated 1 times"), 32);
+}
+
+TEST(RateLimitedLogTest, WakesOnEachError) {
+    Lines lines;
+    // The background thread otherwise only wakes up every 100ms
+    RateLimitedLog log{lines.writer(), 1h};
+    for (int value = 1; value <= 20; ++value) {
+        std::this_thread::sleep_for(2ms); // Let the background thread go to sleep
+        const auto start = std::chrono::steady_clock::now();
+        log.log(std::error_code{value, std::generic_category()});
+        while (lines.count("(error_code: ") < static_cast<std::size_t>(value) &&
+               std::chrono::steady_clock::now() - start < 1s) {
+            std::this_thread::yield();
+        }
+        EXPECT_LT(std::chrono::steady_clock::now() - start, 50ms);
+    }
+}
+
+TEST(RateLimitedLogTest, DropsWhenQueueIsFull) {
+    Lines lines;
+    std::uint64_t written = 0;
+    {
+        // A single entry: every distinct error but the first is written without deduplication
+        RateLimitedLog log{lines.writer(), 1h, 1, 4};
+        for (int value = 1; value <= 1000; ++value) {
+            log.log(std::error_code{value, std::generic_category()});
+        }
+        written = log.written();
+        EXPECT_EQ(written + log.dropped(), 1000);
+        EXPECT_GT(log.dropped(), 0);
+    }
+    EXPECT_EQ(lines.lines.size(), written);
+}
+
+TEST(RateLimitedLogTest, ConcurrentStorm) {
+    Lines lines;
+    {
+        RateLimitedLog log{lines.writer(), 1h};
+        std::vector<std::jthread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&log] {
+                for (int i = 0; i < 10000; ++i) {
+                    log.log(std::make_error_code(std::errc::connection_reset), "Peer");
+                    log.log(std::make_error_code(std::errc::broken_pipe), "Peer");
+                }
+            });
+        }
+    }
+    EXPECT_EQ(lines.count("(error_code: "), 2);
+    EXPECT_EQ(lines.count("repeated 39999 times"), 2);
+}
+
+TEST(RateLimitedLogTest, WritesToFileDescriptor) {
+    int pipe_fds[2];
+    ASSERT_EQ(::pipe(pipe_fds), 0);
+    {
+        RateLimitedLog log{pipe_fds[1]};
+        set_error_observer(&log);
+        (void) make_error<int>(std::errc::io_error, "Read failed");
+        (void) make_error<int>(std::errc::io_error, "Read failed");
+        set_error_observer(nullptr);
+    }
+    ::close(pipe_fds[1]);
+
+    std::string output(4096, '\0');
+    output.resize(static_cast<std::size_t>(::read(pipe_fds[0], output.data(), output.size())));
+    ::close(pipe_fds[0]);
+    EXPECT_THAT(output, ::testing::HasSubstr("Read failed: "));
+    EXPECT_THAT(output, ::testing::HasSubstr("repeated 1 times\n"));
+}
@@ -0,0 +1,425 @@
+#include <error_utils_io.hpp>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+using namespace error_utils;
+
+namespace {
+    // Creates a uniquely named file in the temporary directory and removes it on destruction.
+    class TempFile {
+        std::string path_;
+
+    public:
+        explicit TempFile(const std::string_view content = {}) {
+            std::string tmpl = (std::filesystem::temp_directory_path() / "error_utils_XXXXXX").string();
+            const int fd = ::mkstemp(tmpl.data());
+            EXPECT_NE(fd, -1);
+            if (!content.empty()) {
+                EXPECT_EQ(::write(fd, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+            }
+            ::close(fd);
+            path_ = std::move(tmpl);
+        }
+
+        TempFile(const TempFile &) = delete;
+
+        TempFile &operator=(const TempFile &) = delete;
+
+        ~TempFile() { std::filesystem::remove(path_); }
+
+        [[nodiscard]] const std::string &path() const { return path_; }
+    };
+} // namespace
+
+// ///////////////////////// Tests on UniqueFd //////////////////////////////
+
+namespace {
+    bool is_open(const int fd) { return ::fcntl(fd, F_GETFD) != -1; }
+} // namespace
+
+TEST(UniqueFdTest, DefaultConstruction) {
+    const UniqueFd fd;
+    EXPECT_FALSE(fd);
+    EXPECT_EQ(fd.get(), -1);
+    EXPECT_EQ(sizeof(UniqueFd), sizeof(int));
+}
+
+TEST(UniqueFdTest, ClosesOnDestruction) {
+    int raw = -1;
+    {
+        auto fd = open_fd("/dev/null", O_RDONLY | O_CLOEXEC);
+        ASSERT_TRUE(fd);
+        raw = fd->get();
+        EXPECT_TRUE(is_open(raw));
+    }
+    EXPECT_FALSE(is_open(raw));
+}
+
+TEST(UniqueFdTest, MoveConstruction) {
+    auto fd = open_fd("/dev/null", O_RDONLY | O_CLOEXEC);
+    ASSERT_TRUE(fd);
+    const int raw = fd->get();
+    const UniqueFd moved(std::move(*fd));
+    EXPECT_EQ(moved.get(), raw);
+    EXPECT_FALSE(*fd);
+}
+
+TEST(UniqueFdTest, MoveAssignmentClosesPrevious) {
+    auto first = open_fd("/dev/null", O_RDONLY | O_CLOEXEC);
+    auto second = open_fd("/dev/null", O_RDONLY | O_CLOEXEC);
+    ASSERT_TRUE(first && second);
+    const int old = first->get();
+    const int raw = second->get();
+    *first = std::move(*second);
+    EXPECT_EQ(first->get(), raw);
+    EXPECT_FALSE(*second);
+    EXPECT_FALSE(is_open(old));
+}
+
+TEST(UniqueFdTest, Release) {
+    auto fd = open_fd("/dev/null", O_RDONLY | O_CLOEXEC);
+    ASSERT_TRUE(fd);
+    const int raw = fd->release();
+    EXPECT_FALSE(*fd);
+    EXPECT_TRUE(is_open(raw));
+    ::close(raw);
+}
+
+TEST(UniqueFdTest, ExplicitClose) {
+    auto fd = open_fd("/dev/null", O_RDONLY | O_CLOEXEC);
+    ASSERT_TRUE(fd);
+    const int raw = fd->get();
+    EXPECT_TRUE(fd->close());
+    EXPECT_FALSE(*fd);
+    EXPECT_FALSE(is_open(raw));
+    EXPECT_TRUE(fd->close()); // closing an empty handle is a no-op
+}
+
+TEST(UniqueFdTest, CloseError) {
+    UniqueFd fd(1'000'000); // Not an open descriptor
+    const auto result = fd.close();
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::bad_file_descriptor));
+    EXPECT_FALSE(fd);
+}
+
+TEST(UniqueFdTest, OpenFdError) {
+    const auto fd = open_fd("/nonexistent/error_utils/file", O_RDONLY);
+    ASSERT_FALSE(fd);
+    EXPECT_TRUE(fd.error().is(std::errc::no_such_file_or_directory));
+    EXPECT_EQ(fd.error().context(), "Opening '/nonexistent/error_utils/file'");
+}
+
+TEST(UniqueFdTest, PipeFds) {
+    auto pipe = pipe_fds();
+    ASSERT_TRUE(pipe);
+    auto &[read_end, write_end] = *pipe;
+    ASSERT_EQ(::write(write_end.get(), "ping", 4), 4);
+    char buffer[4]{};
+    EXPECT_EQ(::read(read_end.get(), buffer, sizeof(buffer)), 4);
+    EXPECT_EQ(std::string_view(buffer, 4), "ping");
+}
+
+#ifdef __linux__
+TEST(UniqueFdTest, EventfdFd) {
+    const auto fd = eventfd_fd(3);
+    ASSERT_TRUE(fd);
+    std::uint64_t value = 0;
+    EXPECT_EQ(::read(fd->get(), &value, sizeof(value)), static_cast<ssize_t>(sizeof(value)));
+    EXPECT_EQ(value, 3);
+}
+
+TEST(UniqueFdTest, MemfdFd) {
+    const auto fd = memfd_fd("error_utils_test");
+    ASSERT_TRUE(fd);
+    EXPECT_EQ(::write(fd->get(), "memfd", 5), 5);
+    struct stat st{};
+    ASSERT_EQ(::fstat(fd->get(), &st), 0);
+    EXPECT_EQ(st.st_size, 5);
+}
+#endif
+
+// ///////////////////////// Tests on MappedFile //////////////////////////////
+
+TEST(MappedFileTest, MapsFileContents) {
+    const TempFile file("hello, mapped world");
+    const auto mapped = MappedFile::open(file.path());
+    ASSERT_TRUE(mapped);
+    EXPECT_EQ(mapped->size(), 19);
+    EXPECT_EQ(mapped->view(), "hello, mapped world");
+    EXPECT_EQ(mapped->bytes().size(), 19);
+    EXPECT_EQ(mapped->bytes()[0], std::byte{'h'});
+}
+
+TEST(MappedFileTest, EmptyFile) {
+    const TempFile file;
+    const auto mapped = MappedFile::open(file.path());
+    ASSERT_TRUE(mapped);
+    EXPECT_TRUE(mapped->empty());
+    EXPECT_EQ(mapped->data(), nullptr);
+    EXPECT_TRUE(mapped->bytes().empty());
+}
+
+TEST(MappedFileTest, NonexistentFile) {
+    const auto mapped = MappedFile::open("/nonexistent/error_utils/file");
+    ASSERT_FALSE(mapped);
+    EXPECT_TRUE(mapped.error().is(std::errc::no_such_file_or_directory));
+    EXPECT_EQ(mapped.error().context(), "Opening '/nonexistent/error_utils/file'");
+}
+
+TEST(MappedFileTest, Directory) {
+    const auto dir = std::filesystem::temp_directory_path().string();
+    const auto mapped = MappedFile::open(dir);
+    ASSERT_FALSE(mapped);
+    EXPECT_TRUE(mapped.error().is(std::errc::is_a_directory));
+    EXPECT_THAT(mapped.error().context(), ::testing::HasSubstr(dir));
+}
+
+TEST(MappedFileTest, NonRegularFiles) {
+    const auto device = MappedFile::open("/dev/null");
+    ASSERT_FALSE(device);
+    EXPECT_TRUE(device.error().is(std::errc::invalid_argument));
+    EXPECT_THAT(device.error().context(), ::testing::HasSubstr("/dev/null"));
+
+    // Rejected without waiting for a writer
+    const std::string fifo = TempFile{}.path() + ".fifo";
+    ASSERT_EQ(::mkfifo(fifo.c_str(), 0600), 0);
+    const auto pipe = MappedFile::open(fifo);
+    std::filesystem::remove(fifo);
+    ASSERT_FALSE(pipe);
+    EXPECT_TRUE(pipe.error().is(std::errc::invalid_argument));
+
+#ifdef __linux__
+    // Reports a size of zero, although it is not empty
+    const auto proc = MappedFile::open("/proc/self/status");
+    ASSERT_FALSE(proc);
+    EXPECT_TRUE(proc.error().is(std::errc::invalid_argument));
+#endif
+}
+
+TEST(MappedFileTest, WithAdvice) {
+    const TempFile file("abc");
+    const auto mapped = MappedFile::open(file.path(), MapAdvice::sequential | MapAdvice::will_need |
+                                                      MapAdvice::huge_page);
+    ASSERT_TRUE(mapped);
+    EXPECT_EQ(mapped->view(), "abc");
+    EXPECT_TRUE(mapped->advise(MapAdvice::random));
+}
+
+TEST(MappedFileTest, MoveConstruction) {
+    const TempFile file("moved");
+    auto mapped = MappedFile::open(file.path());
+    ASSERT_TRUE(mapped);
+    const MappedFile moved(std::move(*mapped));
+    EXPECT_EQ(moved.view(), "moved");
+    EXPECT_TRUE(mapped->empty());
+    EXPECT_EQ(mapped->data(), nullptr);
+}
+
+TEST(MappedFileTest, MoveAssignment) {
+    const TempFile first("first");
+    const TempFile second("second");
+    auto a = MappedFile::open(first.path());
+    auto b = MappedFile::open(second.path());
+    ASSERT_TRUE(a && b);
+    *a = std::move(*b);
+    EXPECT_EQ(a->view(), "second");
+    EXPECT_TRUE(b->empty());
+}
+
+TEST(MappedFileTest, Close) {
+    const TempFile file("close me");
+    auto mapped = MappedFile::open(file.path());
+    ASSERT_TRUE(mapped);
+    EXPECT_TRUE(mapped->close());
+    EXPECT_TRUE(mapped->empty());
+    EXPECT_TRUE(mapped->close()); // closing twice is a no-op
+}
+
+// ///////////////////////// Tests on copy_file and splice_fd //////////////////////////////
+
+namespace {
+    std::string read_all(const std::string &path) {
+        std::ifstream file(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    }
+} // namespace
+
+TEST(CopyFileTest, CopiesContents) {
+    const std::string content(200'000, 'x');
+    const TempFile src(content);
+    const TempFile dst;
+
+    auto method = CopyMethod::read_write;
+    const auto copied = copy_file(src.path(), dst.path(), &method);
+    ASSERT_TRUE(copied);
+    EXPECT_EQ(*copied, content.size());
+    EXPECT_EQ(read_all(dst.path()), content);
+#ifdef __linux__
+    EXPECT_NE(method, CopyMethod::splice); // No pipe is involved
+#endif
+}
+
+TEST(CopyFileTest, EmptyFile) {
+    const TempFile src;
+    const TempFile dst("stale contents");
+    const auto copied = copy_file(src.path(), dst.path());
+    ASSERT_TRUE(copied);
+    EXPECT_EQ(*copied, 0);
+    EXPECT_TRUE(read_all(dst.path()).empty());
+}
+
+TEST(CopyFileTest, NonexistentSource) {
+    const TempFile dst;
+    const auto copied = copy_file("/nonexistent/error_utils/file", dst.path());
+    ASSERT_FALSE(copied);
+    EXPECT_TRUE(copied.error().is(std::errc::no_such_file_or_directory));
+    EXPECT_EQ(copied.error().context(), "Opening '/nonexistent/error_utils/file'");
+}
+
+TEST(CopyFileTest, RejectsSameFile) {
+    const TempFile src("data");
+    const auto same = copy_file(src.path(), src.path());
+    ASSERT_FALSE(same);
+    EXPECT_TRUE(same.error().is(std::errc::invalid_argument));
+    EXPECT_EQ(read_all(src.path()), "data");
+
+    const std::string hard_link = src.path() + ".hard";
+    const std::string symbolic_link = src.path() + ".symbolic";
+    std::filesystem::create_hard_link(src.path(), hard_link);
+    std::filesystem::create_symlink(src.path(), symbolic_link);
+    const auto through_hard_link = copy_file(src.path(), hard_link);
+    const auto through_symbolic_link = copy_file(symbolic_link, src.path());
+    std::filesystem::remove(hard_link);
+    std::filesystem::remove(symbolic_link);
+
+    ASSERT_FALSE(through_hard_link);
+    EXPECT_TRUE(through_hard_link.error().is(std::errc::invalid_argument));
+    ASSERT_FALSE(through_symbolic_link);
+    EXPECT_TRUE(through_symbolic_link.error().is(std::errc::invalid_argument));
+    EXPECT_EQ(read_all(src.path()), "data");
+}
+
+TEST(CopyFileTest, UnwritableDestination) {
+    struct Observer final : ErrorObserver {
+        int errors{};
+
+        void on_error(const std::error_code &, std::string_view, const std::source_location &) noexcept override {
+            ++errors;
+        }
+    } observer;
+
+    const TempFile src("data");
+    set_error_observer(&observer);
+    const auto copied = copy_file(src.path(), "/nonexistent/error_utils/file");
+    set_error_observer(nullptr);
+    ASSERT_FALSE(copied);
+    EXPECT_TRUE(copied.error().is(std::errc::no_such_file_or_directory));
+    EXPECT_EQ(copied.error().context(), "Creating '/nonexistent/error_utils/file'");
+    // The failure is reported once, not again when its context is rewritten
+    EXPECT_EQ(observer.errors, 1);
+}
+
+TEST(SpliceFdTest, PipeToFile) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    ASSERT_EQ(::write(fds[1], "through a pipe", 14), 14);
+    ::close(fds[1]);
+
+    const TempFile dst;
+    const int out = ::open(dst.path().c_str(), O_WRONLY);
+    ASSERT_NE(out, -1);
+
+    auto method = CopyMethod::read_write;
+    const auto moved = splice_fd(fds[0], out, 1024, &method);
+    ::close(fds[0]);
+    ::close(out);
+
+    ASSERT_TRUE(moved);
+    EXPECT_EQ(*moved, 14);
+    EXPECT_EQ(read_all(dst.path()), "through a pipe");
+#ifdef __linux__
+    EXPECT_EQ(method, CopyMethod::splice);
+#endif
+}
+
+TEST(SpliceFdTest, FileToPipe) {
+    const TempFile src("to the pipe");
+    const int in = ::open(src.path().c_str(), O_RDONLY);
+    ASSERT_NE(in, -1);
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+
+    auto method = CopyMethod::read_write;
+    const auto moved = splice_fd(in, fds[1], 1024, &method);
+    ::close(in);
+    ::close(fds[1]);
+    ASSERT_TRUE(moved);
+    EXPECT_EQ(*moved, 11);
+    EXPECT_NE(method, CopyMethod::copy_file_range);
+
+    char buffer[32]{};
+    EXPECT_EQ(::read(fds[0], buffer, sizeof(buffer)), 11);
+    EXPECT_STREQ(buffer, "to the pipe");
+    ::close(fds[0]);
+}
+
+TEST(SpliceFdTest, RespectsCount) {
+    const TempFile src("0123456789");
+    const TempFile dst;
+    const int in = ::open(src.path().c_str(), O_RDONLY);
+    const int out = ::open(dst.path().c_str(), O_WRONLY);
+    ASSERT_NE(in, -1);
+    ASSERT_NE(out, -1);
+
+    const auto moved = splice_fd(in, out, 4);
+    ::close(in);
+    ::close(out);
+    ASSERT_TRUE(moved);
+    EXPECT_EQ(*moved, 4);
+    EXPECT_EQ(read_all(dst.path()), "0123");
+}
+
+TEST(SpliceFdTest, BadDescriptor) {
+    auto method = CopyMethod::splice;
+    const auto moved = splice_fd(-1, -1, 16, &method);
+    ASSERT_FALSE(moved);
+    EXPECT_TRUE(moved.error().is(std::errc::bad_file_descriptor));
+    EXPECT_EQ(method, CopyMethod::read_write);
+}
+
+#ifdef __linux__
+TEST(SpliceFdTest, ReportsBytesMovedBeforeFailure) {
+    const std::string content(64 * 1024, 'x');
+    const TempFile src(content);
+    int fds[2];
+    ASSERT_EQ(::pipe2(fds, O_NONBLOCK), 0);
+    const int capacity = ::fcntl(fds[1], F_SETPIPE_SZ, 4096);
+    ASSERT_GT(capacity, 0);
+
+    // The read() / write() step counts a partial write before the pipe fills up
+    const int in = ::open(src.path().c_str(), O_RDONLY);
+    ASSERT_NE(in, -1);
+    std::size_t total = 0;
+    const auto step = detail::read_write_step(in, fds[1], content.size(), total);
+    ASSERT_FALSE(step);
+    EXPECT_TRUE(step.error().is(std::errc::resource_unavailable_try_again));
+    EXPECT_EQ(total, static_cast<std::size_t>(capacity));
+
+    // Drain the pipe, then let splice_fd() fill it again
+    char buffer[4096];
+    while (::read(fds[0], buffer, sizeof(buffer)) > 0) {}
+    ASSERT_EQ(::lseek(in, 0, SEEK_SET), 0);
+    const auto moved = splice_fd(in, fds[1], content.size());
+    ASSERT_FALSE(moved);
+    EXPECT_TRUE(moved.error().is(std::errc::resource_unavailable_try_again));
+    EXPECT_THAT(moved.error().context(), ::testing::EndsWith(std::format(" after {} bytes", capacity)));
+
+    ::close(in);
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+#endif
@@ -0,0 +1,231 @@
+#include <error_utils_metrics.hpp>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace error_utils;
+
+// ///////////////////////// Tests on ErrorCounters //////////////////////////////
+
+TEST(ErrorCountersTest, CountsByCode) {
+    ErrorCounters counters;
+    counters.record(std::make_error_code(std::errc::io_error));
+    counters.record(Error{std::errc::io_error, "Read failed"});
+    counters.record(make_error_code(ExtraError::bad_alloc), 3);
+
+    const auto snapshot = counters.snapshot();
+    EXPECT_EQ(snapshot.total(), 5);
+    EXPECT_EQ(snapshot.count(std::errc::io_error), 2);
+    EXPECT_EQ(snapshot.count(ExtraError::bad_alloc), 3);
+    EXPECT_EQ(snapshot.count(std::errc::timed_out), 0);
+    ASSERT_EQ(snapshot.counts().size(), 2);
+    // Sorted by category name
+    EXPECT_TRUE(snapshot.counts()[0].code == ExtraError::bad_alloc);
+}
+
+TEST(ErrorCountersTest, IgnoresSuccess) {
+    ErrorCounters counters;
+    counters.record(std::error_code{});
+    EXPECT_EQ(counters.snapshot().total(), 0);
+    EXPECT_TRUE(counters.snapshot().counts().empty());
+}
+
+TEST(ErrorCountersTest, GroupsByCondition) {
+    ErrorCounters counters;
+    counters.record(make_error_code(ExtraError::invalid_argument));
+    counters.record(make_error_code(ExtraError::length_error), 2);
+    counters.record(make_error_code(ExtraError::bad_alloc));
+    counters.record(std::make_error_code(std::errc::no_such_file_or_directory), 4);
+
+    const auto snapshot = counters.snapshot();
+    EXPECT_EQ(snapshot.count(ExtraErrorCondition::logic_error), 3);
+
+    const auto extra = snapshot.by_extra_condition();
+    EXPECT_EQ(extra[0].first, ExtraErrorCondition::logic_error);
+    EXPECT_EQ(extra[0].second, 3);
+    EXPECT_EQ(extra[2].first, ExtraErrorCondition::resource_error);
+    EXPECT_EQ(extra[2].second, 1);
+
+    const std::array conditions{std::make_error_condition(std::errc::no_such_file_or_directory),
+                                make_error_condition(ExtraErrorCondition::logic_error)};
+    EXPECT_THAT(snapshot.by_condition(conditions), ::testing::ElementsAre(4, 3));
+}
+
+TEST(ErrorCountersTest, AggregatesThreads) {
+    ErrorCounters counters;
+    {
+        std::vector<std::jthread> threads;
+        for (int t = 0; t < 8; ++t) {
+            threads.emplace_back([&counters, t] {
+                for (int i = 0; i < 10000; ++i) {
+                    counters.record(std::make_error_code(i % 2 == 0 ? std::errc::io_error : std::errc::timed_out));
+                    counters.record(std::error_code{1000 + t, std::generic_category()});
+                }
+            });
+        }
+        // Snapshots while the threads are counting
+        for (int i = 0; i < 10; ++i) {
+            EXPECT_LE(counters.snapshot().total(), 160000);
+        }
+    }
+    const auto snapshot = counters.snapshot();
+    EXPECT_EQ(snapshot.total(), 160000);
+    EXPECT_EQ(snapshot.count(std::errc::io_error), 40000);
+    EXPECT_EQ(snapshot.count(std::errc::timed_out), 40000);
+}
+
+TEST(ErrorCountersTest, CountsSurviveThreadsAndShardsAreReused) {
+    ErrorCounters counters;
+    for (int t = 0; t < 20; ++t) {
+        std::jthread{[&counters] { counters.record(std::make_error_code(std::errc::io_error)); }}.join();
+    }
+    EXPECT_EQ(counters.snapshot().count(std::errc::io_error), 20);
+}
+
+TEST(ErrorCountersTest, SeveralInstances) {
+    ErrorCounters first;
+    ErrorCounters second;
+    for (int i = 0; i < 3; ++i) {
+        first.record(std::make_error_code(std::errc::io_error));
+        second.record(std::make_error_code(std::errc::timed_out));
+    }
+    EXPECT_EQ(first.snapshot().total(), 3);
+    EXPECT_EQ(second.snapshot().count(std::errc::timed_out), 3);
+
+    {
+        ErrorCounters temporary;
+        temporary.record(std::make_error_code(std::errc::io_error));
+    }
+    first.record(std::make_error_code(std::errc::io_error));
+    EXPECT_EQ(first.snapshot().total(), 4);
+}
+
+TEST(ErrorCountersTest, OverflowIsCountedInTotal) {
+    ErrorCounters counters;
+    for (int value = 1; value <= 300; ++value) {
+        counters.record(std::error_code{value, std::system_category()});
+    }
+    const auto snapshot = counters.snapshot();
+    EXPECT_EQ(snapshot.total(), 300);
+    EXPECT_EQ(snapshot.overflow(), 300 - detail::counter_shard::capacity);
+}
+
+TEST(CountingObserverTest, CountsEveryErrorCreated) {
+    ErrorCounters counters;
+    CountingObserver observer{counters};
+    set_error_observer(&observer);
+    (void) make_error<int>(std::errc::io_error, "Failed");
+    (void) Error{ExtraError::bad_alloc};
+    (void) try_catch([]() -> int { throw std::runtime_error("Failed"); });
+    set_error_observer(nullptr);
+    (void) Error{ExtraError::bad_alloc};
+
+    const auto snapshot = counters.snapshot();
+    EXPECT_EQ(snapshot.total(), 3);
+    EXPECT_EQ(snapshot.count(ExtraErrorCondition::resource_error), 1);
+    EXPECT_EQ(snapshot.count(ExtraError::runtime_error), 1);
+}
+
+// ///////////////////////// Tests on ErrorTable //////////////////////////////
+
+TEST(ErrorTableTest, AggregatesByCodeAndContext) {
+    ErrorTable table{64};
+    for (int i = 0; i < 3; ++i) {
+        table.record(std::make_error_code(std::errc::connection_reset), "Peer A");
+    }
+    table.record(Error{std::errc::connection_reset, "Peer B"});
+    table.record(std::make_error_code(std::errc::timed_out), "Peer A");
+    table.record(std::error_code{});
+
+    const auto stats = table.snapshot();
+    ASSERT_EQ(stats.size(), 3);
+    EXPECT_EQ(stats[0].code, std::errc::connection_reset);
+    EXPECT_EQ(stats[0].context, "Peer A");
+    EXPECT_EQ(stats[0].count, 3);
+    EXPECT_LE(stats[0].first_seen, stats[0].last_seen);
+    EXPECT_EQ(stats[1].count, 1);
+    EXPECT_EQ(table.evicted(), 0);
+}
+
+TEST(ErrorTableTest, TruncatesSampleContext) {
+    ErrorTable table;
+    table.record(std::make_error_code(std::errc::io_error), std::string(200, 'x'));
+    const auto stats = table.snapshot();
+    ASSERT_EQ(stats.size(), 1);
+    EXPECT_EQ(stats[0].context, std::string(detail::aggregate_slot::context_capacity, 'x'));
+}
+
+TEST(ErrorTableTest, HalfFullWithoutEviction) {
+    ErrorTable table{4096};
+    const std::size_t distinct = table.capacity() / 2;
+    for (std::size_t i = 0; i < distinct; ++i) {
+        table.record(std::error_code{static_cast<int>(i % 64) + 1, std::generic_category()},
+                     std::format("Peer {}", i / 64));
+    }
+    EXPECT_EQ(table.evicted(), 0);
+    EXPECT_EQ(table.snapshot().size(), distinct);
+}
+
+TEST(ErrorTableTest, EvictsLeastRecentlySeen) {
+    ErrorTable table{16};
+    ASSERT_EQ(table.capacity(), 16);
+    table.record(std::make_error_code(std::errc::io_error), "Old");
+    table.record(std::make_error_code(std::errc::io_error), "Old");
+    for (int value = 1; value <= 100; ++value) {
+        table.record(std::error_code{1000 + value, std::generic_category()});
+    }
+    const auto stats = table.snapshot();
+    EXPECT_EQ(stats.size(), 16);
+    EXPECT_EQ(std::ranges::count(stats, "Old", &ErrorStat::context), 0);
+
+    std::uint64_t total = table.evicted();
+    for (const auto &stat : stats) {
+        total += stat.count;
+    }
+    EXPECT_EQ(total, 102);
+}
+
+TEST(ErrorTableTest, ConcurrentRecords) {
+    ErrorTable table;
+    {
+        std::vector<std::jthread> threads;
+        for (int t = 0; t < 8; ++t) {
+            threads.emplace_back([&table, t] {
+                for (int i = 0; i < 10000; ++i) {
+                    table.record(std::make_error_code(std::errc::connection_reset), "Shared");
+                    table.record(std::error_code{1000 + i % 100, std::generic_category()}, "Spread");
+                    table.record(std::make_error_code(std::errc::io_error), t % 2 == 0 ? "Even" : "Odd");
+                }
+            });
+        }
+        // Snapshots while the threads are recording
+        for (int i = 0; i < 10; ++i) {
+            EXPECT_LE(table.snapshot().size(), 103);
+        }
+    }
+    const auto stats = table.snapshot();
+    EXPECT_EQ(stats.size(), 103);
+    EXPECT_EQ(stats[0].count, 80000);
+    EXPECT_EQ(stats[0].context, "Shared");
+    EXPECT_EQ(stats[1].count, 40000);
+    EXPECT_EQ(stats[2].count, 40000);
+    EXPECT_EQ(stats.back().count, 800);
+}
+
+TEST(ErrorTableTest, RecordsAsErrorObserver) {
+    ErrorTable table;
+    set_error_observer(&table);
+    (void) make_error<int>(std::errc::io_error, "Failed");
+    (void) make_error<int>(std::errc::io_error, "Failed");
+    set_error_observer(nullptr);
+
+    const auto stats = table.snapshot();
+    ASSERT_EQ(stats.size(), 1);
+    EXPECT_EQ(stats[0].count, 2);
+}
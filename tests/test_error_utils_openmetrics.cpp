@@ -0,0 +1,145 @@
+#include <error_utils_openmetrics.hpp>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace error_utils;
+
+// ///////////////////////// Tests on OpenMetricsExporter //////////////////////////////
+
+namespace {
+    // Renders a whole scrape through buffers of the given size.
+    std::string render_all(OpenMetricsExporter &exporter, const std::size_t buffer_size) {
+        std::string output;
+        std::string buffer(buffer_size, '\0');
+        exporter.begin();
+        while (!exporter.done()) {
+            const auto size = exporter.render(buffer);
+            if (!size) {
+                ADD_FAILURE() << size.error().message();
+                break;
+            }
+            output.append(buffer, 0, *size);
+        }
+        return output;
+    }
+
+    std::string temporary_path(const std::string_view name) {
+        return std::format("/tmp/error_utils_{}_{}", ::getpid(), name);
+    }
+} // namespace
+
+TEST(OpenMetricsExporterTest, RendersCounts) {
+    ErrorCounters counters;
+    counters.record(std::make_error_code(std::errc::io_error), 3);
+    counters.record(make_error_code(ExtraError::bad_alloc));
+
+    OpenMetricsExporter exporter{counters, "app_errors"};
+    const std::string expected = std::format(
+        "# TYPE app_errors counter\n"
+        "# HELP app_errors Errors recorded, by error code.\n"
+        "app_errors_total{{category=\"ExtraError\",value=\"{}\",condition=\"resource_error\"}} 1\n"
+        "app_errors_total{{category=\"generic\",value=\"{}\",condition=\"generic:{}\"}} 3\n"
+        "# TYPE app_errors_uncounted counter\n"
+        "# HELP app_errors_uncounted Errors recorded without their code, past the distinct codes of a thread.\n"
+        "app_errors_uncounted_total 0\n"
+        "# EOF\n",
+        static_cast<int>(ExtraError::bad_alloc), EIO, EIO);
+    EXPECT_EQ(render_all(exporter, 4096), expected);
+}
+
+TEST(OpenMetricsExporterTest, RendersIncrementally) {
+    ErrorCounters counters;
+    for (int value = 1; value <= 50; ++value) {
+        counters.record(std::error_code{value, std::system_category()}, value);
+    }
+    OpenMetricsExporter exporter{counters};
+    const std::string whole = render_all(exporter, 1 << 16);
+    EXPECT_EQ(render_all(exporter, 128), whole);
+    EXPECT_THAT(whole, ::testing::HasSubstr("errors_total{category=\"system\",value=\"50\""));
+    EXPECT_THAT(whole, ::testing::EndsWith("# EOF\n"));
+
+    // Counts recorded during a scrape are left to the next one
+    exporter.begin();
+    counters.record(std::make_error_code(std::errc::io_error));
+    std::string buffer(1 << 16, '\0');
+    EXPECT_EQ(std::string_view(buffer.data(), *exporter.render(buffer)), whole);
+    EXPECT_TRUE(exporter.done());
+    EXPECT_EQ(*exporter.render(buffer), 0);
+}
+
+TEST(OpenMetricsExporterTest, BufferTooSmall) {
+    ErrorCounters counters;
+    OpenMetricsExporter exporter{counters};
+    exporter.begin();
+    std::array<char, 8> buffer{};
+    const auto size = exporter.render(buffer);
+    ASSERT_FALSE(size);
+    EXPECT_TRUE(size.error().is(std::errc::no_buffer_space));
+}
+
+TEST(OpenMetricsExporterTest, WritesToFile) {
+    ErrorCounters counters;
+    counters.record(std::make_error_code(std::errc::timed_out));
+    OpenMetricsExporter exporter{counters};
+
+    const std::string path = temporary_path("metrics.prom");
+    ASSERT_TRUE(exporter.write_file(path));
+    std::ifstream file{path};
+    std::stringstream contents;
+    contents << file.rdbuf();
+    EXPECT_EQ(contents.str(), render_all(exporter, 4096));
+    std::remove(path.c_str());
+
+    EXPECT_FALSE(exporter.write_file("/nonexistent/metrics.prom"));
+}
+
+TEST(OpenMetricsExporterTest, ServesUnixSocket) {
+    ErrorCounters counters;
+    counters.record(std::make_error_code(std::errc::connection_reset), 2);
+    OpenMetricsExporter exporter{counters};
+
+    const std::string path = temporary_path("metrics.sock");
+    auto listening = listen_unix(path);
+    ASSERT_TRUE(listening);
+
+    std::jthread server{[&] { EXPECT_TRUE(exporter.serve_once(listening->get())); }};
+
+    const UniqueFd client{::socket(AF_UNIX, SOCK_STREAM, 0)};
+    ::sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.data(), path.size());
+    ASSERT_EQ(::connect(client.get(), reinterpret_cast<const ::sockaddr *>(&address), sizeof(address)), 0);
+    constexpr std::string_view request = "GET /metrics HTTP/1.0\r\n\r\n";
+    ASSERT_EQ(::write(client.get(), request.data(), request.size()), static_cast<ssize_t>(request.size()));
+
+    std::string response;
+    std::array<char, 1024> buffer{};
+    for (ssize_t count; (count = ::read(client.get(), buffer.data(), buffer.size())) > 0;) {
+        response.append(buffer.data(), static_cast<std::size_t>(count));
+    }
+    server.join();
+    ::unlink(path.c_str());
+
+    EXPECT_THAT(response, ::testing::StartsWith("HTTP/1.0 200 OK\r\n"));
+    EXPECT_THAT(response, ::testing::HasSubstr("application/openmetrics-text"));
+    EXPECT_THAT(response, ::testing::HasSubstr(std::format("value=\"{}\"", ECONNRESET)));
+    EXPECT_THAT(response, ::testing::EndsWith("# EOF\n"));
+}
+
+TEST(OpenMetricsExporterTest, EscapesLabels) {
+    std::array<char, 64> buffer{};
+    detail::metrics_appender out{buffer};
+    out.append_label("a\"b\\c\nd");
+    EXPECT_EQ(std::string_view(buffer.data(), out.size()), R"(a\"b\\c\nd)");
+}
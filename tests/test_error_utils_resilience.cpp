@@ -0,0 +1,325 @@
+#include <error_utils_resilience.hpp>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <stdexcept>
+
+using namespace error_utils;
+using namespace std::chrono_literals;
+
+// ///////////////////////// Tests on retry //////////////////////////////
+
+namespace {
+    // Fails with `code` for the first `failures` calls, then succeeds.
+    struct Flaky {
+        int failures;
+        std::error_code code;
+        int calls = 0;
+
+        IntResult operator()() {
+            if (calls++ < failures) {
+                return make_error<int>(code, "Flaky failure");
+            }
+            return calls;
+        }
+    };
+
+    RetryPolicy fast_policy() {
+        return RetryPolicy{}.max_attempts(5).initial_delay(1ms).max_delay(2ms);
+    }
+} // namespace
+
+TEST(RetryTest, SucceedsAfterTransientErrors) {
+    Flaky flaky{2, std::make_error_code(std::errc::resource_unavailable_try_again)};
+    RetryStats stats;
+    const auto result = retry(fast_policy(), flaky, &stats);
+
+    ASSERT_TRUE(result);
+    EXPECT_EQ(*result, 3);
+    EXPECT_EQ(stats.attempts, 3);
+    EXPECT_EQ(stats.stop, RetryStop::succeeded);
+    EXPECT_GE(stats.waited, 2ms);
+}
+
+TEST(RetryTest, SuccessOnFirstAttemptDoesNotWait) {
+    RetryStats stats;
+    const auto result = retry(fast_policy(), [] { return IntResult{1}; }, &stats);
+
+    ASSERT_TRUE(result);
+    EXPECT_EQ(stats.attempts, 1);
+    EXPECT_EQ(stats.waited, 0ns);
+}
+
+TEST(RetryTest, AttemptsExhausted) {
+    Flaky flaky{10, std::make_error_code(std::errc::io_error)};
+    RetryStats stats;
+    const auto result = retry(fast_policy().max_attempts(3), flaky, &stats);
+
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(std::errc::io_error));
+    EXPECT_EQ(flaky.calls, 3);
+    EXPECT_EQ(stats.stop, RetryStop::attempts_exhausted);
+}
+
+TEST(RetryTest, RetriesOnlyMatchingErrors) {
+    const auto policy = fast_policy()
+        .retry_on(ExtraErrorCondition::resource_error, std::errc::resource_unavailable_try_again)
+        .never_on(ExtraErrorCondition::logic_error);
+
+    Flaky again{1, std::make_error_code(std::errc::resource_unavailable_try_again)};
+    EXPECT_TRUE(retry(policy, again));
+
+    Flaky no_memory{1, make_error_code(ExtraError::bad_alloc)};
+    EXPECT_TRUE(retry(policy, no_memory));
+
+    RetryStats stats;
+    Flaky logic{1, make_error_code(ExtraError::invalid_argument)};
+    EXPECT_FALSE(retry(policy, logic, &stats));
+    EXPECT_EQ(logic.calls, 1);
+    EXPECT_EQ(stats.stop, RetryStop::not_retryable);
+
+    Flaky io{1, std::make_error_code(std::errc::io_error)};
+    EXPECT_FALSE(retry(policy, io));
+    EXPECT_EQ(io.calls, 1);
+}
+
+TEST(RetryTest, NeverOnWinsOverRetryOn) {
+    const auto policy = fast_policy().retry_on(std::errc::io_error).never_on(std::errc::io_error);
+    Flaky flaky{1, std::make_error_code(std::errc::io_error)};
+    EXPECT_FALSE(retry(policy, flaky));
+    EXPECT_EQ(flaky.calls, 1);
+}
+
+TEST(RetryTest, DeadlineStopsRetries) {
+    const auto policy = RetryPolicy{}.max_attempts(100).initial_delay(20ms).max_delay(20ms)
+                                     .jitter(Jitter::none).timeout(50ms);
+    Flaky flaky{1000, std::make_error_code(std::errc::io_error)};
+    RetryStats stats;
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = retry(policy, flaky, &stats);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    ASSERT_FALSE(result);
+    EXPECT_EQ(stats.stop, RetryStop::deadline_exceeded);
+    EXPECT_LT(stats.attempts, 5);
+    EXPECT_LT(elapsed, 50ms);
+}
+
+TEST(RetryPolicyTest, ExponentialBackoff) {
+    const auto policy = RetryPolicy{}.initial_delay(10ms).max_delay(50ms).multiplier(2.0).jitter(Jitter::none);
+    std::minstd_rand generator{1};
+
+    std::chrono::nanoseconds delay{};
+    std::vector<std::chrono::nanoseconds> delays;
+    for (int i = 0; i < 5; ++i) {
+        delay = policy.next_delay(delay, generator);
+        delays.push_back(delay);
+    }
+    EXPECT_THAT(delays, ::testing::ElementsAre(10ms, 20ms, 40ms, 50ms, 50ms));
+}
+
+TEST(RetryPolicyTest, DecorrelatedJitterStaysInBounds) {
+    const auto policy = RetryPolicy{}.initial_delay(10ms).max_delay(100ms).jitter(Jitter::decorrelated);
+    std::minstd_rand generator{42};
+
+    std::chrono::nanoseconds delay{};
+    for (int i = 0; i < 1000; ++i) {
+        const auto next = policy.next_delay(delay, generator);
+        EXPECT_GE(next, 10ms);
+        EXPECT_LE(next, 100ms);
+        EXPECT_LE(next, std::max<std::chrono::nanoseconds>(delay, 10ms) * 3);
+        delay = next;
+    }
+}
+
+TEST(RetryPolicyTest, FullJitterStaysInBounds) {
+    const auto policy = RetryPolicy{}.initial_delay(10ms).max_delay(100ms).jitter(Jitter::full);
+    std::minstd_rand generator{7};
+    for (int i = 0; i < 1000; ++i) {
+        const auto next = policy.next_delay(20ms, generator);
+        EXPECT_GE(next, 0ms);
+        EXPECT_LE(next, 40ms);
+    }
+}
+
+TEST(RetryPolicyTest, FullJitterBoundGrowsExponentially) {
+    const auto policy = RetryPolicy{}.initial_delay(1ms).max_delay(100ms).jitter(Jitter::full);
+    std::minstd_rand generator{3};
+
+    // The bound grows from the un-jittered delay, whatever the draws were
+    double sum_of_last = 0;
+    for (int run = 0; run < 1000; ++run) {
+        RetryBackoff backoff{};
+        std::chrono::nanoseconds bound = 1ms;
+        std::chrono::nanoseconds delay{};
+        for (int step = 0; step < 9; ++step) {
+            delay = policy.next_delay(backoff, generator);
+            EXPECT_EQ(backoff.ceiling, bound);
+            EXPECT_LE(delay, bound);
+            bound = std::min<std::chrono::nanoseconds>(bound * 2, 100ms);
+        }
+        sum_of_last += std::chrono::duration<double, std::milli>(delay).count();
+    }
+    // The last delays are uniform in [0, 100ms]
+    EXPECT_GT(sum_of_last / 1000, 40.0);
+    EXPECT_LT(sum_of_last / 1000, 60.0);
+}
+
+// ///////////////////////// Tests on CircuitBreaker //////////////////////////////
+
+namespace {
+    IntResult succeed() { return 1; }
+
+    IntResult fail_with(const std::errc code) { return make_error<int>(std::make_error_code(code), "Failed"); }
+
+    CircuitPolicy small_policy() {
+        return CircuitPolicy{}.window(10s, 10).failure_ratio(0.5).minimum_calls(4).open_for(50ms);
+    }
+} // namespace
+
+TEST(CircuitBreakerTest, StartsClosed) {
+    CircuitBreaker breaker{small_policy()};
+    EXPECT_EQ(breaker.state(), CircuitState::closed);
+    EXPECT_TRUE(breaker.call(succeed));
+    EXPECT_EQ(breaker.counts().successes, 1);
+    EXPECT_EQ(breaker.counts().failures, 0);
+}
+
+TEST(CircuitBreakerTest, OpensAndFailsFast) {
+    CircuitBreaker breaker{small_policy()};
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_FALSE(breaker.call([] { return fail_with(std::errc::io_error); }));
+    }
+    EXPECT_EQ(breaker.state(), CircuitState::open);
+
+    int calls = 0;
+    const auto result = breaker.call([&calls] {
+        ++calls;
+        return succeed();
+    });
+    ASSERT_FALSE(result);
+    EXPECT_TRUE(result.error().is(ResilienceError::circuit_open));
+    EXPECT_TRUE(result.error().is(ExtraErrorCondition::resource_error));
+    EXPECT_EQ(calls, 0);
+}
+
+TEST(CircuitBreakerTest, NeedsMinimumCalls) {
+    CircuitBreaker breaker{small_policy()};
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_FALSE(breaker.call([] { return fail_with(std::errc::io_error); }));
+    }
+    EXPECT_EQ(breaker.state(), CircuitState::closed);
+}
+
+TEST(CircuitBreakerTest, StaysClosedBelowRatio) {
+    CircuitBreaker breaker{small_policy()};
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(breaker.call(succeed));
+    }
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_FALSE(breaker.call([] { return fail_with(std::errc::io_error); }));
+    }
+    EXPECT_EQ(breaker.state(), CircuitState::closed);
+    EXPECT_EQ(breaker.counts().failures, 4);
+}
+
+TEST(CircuitBreakerTest, CountsOnlyTrippingErrors) {
+    CircuitBreaker breaker{small_policy().trip_on(std::errc::timed_out, ExtraErrorCondition::resource_error)};
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_FALSE(breaker.call([] { return fail_with(std::errc::invalid_argument); }));
+    }
+    EXPECT_EQ(breaker.state(), CircuitState::closed);
+    EXPECT_EQ(breaker.counts().failures, 0);
+
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_FALSE(breaker.call([] { return fail_with(std::errc::timed_out); }));
+    }
+    EXPECT_EQ(breaker.state(), CircuitState::open);
+}
+
+TEST(CircuitBreakerTest, ProbeClosesCircuit) {
+    CircuitBreaker breaker{small_policy()};
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_FALSE(breaker.call([] { return fail_with(std::errc::io_error); }));
+    }
+    ASSERT_EQ(breaker.state(), CircuitState::open);
+
+    std::this_thread::sleep_for(60ms);
+    EXPECT_TRUE(breaker.call(succeed));
+    EXPECT_EQ(breaker.state(), CircuitState::closed);
+
+    // The failures that opened the circuit are forgotten
+    EXPECT_EQ(breaker.counts().failures, 0);
+    EXPECT_FALSE(breaker.call([] { return fail_with(std::errc::io_error); }));
+    EXPECT_EQ(breaker.state(), CircuitState::closed);
+}
+
+TEST(CircuitBreakerTest, FailedProbeReopensCircuit) {
+    CircuitBreaker breaker{small_policy()};
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_FALSE(breaker.call([] { return fail_with(std::errc::io_error); }));
+    }
+    std::this_thread::sleep_for(60ms);
+    EXPECT_FALSE(breaker.call([] { return fail_with(std::errc::io_error); }));
+    EXPECT_EQ(breaker.state(), CircuitState::open);
+    EXPECT_TRUE(breaker.call(succeed).error().is(ResilienceError::circuit_open));
+}
+
+TEST(CircuitBreakerTest, ThrowingProbeReopensCircuit) {
+    CircuitBreaker breaker{small_policy()};
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_FALSE(breaker.call([] { return fail_with(std::errc::io_error); }));
+    }
+    std::this_thread::sleep_for(60ms);
+    EXPECT_THROW((void) breaker.call([]() -> IntResult { throw std::runtime_error("Probe failed"); }),
+                 std::runtime_error);
+    EXPECT_EQ(breaker.state(), CircuitState::open);
+
+    // The next probe goes through once the delay has elapsed again
+    std::this_thread::sleep_for(60ms);
+    EXPECT_TRUE(breaker.call(succeed));
+    EXPECT_EQ(breaker.state(), CircuitState::closed);
+}
+
+TEST(CircuitBreakerTest, ThrowingCallsCountAsFailures) {
+    CircuitBreaker breaker{small_policy()};
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_THROW((void) breaker.call([]() -> IntResult { throw std::runtime_error("Failed"); }),
+                     std::runtime_error);
+    }
+    EXPECT_EQ(breaker.state(), CircuitState::open);
+}
+
+TEST(CircuitBreakerTest, InFlightFailuresDoNotDelayProbe) {
+    CircuitBreaker breaker{small_policy()};
+    // A call in flight while the circuit opens, failing 30ms after it opened
+    EXPECT_FALSE(breaker.call([&breaker] {
+        for (int i = 0; i < 4; ++i) {
+            EXPECT_FALSE(breaker.call([] { return fail_with(std::errc::io_error); }));
+        }
+        EXPECT_EQ(breaker.state(), CircuitState::open);
+        std::this_thread::sleep_for(30ms);
+        return fail_with(std::errc::io_error);
+    }));
+
+    // 60ms after the circuit opened, the probe is let through
+    std::this_thread::sleep_for(30ms);
+    EXPECT_TRUE(breaker.call(succeed));
+    EXPECT_EQ(breaker.state(), CircuitState::closed);
+}
+
+TEST(CircuitBreakerTest, ConcurrentCalls) {
+    CircuitBreaker breaker{CircuitPolicy{}.minimum_calls(1000000)};
+    std::vector<std::jthread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&breaker] {
+            for (int i = 0; i < 10000; ++i) {
+                (void) breaker.call(i % 2 == 0 ? succeed : [] { return fail_with(std::errc::io_error); });
+            }
+        });
+    }
+    threads.clear();
+    EXPECT_EQ(breaker.counts().successes, 20000);
+    EXPECT_EQ(breaker.counts().failures, 20000);
+}